@@ -0,0 +1,112 @@
+// Compares the exprtk node tree against the bytecode VM and the x86-64 JIT on the README example
+// expressions. Reports time per evaluation for each backend, the speedup over exprtk, and how many
+// samples differ bit-for-bit from exprtk (expected: 0).
+#include "../include/exprtk.hpp"
+#include "../include/bytecode.hpp"
+#include "../include/jit.hpp"
+#include "../include/termcolor.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace termcolor;
+
+namespace {
+    constexpr double PI_CONST = 3.14159265358979323846;
+    constexpr double E_CONST  = 2.71828182845904523536;
+    constexpr std::size_t SAMPLE_COUNT = 4096; // Small enough to stay in L1/L2, so we time evaluation, not memory
+    constexpr int REPEATS = 256;
+
+    double cbrtImpl(double v) { return std::cbrt(v); }
+
+    template <typename F>
+    double nanosecondsPerSample(F&& body) {
+        const auto start = chrono::steady_clock::now();
+        for (int r = 0; r < REPEATS; ++r) body();
+        const auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        return elapsed / (static_cast<double>(SAMPLE_COUNT) * REPEATS);
+    }
+
+    bool sameBits(double a, double b) {
+        if (std::isnan(a) && std::isnan(b)) return true;
+        return std::memcmp(&a, &b, sizeof(double)) == 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    vector<string> expressions = {
+        "sin(x) + log(x^2)",
+        "x^2",
+        "sin(x)",
+        "5+4*8-sin(pi/2)+pow(2,3)",
+        "x^5-3*x^3+2*x-1",
+        "exp(-x^2/2)*cos(3x)",
+        "sqrt(abs(x))*tan(x/7)+cbrt(x)"
+    };
+    for (int i = 1; i < argc; ++i) expressions.push_back(argv[i]); // Extra expressions from the command line
+
+    vector<double> xs(SAMPLE_COUNT), yTree(SAMPLE_COUNT), yScalar(SAMPLE_COUNT), yBlock(SAMPLE_COUNT), yJit(SAMPLE_COUNT);
+    for (std::size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        xs[i] = -10.0 + 20.0 * static_cast<double>(i) / static_cast<double>(SAMPLE_COUNT - 1);
+    }
+
+    double x = 0.0;
+    exprtk::symbol_table<double> symbolTable;
+    symbolTable.add_variable("x", x);
+    symbolTable.add_constant("pi", PI_CONST);
+    symbolTable.add_constant("e", E_CONST);
+    symbolTable.add_function("cbrt", cbrtImpl);
+    exprtk::parser<double> parser;
+
+    cout << bold << bright_cyan << left << setw(34) << "expression" << right << setw(12) << "exprtk ns"
+         << setw(10) << "vm ns" << setw(10) << "block ns" << setw(10) << "jit ns" << setw(9) << "vm x"
+         << setw(9) << "block x" << setw(9) << "jit x" << setw(12) << "mismatches" << reset << endl;
+
+    for (const string& exprStr : expressions) {
+        exprtk::expression<double> expression;
+        expression.register_symbol_table(symbolTable);
+        if (!parser.compile(exprStr, expression)) {
+            cerr << red << exprStr << ": " << parser.error() << reset << endl;
+            continue;
+        }
+        const optional<BytecodeProgram> program = compileToBytecode(exprStr);
+        if (!program) {
+            cout << yellow << left << setw(34) << exprStr << "not supported by the bytecode backend" << reset << endl;
+            continue;
+        }
+        BytecodeVM vm;
+        vm.load(*program);
+        const unique_ptr<JitFunction> jit = JitFunction::compile(*program);
+
+        const double treeNs = nanosecondsPerSample([&] {
+            for (std::size_t i = 0; i < SAMPLE_COUNT; ++i) { x = xs[i]; yTree[i] = expression.value(); }
+        });
+        const double scalarNs = nanosecondsPerSample([&] {
+            for (std::size_t i = 0; i < SAMPLE_COUNT; ++i) yScalar[i] = vm.evaluate(xs[i]);
+        });
+        const double blockNs = nanosecondsPerSample([&] {
+            for (std::size_t i = 0; i < SAMPLE_COUNT; i += BytecodeVM::BLOCK_LANES) {
+                vm.evaluateBlock(xs.data() + i, yBlock.data() + i, std::min(BytecodeVM::BLOCK_LANES, SAMPLE_COUNT - i));
+            }
+        });
+        const double jitNs = jit ? nanosecondsPerSample([&] { jit->evaluate(xs.data(), yJit.data(), SAMPLE_COUNT); }) : NAN;
+        if (!jit) yJit = yTree; // No JIT on this platform: nothing to compare
+
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < SAMPLE_COUNT; ++i) {
+            if (!sameBits(yTree[i], yScalar[i]) || !sameBits(yTree[i], yBlock[i]) || !sameBits(yTree[i], yJit[i])) ++mismatches;
+        }
+
+        cout << left << setw(34) << exprStr << right << fixed << setprecision(2)
+             << setw(12) << treeNs << setw(10) << scalarNs << setw(10) << blockNs << setw(10) << jitNs
+             << setw(9) << treeNs / scalarNs << setw(9) << treeNs / blockNs << setw(9) << treeNs / jitNs;
+        if (mismatches) cout << red; else cout << green;
+        cout << setw(12) << mismatches << reset << endl;
+    }
+    return 0;
+}
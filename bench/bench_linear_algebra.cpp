@@ -0,0 +1,116 @@
+// GFLOP/s of the blocked matrix multiply against a textbook triple loop, on one thread and on all of
+// them, and of the LU and Cholesky factorizations built on it. The peak printed at the top is an
+// estimate from /proc/cpuinfo: 16 double flops per cycle and core (two 4-wide FMA units) with AVX2.
+// Sizes may be given on the command line; the default runs 128 to 2048.
+#include "../include/linear_algebra.hpp"
+#include "../include/termcolor.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace termcolor;
+
+namespace {
+    constexpr std::size_t NAIVE_LIMIT = 1024; // The triple loop takes too long beyond this
+    constexpr double MIN_SECONDS = 0.2;       // Each measurement repeats until it has run this long
+
+    Matrix randomMatrix(std::size_t n, std::mt19937_64& generator) {
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        Matrix result(n, n);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = 0; j < n; ++j) result(i, j) = uniform(generator);
+        }
+        return result;
+    }
+
+    // i-p-j order, so the inner loop runs along rows of b and c
+    void naiveMultiply(const Matrix& a, const Matrix& b, Matrix& c) {
+        for (std::size_t i = 0; i < a.rows(); ++i) {
+            for (std::size_t p = 0; p < a.cols(); ++p) {
+                const double factor = a(i, p);
+                for (std::size_t j = 0; j < b.cols(); ++j) c(i, j) += factor * b(p, j);
+            }
+        }
+    }
+
+    // Best GFLOP/s over repeats of body, which does flops operations after setup
+    template <typename Setup, typename Body>
+    double gigaflops(double flops, Setup&& setup, Body&& body) {
+        double best = INFINITY, total = 0.0;
+        while (total < MIN_SECONDS) {
+            setup();
+            const auto start = chrono::steady_clock::now();
+            body();
+            const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            best = std::min(best, seconds);
+            total += seconds;
+        }
+        return flops / best * 1e-9;
+    }
+
+    // Average "cpu MHz" of /proc/cpuinfo, or 0 where there is none
+    double cpuMegahertz() {
+        ifstream cpuinfo("/proc/cpuinfo");
+        string line;
+        double sum = 0.0;
+        int count = 0;
+        while (getline(cpuinfo, line)) {
+            if (line.rfind("cpu MHz", 0) != 0) continue;
+            sum += std::atof(line.c_str() + line.find(':') + 1);
+            ++count;
+        }
+        return count > 0 ? sum / count : 0.0;
+    }
+}
+
+int main(int argc, char** argv) {
+    vector<std::size_t> sizes = {128, 256, 512, 1024, 2048};
+    if (argc > 1) sizes.clear();
+    for (int i = 1; i < argc; ++i) sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+    const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    const double megahertz = cpuMegahertz();
+
+    cout << bold << bright_cyan << "kernel " << matrixKernelName() << ", " << threads << (threads == 1 ? " thread" : " threads");
+    if (megahertz > 0.0) {
+        const double flopsPerCycle = cpuHasAvx2Fma() ? 16.0 : 4.0; // AVX2 FMA, or SSE2 multiply + add
+        cout << ", estimated peak " << fixed << setprecision(1) << megahertz * 1e-3 * flopsPerCycle << " GFLOP/s per core, "
+             << megahertz * 1e-3 * flopsPerCycle * threads << " in all";
+    }
+    cout << reset << endl;
+    cout << bold << bright_cyan << right << setw(6) << "n" << setw(12) << "naive" << setw(12) << "gemm 1t" << setw(12) << "gemm all"
+         << setw(12) << "LU" << setw(12) << "Cholesky" << "   (GFLOP/s)" << reset << endl;
+
+    std::mt19937_64 generator(42);
+    for (const std::size_t n : sizes) {
+        if (n == 0) continue;
+        const double cube = static_cast<double>(n) * static_cast<double>(n) * static_cast<double>(n);
+        const Matrix a = randomMatrix(n, generator), b = randomMatrix(n, generator);
+        Matrix spd = Matrix::identity(n); // a a^T + n I
+        multiplyAdd(a.view(), a.view().transposed(), spd.view(), 1.0, threads);
+        for (std::size_t i = 0; i < n; ++i) spd(i, i) *= static_cast<double>(n);
+
+        Matrix c(n, n), factor;
+        auto clear = [&] { c = Matrix(n, n); };
+        const double naive = n <= NAIVE_LIMIT ? gigaflops(2.0 * cube, clear, [&] { naiveMultiply(a, b, c); }) : NAN;
+        const double single = gigaflops(2.0 * cube, clear, [&] { multiplyAdd(a.view(), b.view(), c.view(), 1.0, 1); });
+        const double all = gigaflops(2.0 * cube, clear, [&] { multiplyAdd(a.view(), b.view(), c.view(), 1.0, threads); });
+        const double lu = gigaflops(2.0 * cube / 3.0, [] {}, [&] { (void)luDecompose(a, threads); });
+        const double cholesky = gigaflops(cube / 3.0, [&] { factor = spd; }, [&] { (void)choleskyInPlace(factor, threads); });
+
+        cout << right << setw(6) << n << fixed << setprecision(1);
+        for (const double rate : {naive, single, all, lu, cholesky}) {
+            if (std::isnan(rate)) cout << setw(12) << "-";
+            else cout << setw(12) << rate;
+        }
+        cout << endl;
+    }
+    return 0;
+}
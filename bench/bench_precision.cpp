@@ -0,0 +1,139 @@
+// Throughput and accuracy of the precision engines (float, double, long double, quad with
+// MATHD_QUADMATH, and multi) on the two paths they serve: sampling a graph and summing a series.
+// Errors are measured against a MultiFloat two limbs wider than multi and shown as correct
+// significant digits.
+// All engines here are exprtk trees over their scalar type; the calculator's double precision
+// normally runs on the bytecode VM or the JIT instead (see bench_backends).
+#include "../include/precision_engine.hpp"
+#include "../include/termcolor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace termcolor;
+
+namespace {
+    constexpr std::size_t SAMPLE_COUNT = 4096; // Graph samples per run
+    constexpr int REPEATS = 16;
+    constexpr long long SERIES_TERMS = 200000;
+
+    using Reference = MultiFloat<MATHD_MULTI_LIMBS + 2>;
+
+    struct Row {
+        double nanoseconds; // Per sample or per term
+        double digits;      // Correct significant digits, worst case over the run
+    };
+
+    template <typename Scalar>
+    Reference toReference(const Scalar& value) {
+#ifdef MATHD_QUADMATH
+        // Float128 converts to built-in types only: three doubles hold all 113 bits
+        if constexpr (std::is_same_v<Scalar, Float128>) {
+            Reference result(0);
+            Float128 rest = value;
+            for (int part = 0; part < 3; ++part) {
+                const double high = static_cast<double>(rest);
+                result += Reference(high);
+                rest -= Float128(high);
+            }
+            return result;
+        } else
+#endif
+        return Reference(value);
+    }
+
+    // -log10 of the relative error of value against reference, capped at the reference's own digits
+    template <typename Scalar>
+    double correctDigits(const Scalar& value, const Reference& reference) {
+        using std::abs;
+        using std::log10;
+        const Reference error = abs(toReference(value) - reference);
+        const double cap = std::numeric_limits<Reference>::digits10;
+        if (error == Reference(0)) return cap;
+        const Reference scale = std::max(abs(reference), std::numeric_limits<Reference>::min());
+        return std::min(cap, -static_cast<double>(log10(error / scale)));
+    }
+
+    template <typename F>
+    double nanoseconds(std::size_t operations, F&& body) {
+        const auto start = chrono::steady_clock::now();
+        body();
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / static_cast<double>(operations);
+    }
+
+    template <typename Scalar>
+    Row benchPlot(const string& exprStr, const vector<double>& xs, const vector<Reference>& reference) {
+        PrecisionEngine<Scalar> engine;
+        if (!engine.compile(exprStr)) return {NAN, NAN};
+        vector<Scalar> ys(xs.size());
+        const double ns = nanoseconds(xs.size() * REPEATS, [&] {
+            for (int r = 0; r < REPEATS; ++r) {
+                for (std::size_t i = 0; i < xs.size(); ++i) ys[i] = engine.evaluate(Scalar(xs[i]));
+            }
+        });
+        double digits = std::numeric_limits<Reference>::digits10;
+        for (std::size_t i = 0; i < xs.size(); ++i) {
+            using std::isfinite;
+            if (isfinite(reference[i])) digits = std::min(digits, correctDigits(ys[i], reference[i]));
+        }
+        return {ns, digits};
+    }
+
+    template <typename Scalar>
+    Row benchSeries(const string& exprStr, const Reference& reference) {
+        PrecisionEngine<Scalar> engine;
+        if (!engine.compile(exprStr)) return {NAN, NAN};
+        Scalar sum(0);
+        const double ns = nanoseconds(SERIES_TERMS, [&] { sum = engine.sum(1, SERIES_TERMS); });
+        return {ns, correctDigits(sum, reference)};
+    }
+
+    void printRow(const string& label, const char* precision, const Row& row) {
+        cout << left << setw(34) << label << setw(13) << precision << right << fixed << setprecision(1)
+             << setw(10) << row.nanoseconds << setw(10) << row.digits << reset << endl;
+    }
+
+    template <typename Bench>
+    void benchEveryPrecision(const string& label, Bench&& bench) {
+        printRow(label, precisionName(Precision::Float), bench(static_cast<float*>(nullptr)));
+        printRow(label, precisionName(Precision::Double), bench(static_cast<double*>(nullptr)));
+        printRow(label, precisionName(Precision::LongDouble), bench(static_cast<long double*>(nullptr)));
+#ifdef MATHD_QUADMATH
+        printRow(label, precisionName(Precision::Quad), bench(static_cast<Float128*>(nullptr)));
+#endif
+        printRow(label, precisionName(Precision::Multi), bench(static_cast<MultiPrecisionFloat*>(nullptr)));
+    }
+}
+
+int main() {
+    const vector<string> plotExpressions = {"sin(x) + log(x^2)", "x^5-3*x^3+2*x-1", "exp(-x^2/2)*cos(3x)", "sqrt(abs(x))*tan(x/7)+cbrt(x)"};
+    const vector<string> seriesExpressions = {"1/x^2", "(-1)^(x+1)/x", "0.1"};
+
+    vector<double> xs(SAMPLE_COUNT);
+    for (std::size_t i = 0; i < SAMPLE_COUNT; ++i) xs[i] = -10.0 + 20.0 * static_cast<double>(i) / static_cast<double>(SAMPLE_COUNT - 1);
+
+    cout << bold << bright_cyan << left << setw(34) << "graph sampling" << setw(13) << "precision" << right
+         << setw(10) << "ns/x" << setw(10) << "digits" << reset << endl;
+    for (const string& exprStr : plotExpressions) {
+        PrecisionEngine<Reference> referenceEngine;
+        if (!referenceEngine.compile(exprStr)) continue;
+        vector<Reference> reference(xs.size());
+        for (std::size_t i = 0; i < xs.size(); ++i) reference[i] = referenceEngine.evaluate(Reference(xs[i]));
+        benchEveryPrecision(exprStr, [&](auto* tag) { return benchPlot<std::remove_pointer_t<decltype(tag)>>(exprStr, xs, reference); });
+    }
+
+    cout << bold << bright_cyan << "\n" << left << setw(34) << "series, x = 1.." + to_string(SERIES_TERMS) << setw(13) << "precision"
+         << right << setw(10) << "ns/term" << setw(10) << "digits" << reset << endl;
+    for (const string& exprStr : seriesExpressions) {
+        PrecisionEngine<Reference> referenceEngine;
+        if (!referenceEngine.compile(exprStr)) continue;
+        const Reference reference = referenceEngine.sum(1, SERIES_TERMS);
+        benchEveryPrecision("sum " + exprStr, [&](auto* tag) { return benchSeries<std::remove_pointer_t<decltype(tag)>>(exprStr, reference); });
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "sample_buffer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Tuning for sampleAdaptively(). Deviations and angles are measured on the character canvas the
+// samples are drawn on, so the sampler only spends evaluations on detail that would be visible.
+struct AdaptiveSamplingOptions {
+    std::size_t initialIntervals = 64; // Uniform grid every interval starts from
+    std::size_t budget = 1024;         // Total evaluations, including the initial grid
+    int maxRounds = 24;                // Refinement rounds (each halves the chosen intervals)
+    double columns = 80.0;             // Canvas size the tolerances refer to
+    double rows = 25.0;
+    double maxDeviationCells = 0.5;    // Midpoint may stray this far from its chord
+    double maxTurnRadians = 0.35;      // Direction change (about 20 degrees) tolerated at a sample
+    double minWidthColumns = 1.0 / 64; // Intervals narrower than this are never split
+    double yMin = NAN;                 // Canvas Y range if known in advance (e.g. from interval bounds);
+    double yMax = NAN;                 // otherwise the range of the samples so far is used
+};
+
+// Samples f over [xMin, xMax] by recursive subdivision. Starting from a uniform grid, every round
+// scores each interval by how far its midpoint strays from the chord, how sharply the curve turns,
+// and whether it straddles the edge of f's domain (NaN on one side). The worst intervals, up to the
+// remaining budget, are split at their midpoints, all of which are evaluated in one batch.
+// evaluate(xs, ys) fills ys[i] = f(xs[i]). An evaluator taking a third span, evaluate(xs, ys, d2),
+// also fills d2[i] = f''(xs[i]) (e.g. by automatic differentiation); each interval is then also scored
+// by the chord deviation its curvature predicts, |f''| h^2 / 8, which sees bends that fall between
+// samples. The result is sorted by x and not uniform.
+template <typename BatchEval>
+SampleBuffer sampleAdaptively(double xMin, double xMax, const AdaptiveSamplingOptions& options, BatchEval&& evaluate) {
+    constexpr bool withCurvature = std::is_invocable_v<BatchEval&, std::span<const double>, std::span<double>, std::span<double>>;
+    auto run = [&](std::span<const double> xs, std::span<double> ys, std::span<double> d2) {
+        if constexpr (withCurvature) evaluate(xs, ys, d2);
+        else evaluate(xs, ys);
+    };
+    SampleBuffer buffer;
+    std::vector<double> curvature; // f'' at each sample, parallel to buffer.ys (withCurvature only)
+    if (!(xMin < xMax) || options.budget < 2) return buffer;
+
+    const std::size_t initialPoints = std::min(std::max<std::size_t>(options.initialIntervals, 1), options.budget - 1) + 1;
+    buffer.xs.resize(initialPoints);
+    buffer.ys.resize(initialPoints);
+    for (std::size_t i = 0; i < initialPoints; ++i) buffer.xs[i] = SampleBuffer::uniformX(xMin, xMax, initialPoints, i);
+    if (withCurvature) curvature.resize(initialPoints);
+    run(std::span<const double>(buffer.xs), std::span<double>(buffer.ys), std::span<double>(curvature));
+    std::size_t used = initialPoints;
+
+    const double cellWidth = (xMax - xMin) / options.columns;
+    const double minWidth = cellWidth * options.minWidthColumns;
+    std::vector<double> score;
+    std::vector<std::size_t> chosen;
+    std::vector<double> midXs, midYs, midCurvature;
+
+    for (int round = 0; round < options.maxRounds && used < options.budget; ++round) {
+        const std::size_t n = buffer.size();
+        // Cell height follows the Y range the plot will be scaled to: given, or seen so far
+        double yLow = options.yMin, yHigh = options.yMax;
+        if (!(yHigh > yLow)) {
+            yLow = INFINITY;
+            yHigh = -INFINITY;
+            for (const double y : buffer.ys) {
+                if (std::isfinite(y)) { yLow = std::min(yLow, y); yHigh = std::max(yHigh, y); }
+            }
+        }
+        const double cellHeight = (yHigh > yLow) ? (yHigh - yLow) / options.rows
+                                                 : std::max(1.0, std::isfinite(yHigh) ? std::abs(yHigh) : 1.0) / options.rows;
+
+        score.assign(n - 1, 0.0);
+        for (std::size_t i = 0; i + 1 < n; ++i) { // Domain edges and infinities: locate them more precisely
+            const double y0 = buffer.ys[i], y1 = buffer.ys[i + 1];
+            if (std::isfinite(y0) != std::isfinite(y1)) score[i] = 2.0;
+        }
+        for (std::size_t i = 1; i + 1 < n; ++i) {
+            const double xa = buffer.xs[i - 1], xm = buffer.xs[i], xb = buffer.xs[i + 1];
+            const double ya = buffer.ys[i - 1], ym = buffer.ys[i], yb = buffer.ys[i + 1];
+            if (!std::isfinite(ya) || !std::isfinite(ym) || !std::isfinite(yb)) continue;
+            const double chord = ya + (yb - ya) * (xm - xa) / (xb - xa);
+            const double deviation = std::abs(ym - chord) / cellHeight / options.maxDeviationCells;
+            const double u1x = (xm - xa) / cellWidth, u1y = (ym - ya) / cellHeight;
+            const double u2x = (xb - xm) / cellWidth, u2y = (yb - ym) / cellHeight;
+            const double turn = std::atan2(std::abs(u1x * u2y - u1y * u2x), u1x * u2x + u1y * u2y) / options.maxTurnRadians;
+            const double s = std::max(deviation, turn);
+            score[i - 1] = std::max(score[i - 1], s);
+            score[i] = std::max(score[i], s);
+        }
+        if (withCurvature) {
+            for (std::size_t i = 0; i + 1 < n; ++i) {
+                const double k = std::max(std::abs(curvature[i]), std::abs(curvature[i + 1]));
+                if (!std::isfinite(k)) continue;
+                const double h = buffer.xs[i + 1] - buffer.xs[i];
+                score[i] = std::max(score[i], k * h * h / 8.0 / cellHeight / options.maxDeviationCells);
+            }
+        }
+
+        chosen.clear();
+        for (std::size_t i = 0; i + 1 < n; ++i) {
+            if (score[i] > 1.0 && buffer.xs[i + 1] - buffer.xs[i] > minWidth) chosen.push_back(i);
+        }
+        if (chosen.empty()) break; // Every interval already looks straight on the canvas
+        const std::size_t take = std::min(chosen.size(), options.budget - used);
+        std::stable_sort(chosen.begin(), chosen.end(), [&](std::size_t a, std::size_t b) { return score[a] > score[b]; });
+        chosen.resize(take);
+        std::sort(chosen.begin(), chosen.end());
+
+        midXs.resize(take);
+        midYs.resize(take);
+        if (withCurvature) midCurvature.resize(take);
+        for (std::size_t k = 0; k < take; ++k) {
+            midXs[k] = buffer.xs[chosen[k]] + (buffer.xs[chosen[k] + 1] - buffer.xs[chosen[k]]) * 0.5;
+        }
+        run(std::span<const double>(midXs), std::span<double>(midYs), std::span<double>(midCurvature));
+        used += take;
+
+        // Merge the midpoints into the sorted buffer
+        SampleBuffer merged;
+        std::vector<double> mergedCurvature;
+        merged.xs.reserve(n + take);
+        merged.ys.reserve(n + take);
+        if (withCurvature) mergedCurvature.reserve(n + take);
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            merged.xs.push_back(buffer.xs[i]);
+            merged.ys.push_back(buffer.ys[i]);
+            if (withCurvature) mergedCurvature.push_back(curvature[i]);
+            if (next < take && chosen[next] == i) {
+                merged.xs.push_back(midXs[next]);
+                merged.ys.push_back(midYs[next]);
+                if (withCurvature) mergedCurvature.push_back(midCurvature[next]);
+                ++next;
+            }
+        }
+        buffer = std::move(merged);
+        curvature = std::move(mergedCurvature);
+    }
+    buffer.uniform = false;
+    return buffer;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "bytecode.hpp"
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Forward-mode automatic differentiation. A Dual carries f and f'; a HyperDual (value + e1 + e2 +
+// e12 parts, with e1^2 = e2^2 = 0) carries f, f' twice and f'' in its e12 part. Seeding x as
+// Dual::variable(x) / HyperDual::variable(x) and running a program on that type yields the
+// derivatives to machine precision in one pass, with no step size and no truncation error.
+
+struct Dual {
+    double value = 0.0;
+    double d = 0.0; // df/dx
+
+    static Dual constant(double v) { return {v, 0.0}; }
+    static Dual variable(double v) { return {v, 1.0}; }
+};
+
+struct HyperDual {
+    double value = 0.0;
+    double e1 = 0.0;  // df/dx
+    double e2 = 0.0;  // df/dx again (the second infinitesimal direction)
+    double e12 = 0.0; // d2f/dx2
+
+    static HyperDual constant(double v) { return {v, 0.0, 0.0, 0.0}; }
+    static HyperDual variable(double v) { return {v, 1.0, 1.0, 0.0}; }
+};
+
+namespace autodiff_ops {
+    // f(a, b) with its first and second partial derivatives at a point
+    struct Partials {
+        double f;
+        double fa = 0.0, fb = 0.0;
+        double faa = 0.0, fab = 0.0, fbb = 0.0;
+    };
+
+    static constexpr double LN10_CONST = 2.30258509299404568402;
+
+    // The value is bytecode_ops::apply() itself, so it matches the VM (and exprtk) bit for bit
+    inline Partials partials(OpCode op, double a, double b) {
+        Partials p{bytecode_ops::apply(op, a, b)};
+        switch (op) {
+            case OpCode::Neg: p.fa = -1.0; break;
+            case OpCode::Add: p.fa = 1.0; p.fb = 1.0; break;
+            case OpCode::Sub: p.fa = 1.0; p.fb = -1.0; break;
+            case OpCode::Mul: p.fa = b; p.fb = a; p.fab = 1.0; break;
+            case OpCode::Div: p.fa = 1.0 / b; p.fb = -a / (b * b); p.fab = -1.0 / (b * b); p.fbb = 2.0 * a / (b * b * b); break;
+            case OpCode::Mod: p.fa = 1.0; p.fb = -std::trunc(a / b); break;
+            case OpCode::Pow: {
+                const double logA = std::log(a);
+                p.fa = b * std::pow(a, b - 1.0);
+                p.faa = b * (b - 1.0) * std::pow(a, b - 2.0);
+                p.fb = p.f * logA;
+                p.fab = std::pow(a, b - 1.0) * (1.0 + b * logA);
+                p.fbb = p.f * logA * logA;
+                break;
+            }
+            case OpCode::IPow: case OpCode::IPowInv: {
+                const unsigned int n = static_cast<unsigned int>(b);
+                const double dn = static_cast<double>(n);
+                if (op == OpCode::IPow) {
+                    p.fa = dn * bytecode_ops::integerPower(a, n - 1);
+                    p.faa = (n >= 2) ? dn * (dn - 1.0) * bytecode_ops::integerPower(a, n - 2) : 0.0;
+                } else { // a^-n
+                    p.fa = -dn / bytecode_ops::integerPower(a, n + 1);
+                    p.faa = dn * (dn + 1.0) / bytecode_ops::integerPower(a, n + 2);
+                }
+                break;
+            }
+            case OpCode::Min: p.fa = (b < a) ? 0.0 : 1.0; p.fb = 1.0 - p.fa; break; // std::min keeps a on ties
+            case OpCode::Max: p.fa = (a < b) ? 0.0 : 1.0; p.fb = 1.0 - p.fa; break;
+            case OpCode::Atan2: {
+                const double r = a * a + b * b;
+                p.fa = b / r; p.fb = -a / r;
+                p.faa = -2.0 * a * b / (r * r); p.fbb = -p.faa; p.fab = (a * a - b * b) / (r * r);
+                break;
+            }
+            case OpCode::Hypot: {
+                const double h3 = p.f * p.f * p.f;
+                p.fa = a / p.f; p.fb = b / p.f;
+                p.faa = b * b / h3; p.fbb = a * a / h3; p.fab = -a * b / h3;
+                break;
+            }
+            case OpCode::Sin: p.fa = std::cos(a); p.faa = -p.f; break;
+            case OpCode::Cos: p.fa = -std::sin(a); p.faa = -p.f; break;
+            case OpCode::Tan: { const double c = std::cos(a); p.fa = 1.0 / (c * c); p.faa = 2.0 * p.f * p.fa; break; }
+            case OpCode::Asin: { const double s = 1.0 - a * a; p.fa = 1.0 / std::sqrt(s); p.faa = a / (s * std::sqrt(s)); break; }
+            case OpCode::Acos: { const double s = 1.0 - a * a; p.fa = -1.0 / std::sqrt(s); p.faa = -a / (s * std::sqrt(s)); break; }
+            case OpCode::Atan: { const double s = 1.0 + a * a; p.fa = 1.0 / s; p.faa = -2.0 * a / (s * s); break; }
+            case OpCode::Sinh: p.fa = std::cosh(a); p.faa = p.f; break;
+            case OpCode::Cosh: p.fa = std::sinh(a); p.faa = p.f; break;
+            case OpCode::Tanh: p.fa = 1.0 - p.f * p.f; p.faa = -2.0 * p.f * p.fa; break;
+            case OpCode::Asinh: { const double s = a * a + 1.0; p.fa = 1.0 / std::sqrt(s); p.faa = -a / (s * std::sqrt(s)); break; }
+            case OpCode::Acosh: { const double s = a * a - 1.0; p.fa = 1.0 / std::sqrt(s); p.faa = -a / (s * std::sqrt(s)); break; }
+            case OpCode::Atanh: { const double s = 1.0 - a * a; p.fa = 1.0 / s; p.faa = 2.0 * a / (s * s); break; }
+            case OpCode::Exp: p.fa = p.f; p.faa = p.f; break;
+            case OpCode::Log: p.fa = 1.0 / a; p.faa = -1.0 / (a * a); break;
+            case OpCode::Log10: p.fa = 1.0 / (a * LN10_CONST); p.faa = -1.0 / (a * a * LN10_CONST); break;
+            case OpCode::Log2: p.fa = 1.0 / (a * bytecode_ops::LN2_CONST); p.faa = -1.0 / (a * a * bytecode_ops::LN2_CONST); break;
+            case OpCode::Sqrt: p.fa = 0.5 / p.f; p.faa = -0.25 / (a * p.f); break;
+            case OpCode::Cbrt: p.fa = 1.0 / (3.0 * p.f * p.f); p.faa = -2.0 / (9.0 * a * p.f * p.f); break;
+            case OpCode::Abs: p.fa = (a > 0.0) ? 1.0 : (a < 0.0 ? -1.0 : 0.0); break;
+            default: break; // Comparisons, floor, ceil, round: piecewise constant
+        }
+        return p;
+    }
+
+    // partial * tangent, where a zero tangent contributes nothing even if the partial is not finite
+    // (d/dx of x^2.5 must not pick up 0 * log(x) from the constant exponent)
+    inline double term(double partial, double tangent) {
+        return (tangent == 0.0) ? 0.0 : partial * tangent;
+    }
+
+    inline double apply(OpCode op, double a, double b) { return bytecode_ops::apply(op, a, b); }
+
+    inline Dual apply(OpCode op, const Dual& a, const Dual& b) {
+        const Partials p = partials(op, a.value, b.value);
+        return {p.f, term(p.fa, a.d) + term(p.fb, b.d)};
+    }
+
+    inline HyperDual apply(OpCode op, const HyperDual& a, const HyperDual& b) {
+        const Partials p = partials(op, a.value, b.value);
+        return {p.f,
+                term(p.fa, a.e1) + term(p.fb, b.e1),
+                term(p.fa, a.e2) + term(p.fb, b.e2),
+                term(p.fa, a.e12) + term(p.fb, b.e12) + term(p.faa, a.e1 * a.e2) +
+                    term(p.fab, a.e1 * b.e2 + a.e2 * b.e1) + term(p.fbb, b.e1 * b.e2)};
+    }
+}
+
+// Runs a BytecodeProgram one sample at a time on any scalar type: double (the same results as
+// BytecodeVM::evaluate), Dual for f', HyperDual for f' and f''. Integer-power instructions keep
+// their exponent as a plain number. An instance keeps mutable register state: use one per thread.
+template <typename Scalar>
+class ProgramEvaluator {
+public:
+    void load(const BytecodeProgram& program) {
+        m_program = program;
+        m_registers.assign(program.registerCount, constant(0.0));
+        for (std::size_t i = 0; i < program.constants.size(); ++i) m_registers[i + 1] = constant(program.constants[i]);
+        m_loaded = true;
+    }
+
+    bool loaded() const { return m_loaded; }
+
+    Scalar evaluate(const Scalar& x) {
+        Scalar* r = m_registers.data();
+        r[BytecodeProgram::X_REGISTER] = x;
+        for (const Instruction& ins : m_program.code) {
+            const bool integerPower = ins.op == OpCode::IPow || ins.op == OpCode::IPowInv;
+            r[ins.dst] = autodiff_ops::apply(ins.op, r[ins.lhs], integerPower ? constant(static_cast<double>(ins.rhs)) : r[ins.rhs]);
+        }
+        return r[m_program.resultRegister];
+    }
+
+private:
+    static Scalar constant(double v) {
+        if constexpr (std::is_same_v<Scalar, double>) return v;
+        else return Scalar::constant(v);
+    }
+
+    BytecodeProgram m_program;
+    std::vector<Scalar> m_registers;
+    bool m_loaded = false;
+};
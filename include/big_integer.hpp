@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Arbitrary-size unsigned integers for exact factorials. Limbs hold base-10^9 digits, least
+// significant first, so decimal output is a plain walk over the limbs (and can be streamed) at the
+// price of ~7% more limbs than base 2^32. Multiplication is schoolbook below
+// KARATSUBA_THRESHOLD limbs and Karatsuba above it; very unbalanced operands are multiplied slice
+// by slice so that Karatsuba always sees operands of similar length.
+class BigUnsigned {
+public:
+    using Limb = std::uint32_t;
+    static constexpr Limb BASE = 1000000000;
+    static constexpr int BASE_DIGITS = 9;
+    static constexpr std::size_t KARATSUBA_THRESHOLD = 48; // Limbs of the shorter operand
+
+    BigUnsigned() = default; // Zero
+
+    explicit BigUnsigned(std::uint64_t value) {
+        for (; value > 0; value /= BASE) m_limbs.push_back(static_cast<Limb>(value % BASE));
+    }
+
+    bool isZero() const { return m_limbs.empty(); }
+
+    std::size_t digitCount() const {
+        if (m_limbs.empty()) return 1;
+        std::size_t digits = (m_limbs.size() - 1) * BASE_DIGITS;
+        for (Limb top = m_limbs.back(); top > 0; top /= 10) ++digits;
+        return digits;
+    }
+
+    friend BigUnsigned operator*(const BigUnsigned& a, const BigUnsigned& b) {
+        BigUnsigned product;
+        product.m_limbs = multiply(a.m_limbs, b.m_limbs);
+        return product;
+    }
+
+    // Multiplies by a factor below 2^32, which keeps limb * factor + carry within 64 bits
+    BigUnsigned& operator*=(std::uint32_t factor) {
+        std::uint64_t carry = 0;
+        for (Limb& limb : m_limbs) {
+            const std::uint64_t current = static_cast<std::uint64_t>(limb) * factor + carry;
+            limb = static_cast<Limb>(current % BASE);
+            carry = current / BASE;
+        }
+        for (; carry > 0; carry /= BASE) m_limbs.push_back(static_cast<Limb>(carry % BASE));
+        if (factor == 0) m_limbs.clear();
+        return *this;
+    }
+
+    // Product of the factors (each below 2^32) by binary splitting: the halves are multiplied
+    // recursively, so the large multiplications are between operands of equal size.
+    static BigUnsigned product(std::span<const std::uint32_t> factors) {
+        static constexpr std::size_t LEAF_FACTORS = 16;
+        if (factors.size() <= LEAF_FACTORS) {
+            BigUnsigned result(1);
+            for (const std::uint32_t factor : factors) result *= factor;
+            return result;
+        }
+        const std::size_t half = factors.size() / 2;
+        return product(factors.first(half)) * product(factors.subspan(half));
+    }
+
+    // Writes the decimal digits to out, most significant first, one limb at a time
+    void writeDecimal(std::ostream& out) const {
+        if (m_limbs.empty()) {
+            out << '0';
+            return;
+        }
+        out << m_limbs.back();
+        char digits[BASE_DIGITS];
+        for (std::size_t i = m_limbs.size() - 1; i-- > 0;) {
+            Limb limb = m_limbs[i];
+            for (int d = BASE_DIGITS - 1; d >= 0; --d, limb /= 10) digits[d] = static_cast<char>('0' + limb % 10);
+            out.write(digits, BASE_DIGITS);
+        }
+    }
+
+    // The first count decimal digits (all of them if there are fewer)
+    std::string leadingDigits(std::size_t count) const {
+        std::string digits = std::to_string(m_limbs.empty() ? 0 : m_limbs.back());
+        for (std::size_t i = m_limbs.size() - 1; digits.size() < count && i-- > 0;) digits += paddedLimb(m_limbs[i]);
+        return digits.substr(0, count);
+    }
+
+    // The last count decimal digits (all of them if there are fewer)
+    std::string trailingDigits(std::size_t count) const {
+        if (digitCount() <= count) return leadingDigits(count);
+        std::string digits;
+        for (std::size_t i = 0; digits.size() < count; ++i) digits.insert(0, paddedLimb(m_limbs[i]));
+        return digits.substr(digits.size() - count);
+    }
+
+private:
+    std::vector<Limb> m_limbs; // Base 10^9, least significant first, no leading zero limbs
+
+    static std::string paddedLimb(Limb limb) {
+        std::string digits(BASE_DIGITS, '0');
+        for (int d = BASE_DIGITS - 1; d >= 0 && limb > 0; --d, limb /= 10) digits[d] = static_cast<char>('0' + limb % 10);
+        return digits;
+    }
+
+    static void trim(std::vector<Limb>& limbs) {
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    }
+
+    // target += addend * BASE^offset; target must be long enough for the sum
+    static void addShifted(std::vector<Limb>& target, std::span<const Limb> addend, std::size_t offset) {
+        Limb carry = 0;
+        std::size_t i = 0;
+        for (; i < addend.size() || carry; ++i) {
+            Limb sum = target[offset + i] + carry + (i < addend.size() ? addend[i] : 0);
+            carry = sum >= BASE ? 1 : 0;
+            target[offset + i] = sum - carry * BASE;
+        }
+    }
+
+    // target -= subtrahend, which must not exceed target
+    static void subtractInPlace(std::vector<Limb>& target, std::span<const Limb> subtrahend) {
+        Limb borrow = 0;
+        for (std::size_t i = 0; i < subtrahend.size() || borrow; ++i) {
+            const Limb take = borrow + (i < subtrahend.size() ? subtrahend[i] : 0);
+            borrow = target[i] < take ? 1 : 0;
+            target[i] = target[i] + borrow * BASE - take;
+        }
+        trim(target);
+    }
+
+    static std::vector<Limb> sum(std::span<const Limb> a, std::span<const Limb> b) {
+        if (a.size() < b.size()) std::swap(a, b);
+        std::vector<Limb> result(a.begin(), a.end());
+        result.push_back(0);
+        addShifted(result, b, 0);
+        trim(result);
+        return result;
+    }
+
+    static std::vector<Limb> schoolbook(std::span<const Limb> a, std::span<const Limb> b) {
+        std::vector<Limb> result(a.size() + b.size(), 0);
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (a[i] == 0) continue;
+            std::uint64_t carry = 0;
+            for (std::size_t j = 0; j < b.size(); ++j) {
+                const std::uint64_t current = result[i + j] + static_cast<std::uint64_t>(a[i]) * b[j] + carry;
+                result[i + j] = static_cast<Limb>(current % BASE);
+                carry = current / BASE;
+            }
+            result[i + b.size()] = static_cast<Limb>(carry);
+        }
+        trim(result);
+        return result;
+    }
+
+    static std::vector<Limb> multiply(std::span<const Limb> a, std::span<const Limb> b) {
+        if (a.size() < b.size()) std::swap(a, b);
+        if (b.empty()) return {};
+        if (b.size() < KARATSUBA_THRESHOLD) return schoolbook(a, b);
+        if (2 * b.size() <= a.size()) { // Unbalanced: slices of a as long as b
+            std::vector<Limb> result(a.size() + b.size() + 1, 0);
+            for (std::size_t offset = 0; offset < a.size(); offset += b.size()) {
+                addShifted(result, multiply(a.subspan(offset, std::min(b.size(), a.size() - offset)), b), offset);
+            }
+            trim(result);
+            return result;
+        }
+
+        // a = a1*B^m + a0, b = b1*B^m + b0: a*b = z2*B^2m + z1*B^m + z0 with three half-size products
+        const std::size_t m = a.size() / 2;
+        const std::span<const Limb> a0 = a.first(m), a1 = a.subspan(m), b0 = b.first(m), b1 = b.subspan(m);
+        const std::vector<Limb> z0 = multiply(a0, b0), z2 = multiply(a1, b1);
+        std::vector<Limb> z1 = multiply(sum(a0, a1), sum(b0, b1));
+        subtractInPlace(z1, z0);
+        subtractInPlace(z1, z2);
+
+        std::vector<Limb> result(a.size() + b.size() + 1, 0);
+        addShifted(result, z0, 0);
+        addShifted(result, z1, m);
+        addShifted(result, z2, 2 * m);
+        trim(result);
+        return result;
+    }
+};
@@ -0,0 +1,437 @@
+#pragma once
+
+#include "expression_tree.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
+#include <vector>
+
+// Register-based bytecode backend. An ExprNode tree is lowered into a flat instruction list
+// that reads and writes a small register file, then run through a tight dispatch loop instead
+// of exprtk's pointer-linked node tree. The scalar semantics mirror exprtk's operator
+// implementations (epsilon equality, its round(), log2 and integer-power chains) so both
+// backends agree bit-for-bit on everything the tree parser accepts.
+
+enum class OpCode : std::uint8_t {
+    Neg, Add, Sub, Mul, Div, Mod, Pow, IPow, IPowInv,
+    Less, LessEq, Greater, GreaterEq, Equal, NotEqual,
+    Min, Max, Atan2, Hypot,
+    Sin, Cos, Tan, Asin, Acos, Atan, Sinh, Cosh, Tanh, Asinh, Acosh, Atanh,
+    Exp, Log, Log10, Log2, Sqrt, Cbrt, Abs, Floor, Ceil, Round
+};
+
+// dst = op(lhs, rhs). Unary ops ignore rhs; IPow/IPowInv store the exponent in rhs.
+struct Instruction {
+    OpCode op;
+    std::uint16_t dst;
+    std::uint16_t lhs;
+    std::uint16_t rhs;
+};
+
+// Register 0 holds x, registers 1..constants.size() hold the constant pool, the rest are temporaries.
+struct BytecodeProgram {
+    static constexpr std::uint16_t X_REGISTER = 0;
+
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::uint16_t registerCount = 1;
+    std::uint16_t resultRegister = X_REGISTER;
+};
+
+// --- Scalar semantics shared by constant folding, the scalar VM and the block VM ---
+namespace bytecode_ops {
+    static constexpr double EQUALITY_EPSILON = 0.0000000001; // exprtk's epsilon_type<double>
+    static constexpr double LN2_CONST = 0.69314718055994530941723212145817656807550013436026;
+
+    inline double absValue(double v) { return (v < 0.0) ? -v : v; }
+
+    inline double equal(double a, double b) {
+        return (absValue(a - b) <= std::max(1.0, std::max(absValue(a), absValue(b))) * EQUALITY_EPSILON) ? 1.0 : 0.0;
+    }
+
+    inline double notEqual(double a, double b) { // Not 1 - equal(): exprtk gives 0 for NaN operands either way
+        return (absValue(a - b) > std::max(1.0, std::max(absValue(a), absValue(b))) * EQUALITY_EPSILON) ? 1.0 : 0.0;
+    }
+
+    inline double round(double v) { return (v < 0.0) ? std::ceil(v - 0.5) : std::floor(v + 0.5); }
+
+    // Same multiplication chains as exprtk's fast_exp<T,N>, which it uses for x^n with integer |n| <= 60
+    inline double integerPower(double v, unsigned int n) {
+        switch (n) {
+            case 0: return 1.0;
+            case 1: return v;
+            case 2: return v * v;
+            case 3: return v * v * v;
+            case 4: { const double v2 = v * v; return v2 * v2; }
+            case 5: { const double v2 = v * v; return (v2 * v2) * v; }
+            case 6: { const double v3 = v * v * v; return v3 * v3; }
+            case 7: { const double v3 = v * v * v; return (v3 * v3) * v; }
+            case 8: { const double v2 = v * v; const double v4 = v2 * v2; return v4 * v4; }
+            case 9: { const double v2 = v * v; const double v4 = v2 * v2; return (v4 * v4) * v; }
+            case 10: { const double v2 = v * v; const double v5 = (v2 * v2) * v; return v5 * v5; }
+            default: {
+                double result = 1.0;
+                while (n) {
+                    if (n % 2 == 1) {
+                        result *= v;
+                        --n;
+                    }
+                    v *= v;
+                    n /= 2;
+                }
+                return result;
+            }
+        }
+    }
+
+    inline double apply(OpCode op, double a, double b) {
+        switch (op) {
+            case OpCode::Neg:       return -a;
+            case OpCode::Add:       return a + b;
+            case OpCode::Sub:       return a - b;
+            case OpCode::Mul:       return a * b;
+            case OpCode::Div:       return a / b;
+            case OpCode::Mod:       return std::fmod(a, b);
+            case OpCode::Pow:       return std::pow(a, b);
+            case OpCode::IPow:      return integerPower(a, static_cast<unsigned int>(b));
+            case OpCode::IPowInv:   return 1.0 / integerPower(a, static_cast<unsigned int>(b));
+            case OpCode::Less:      return (a < b) ? 1.0 : 0.0;
+            case OpCode::LessEq:    return (a <= b) ? 1.0 : 0.0;
+            case OpCode::Greater:   return (a > b) ? 1.0 : 0.0;
+            case OpCode::GreaterEq: return (a >= b) ? 1.0 : 0.0;
+            case OpCode::Equal:     return equal(a, b);
+            case OpCode::NotEqual:  return notEqual(a, b);
+            case OpCode::Min:       return std::min(a, b);
+            case OpCode::Max:       return std::max(a, b);
+            case OpCode::Atan2:     return std::atan2(a, b);
+            case OpCode::Hypot:     return std::sqrt((a * a) + (b * b));
+            case OpCode::Sin:       return std::sin(a);
+            case OpCode::Cos:       return std::cos(a);
+            case OpCode::Tan:       return std::tan(a);
+            case OpCode::Asin:      return std::asin(a);
+            case OpCode::Acos:      return std::acos(a);
+            case OpCode::Atan:      return std::atan(a);
+            case OpCode::Sinh:      return std::sinh(a);
+            case OpCode::Cosh:      return std::cosh(a);
+            case OpCode::Tanh:      return std::tanh(a);
+            case OpCode::Asinh:     return std::asinh(a);
+            case OpCode::Acosh:     return std::acosh(a);
+            case OpCode::Atanh:     return std::atanh(a);
+            case OpCode::Exp:       return std::exp(a);
+            case OpCode::Log:       return std::log(a);
+            case OpCode::Log10:     return std::log10(a);
+            case OpCode::Log2:      return std::log(a) / LN2_CONST;
+            case OpCode::Sqrt:      return std::sqrt(a);
+            case OpCode::Cbrt:      return std::cbrt(a);
+            case OpCode::Abs:       return absValue(a);
+            case OpCode::Floor:     return std::floor(a);
+            case OpCode::Ceil:      return std::ceil(a);
+            case OpCode::Round:     return round(a);
+        }
+        return NAN;
+    }
+}
+
+// Lowers an ExprNode tree to bytecode: folds constant subtrees, turns small integer powers into
+// IPow/IPowInv like exprtk's cardinal pow optimisation, and recycles temporaries once consumed.
+class BytecodeCompiler {
+public:
+    static std::optional<BytecodeProgram> compile(const ExprPtr& root) {
+        if (!root) return std::nullopt;
+        BytecodeCompiler compiler;
+        const ExprPtr folded = fold(root);
+        compiler.collectConstants(folded);
+        const std::optional<std::uint16_t> result = compiler.emit(folded);
+        if (!result) return std::nullopt;
+        compiler.m_program.resultRegister = *result;
+        return compiler.m_program;
+    }
+
+    static std::optional<OpCode> opcodeFor(ExprKind kind) {
+        switch (kind) {
+            case ExprKind::Neg: return OpCode::Neg;             case ExprKind::Add: return OpCode::Add;
+            case ExprKind::Sub: return OpCode::Sub;             case ExprKind::Mul: return OpCode::Mul;
+            case ExprKind::Div: return OpCode::Div;             case ExprKind::Mod: return OpCode::Mod;
+            case ExprKind::Pow: return OpCode::Pow;             case ExprKind::Less: return OpCode::Less;
+            case ExprKind::LessEq: return OpCode::LessEq;       case ExprKind::Greater: return OpCode::Greater;
+            case ExprKind::GreaterEq: return OpCode::GreaterEq; case ExprKind::Equal: return OpCode::Equal;
+            case ExprKind::NotEqual: return OpCode::NotEqual;   case ExprKind::Min: return OpCode::Min;
+            case ExprKind::Max: return OpCode::Max;             case ExprKind::Atan2: return OpCode::Atan2;
+            case ExprKind::Hypot: return OpCode::Hypot;         case ExprKind::Sin: return OpCode::Sin;
+            case ExprKind::Cos: return OpCode::Cos;             case ExprKind::Tan: return OpCode::Tan;
+            case ExprKind::Asin: return OpCode::Asin;           case ExprKind::Acos: return OpCode::Acos;
+            case ExprKind::Atan: return OpCode::Atan;           case ExprKind::Sinh: return OpCode::Sinh;
+            case ExprKind::Cosh: return OpCode::Cosh;           case ExprKind::Tanh: return OpCode::Tanh;
+            case ExprKind::Asinh: return OpCode::Asinh;         case ExprKind::Acosh: return OpCode::Acosh;
+            case ExprKind::Atanh: return OpCode::Atanh;         case ExprKind::Exp: return OpCode::Exp;
+            case ExprKind::Log: return OpCode::Log;             case ExprKind::Log10: return OpCode::Log10;
+            case ExprKind::Log2: return OpCode::Log2;           case ExprKind::Sqrt: return OpCode::Sqrt;
+            case ExprKind::Cbrt: return OpCode::Cbrt;           case ExprKind::Abs: return OpCode::Abs;
+            case ExprKind::Floor: return OpCode::Floor;         case ExprKind::Ceil: return OpCode::Ceil;
+            case ExprKind::Round: return OpCode::Round;
+            default: return std::nullopt;
+        }
+    }
+
+private:
+    static constexpr double MAX_CARDINAL_POWER = 60.0;
+
+    BytecodeProgram m_program;
+    std::map<std::uint64_t, std::uint16_t> m_constantRegisters;
+    std::vector<std::uint16_t> m_freeRegisters;
+
+    // Returns true (and the exponent) when base^exponent should use an integer multiplication chain
+    static bool isCardinalPower(const ExprPtr& node, double& exponent) {
+        if (node->kind != ExprKind::Pow || !node->children[1]->isConstant()) return false;
+        exponent = node->children[1]->value;
+        return std::abs(exponent) <= MAX_CARDINAL_POWER && std::trunc(exponent) == exponent;
+    }
+
+    static double evaluateCardinalPower(double base, double exponent) {
+        const unsigned int n = static_cast<unsigned int>(std::abs(exponent));
+        if (n == 0) return 1.0;
+        return (exponent >= 0.0) ? bytecode_ops::integerPower(base, n) : 1.0 / bytecode_ops::integerPower(base, n);
+    }
+
+    // Replaces every subtree whose operands are all constants by its value
+    static ExprPtr fold(const ExprPtr& node) {
+        if (node->children.empty()) return node;
+        std::vector<ExprPtr> children;
+        bool allConstant = true;
+        for (const auto& child : node->children) {
+            children.push_back(fold(child));
+            allConstant = allConstant && children.back()->isConstant();
+        }
+        auto folded = std::make_shared<const ExprNode>(ExprNode{node->kind, 0.0, children});
+        if (!allConstant) return folded;
+
+        const double a = children[0]->value;
+        const double b = children.size() > 1 ? children[1]->value : 0.0;
+        double exponent;
+        if (isCardinalPower(folded, exponent)) return makeConstant(evaluateCardinalPower(a, exponent));
+        const std::optional<OpCode> op = opcodeFor(node->kind);
+        return op ? makeConstant(bytecode_ops::apply(*op, a, b)) : folded;
+    }
+
+    // First pass: give every distinct constant (by bit pattern) a register directly after x
+    void collectConstants(const ExprPtr& node) {
+        double exponent;
+        if (isCardinalPower(node, exponent)) {
+            if (exponent == 0.0) constantRegister(1.0);
+            collectConstants(node->children[0]);
+            return;
+        }
+        if (node->isConstant()) constantRegister(node->value);
+        for (const auto& child : node->children) collectConstants(child);
+    }
+
+    std::uint16_t constantRegister(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        auto it = m_constantRegisters.find(bits);
+        if (it != m_constantRegisters.end()) return it->second;
+        m_program.constants.push_back(value);
+        const std::uint16_t reg = static_cast<std::uint16_t>(m_program.constants.size());
+        m_program.registerCount = static_cast<std::uint16_t>(reg + 1);
+        m_constantRegisters[bits] = reg;
+        return reg;
+    }
+
+    std::uint16_t allocateTemporary() {
+        if (!m_freeRegisters.empty()) {
+            auto lowest = std::min_element(m_freeRegisters.begin(), m_freeRegisters.end());
+            const std::uint16_t reg = *lowest;
+            m_freeRegisters.erase(lowest);
+            return reg;
+        }
+        return m_program.registerCount++;
+    }
+
+    void release(std::uint16_t reg) {
+        if (reg > m_program.constants.size()) m_freeRegisters.push_back(reg); // Only temporaries are recycled
+    }
+
+    // Second pass: post-order emission. The result register is allocated before the operands are
+    // released, so an instruction never writes one of its inputs and the block loops can vectorise.
+    std::optional<std::uint16_t> emit(const ExprPtr& node) {
+        if (node->kind == ExprKind::Constant) return constantRegister(node->value);
+        if (node->kind == ExprKind::VariableX) return BytecodeProgram::X_REGISTER;
+        if (m_program.registerCount == std::numeric_limits<std::uint16_t>::max()) return std::nullopt;
+
+        double exponent;
+        if (isCardinalPower(node, exponent)) {
+            const unsigned int n = static_cast<unsigned int>(std::abs(exponent));
+            if (n == 0) return constantRegister(1.0);
+            const std::optional<std::uint16_t> base = emit(node->children[0]);
+            if (!base) return std::nullopt;
+            const std::uint16_t dst = allocateTemporary();
+            release(*base);
+            m_program.code.push_back({exponent > 0.0 ? OpCode::IPow : OpCode::IPowInv, dst, *base, static_cast<std::uint16_t>(n)});
+            return dst;
+        }
+
+        const std::optional<OpCode> op = opcodeFor(node->kind);
+        if (!op || node->children.empty() || node->children.size() > 2) return std::nullopt;
+
+        const std::optional<std::uint16_t> lhs = emit(node->children[0]);
+        const std::optional<std::uint16_t> rhs = node->children.size() > 1 ? emit(node->children[1]) : lhs;
+        if (!lhs || !rhs) return std::nullopt;
+        const std::uint16_t dst = allocateTemporary();
+        release(*lhs);
+        if (*rhs != *lhs) release(*rhs);
+        m_program.code.push_back({*op, dst, *lhs, *rhs});
+        return dst;
+    }
+};
+
+// Executes a BytecodeProgram. evaluate() runs one sample through a scalar register file;
+// evaluateBlock() runs every instruction across up to BLOCK_LANES samples at once, so the
+// dispatch cost is paid once per block and the inner loops are free to vectorise.
+// An instance keeps mutable register state: use one per thread.
+class BytecodeVM {
+public:
+    static constexpr std::size_t BLOCK_LANES = 256;
+
+    void load(const BytecodeProgram& program) {
+        m_program = program;
+        m_registers.assign(program.registerCount, 0.0);
+        m_blockRegisters.assign(static_cast<std::size_t>(program.registerCount) * BLOCK_LANES, 0.0);
+        m_blockPointers.resize(program.registerCount);
+        for (std::uint16_t reg = 0; reg < program.registerCount; ++reg) m_blockPointers[reg] = blockRegister(reg);
+        for (std::size_t c = 0; c < program.constants.size(); ++c) {
+            m_registers[c + 1] = program.constants[c];
+            std::fill_n(m_blockRegisters.begin() + static_cast<std::ptrdiff_t>((c + 1) * BLOCK_LANES), BLOCK_LANES, program.constants[c]);
+        }
+    }
+
+    const BytecodeProgram& program() const { return m_program; }
+
+    double evaluate(double x) {
+        double* regs = m_registers.data();
+        regs[BytecodeProgram::X_REGISTER] = x;
+        for (const Instruction& ins : m_program.code) {
+            const double rhs = hasImmediateExponent(ins.op) ? static_cast<double>(ins.rhs) : regs[ins.rhs];
+            regs[ins.dst] = bytecode_ops::apply(ins.op, regs[ins.lhs], rhs);
+        }
+        return regs[m_program.resultRegister];
+    }
+
+    // Evaluates lanes (<= BLOCK_LANES) samples from xs into ys
+    void evaluateBlock(const double* xs, double* ys, std::size_t lanes) {
+        using namespace bytecode_ops;
+        m_blockPointers[BytecodeProgram::X_REGISTER] = const_cast<double*>(xs); // x is read in place, never written
+        for (const Instruction& ins : m_program.code) {
+            double* d = m_blockPointers[ins.dst];
+            const double* a = m_blockPointers[ins.lhs];
+            const double* b = hasImmediateExponent(ins.op) ? a : m_blockPointers[ins.rhs];
+            switch (ins.op) {
+                case OpCode::Neg:       mapUnary(d, a, lanes, [](double v) { return -v; }); break;
+                case OpCode::Add:       mapBinary(d, a, b, lanes, [](double u, double v) { return u + v; }); break;
+                case OpCode::Sub:       mapBinary(d, a, b, lanes, [](double u, double v) { return u - v; }); break;
+                case OpCode::Mul:       mapBinary(d, a, b, lanes, [](double u, double v) { return u * v; }); break;
+                case OpCode::Div:       mapBinary(d, a, b, lanes, [](double u, double v) { return u / v; }); break;
+                case OpCode::Mod:       mapBinary(d, a, b, lanes, [](double u, double v) { return std::fmod(u, v); }); break;
+                case OpCode::Pow:       mapBinary(d, a, b, lanes, [](double u, double v) { return std::pow(u, v); }); break;
+                case OpCode::IPow:      blockIntegerPower(d, a, lanes, ins.rhs, false); break;
+                case OpCode::IPowInv:   blockIntegerPower(d, a, lanes, ins.rhs, true); break;
+                case OpCode::Less:      mapBinary(d, a, b, lanes, [](double u, double v) { return (u < v) ? 1.0 : 0.0; }); break;
+                case OpCode::LessEq:    mapBinary(d, a, b, lanes, [](double u, double v) { return (u <= v) ? 1.0 : 0.0; }); break;
+                case OpCode::Greater:   mapBinary(d, a, b, lanes, [](double u, double v) { return (u > v) ? 1.0 : 0.0; }); break;
+                case OpCode::GreaterEq: mapBinary(d, a, b, lanes, [](double u, double v) { return (u >= v) ? 1.0 : 0.0; }); break;
+                case OpCode::Equal:     mapBinary(d, a, b, lanes, [](double u, double v) { return equal(u, v); }); break;
+                case OpCode::NotEqual:  mapBinary(d, a, b, lanes, [](double u, double v) { return notEqual(u, v); }); break;
+                case OpCode::Min:       mapBinary(d, a, b, lanes, [](double u, double v) { return std::min(u, v); }); break;
+                case OpCode::Max:       mapBinary(d, a, b, lanes, [](double u, double v) { return std::max(u, v); }); break;
+                case OpCode::Atan2:     mapBinary(d, a, b, lanes, [](double u, double v) { return std::atan2(u, v); }); break;
+                case OpCode::Hypot:     mapBinary(d, a, b, lanes, [](double u, double v) { return std::sqrt((u * u) + (v * v)); }); break;
+                case OpCode::Sin:       mapUnary(d, a, lanes, [](double v) { return std::sin(v); }); break;
+                case OpCode::Cos:       mapUnary(d, a, lanes, [](double v) { return std::cos(v); }); break;
+                case OpCode::Tan:       mapUnary(d, a, lanes, [](double v) { return std::tan(v); }); break;
+                case OpCode::Asin:      mapUnary(d, a, lanes, [](double v) { return std::asin(v); }); break;
+                case OpCode::Acos:      mapUnary(d, a, lanes, [](double v) { return std::acos(v); }); break;
+                case OpCode::Atan:      mapUnary(d, a, lanes, [](double v) { return std::atan(v); }); break;
+                case OpCode::Sinh:      mapUnary(d, a, lanes, [](double v) { return std::sinh(v); }); break;
+                case OpCode::Cosh:      mapUnary(d, a, lanes, [](double v) { return std::cosh(v); }); break;
+                case OpCode::Tanh:      mapUnary(d, a, lanes, [](double v) { return std::tanh(v); }); break;
+                case OpCode::Asinh:     mapUnary(d, a, lanes, [](double v) { return std::asinh(v); }); break;
+                case OpCode::Acosh:     mapUnary(d, a, lanes, [](double v) { return std::acosh(v); }); break;
+                case OpCode::Atanh:     mapUnary(d, a, lanes, [](double v) { return std::atanh(v); }); break;
+                case OpCode::Exp:       mapUnary(d, a, lanes, [](double v) { return std::exp(v); }); break;
+                case OpCode::Log:       mapUnary(d, a, lanes, [](double v) { return std::log(v); }); break;
+                case OpCode::Log10:     mapUnary(d, a, lanes, [](double v) { return std::log10(v); }); break;
+                case OpCode::Log2:      mapUnary(d, a, lanes, [](double v) { return std::log(v) / LN2_CONST; }); break;
+                case OpCode::Sqrt:      mapUnary(d, a, lanes, [](double v) { return std::sqrt(v); }); break;
+                case OpCode::Cbrt:      mapUnary(d, a, lanes, [](double v) { return std::cbrt(v); }); break;
+                case OpCode::Abs:       mapUnary(d, a, lanes, [](double v) { return absValue(v); }); break;
+                case OpCode::Floor:     mapUnary(d, a, lanes, [](double v) { return std::floor(v); }); break;
+                case OpCode::Ceil:      mapUnary(d, a, lanes, [](double v) { return std::ceil(v); }); break;
+                case OpCode::Round:     mapUnary(d, a, lanes, [](double v) { return bytecode_ops::round(v); }); break;
+            }
+        }
+        std::copy_n(m_blockPointers[m_program.resultRegister], lanes, ys);
+    }
+
+    static bool hasImmediateExponent(OpCode op) { return op == OpCode::IPow || op == OpCode::IPowInv; }
+
+private:
+    BytecodeProgram m_program;
+    std::vector<double> m_registers;
+    std::vector<double> m_blockRegisters;
+    std::vector<double*> m_blockPointers; // Per-register lane arrays; register 0 is redirected to the caller's xs
+    std::array<double, BLOCK_LANES> m_powerScratch;
+
+    double* blockRegister(std::uint16_t reg) { return m_blockRegisters.data() + static_cast<std::size_t>(reg) * BLOCK_LANES; }
+
+    // One loop per opcode, so the operation is inlined and the compiler can vectorise it
+    template <typename F>
+    static void mapUnary(double* d, const double* a, std::size_t lanes, F f) {
+        for (std::size_t i = 0; i < lanes; ++i) d[i] = f(a[i]);
+    }
+
+    template <typename F>
+    static void mapBinary(double* d, const double* a, const double* b, std::size_t lanes, F f) {
+        for (std::size_t i = 0; i < lanes; ++i) d[i] = f(a[i], b[i]);
+    }
+
+    // The exponent is fixed per instruction, so pick the multiplication chain once per block.
+    // Each case performs exactly the multiplications of bytecode_ops::integerPower, in order.
+    void blockIntegerPower(double* d, const double* a, std::size_t lanes, unsigned int n, bool reciprocal) {
+        switch (n) {
+            case 1: mapUnary(d, a, lanes, [](double v) { return v; }); break;
+            case 2: mapUnary(d, a, lanes, [](double v) { return v * v; }); break;
+            case 3: mapUnary(d, a, lanes, [](double v) { return v * v * v; }); break;
+            case 4: mapUnary(d, a, lanes, [](double v) { const double v2 = v * v; return v2 * v2; }); break;
+            case 5: mapUnary(d, a, lanes, [](double v) { const double v2 = v * v; return (v2 * v2) * v; }); break;
+            case 6: mapUnary(d, a, lanes, [](double v) { const double v3 = v * v * v; return v3 * v3; }); break;
+            case 7: mapUnary(d, a, lanes, [](double v) { const double v3 = v * v * v; return (v3 * v3) * v; }); break;
+            case 8: mapUnary(d, a, lanes, [](double v) { const double v2 = v * v; const double v4 = v2 * v2; return v4 * v4; }); break;
+            case 9: mapUnary(d, a, lanes, [](double v) { const double v2 = v * v; const double v4 = v2 * v2; return (v4 * v4) * v; }); break;
+            case 10: mapUnary(d, a, lanes, [](double v) { const double v2 = v * v; const double v5 = (v2 * v2) * v; return v5 * v5; }); break;
+            default: { // Square-and-multiply, one whole-block step at a time
+                double* base = m_powerScratch.data();
+                std::copy_n(a, lanes, base);
+                std::fill_n(d, lanes, 1.0);
+                while (n) {
+                    if (n % 2 == 1) {
+                        mapBinary(d, d, base, lanes, [](double u, double v) { return u * v; });
+                        --n;
+                    }
+                    mapUnary(base, base, lanes, [](double v) { return v * v; });
+                    n /= 2;
+                }
+                break;
+            }
+        }
+        if (reciprocal) mapUnary(d, d, lanes, [](double v) { return 1.0 / v; });
+    }
+};
+
+// Parses and lowers an expression string in one go; nullopt if it uses anything outside the subset.
+inline std::optional<BytecodeProgram> compileToBytecode(const std::string& expressionStr) {
+    return BytecodeCompiler::compile(ExpressionTreeParser::parse(expressionStr));
+}
@@ -1,6 +1,26 @@
 #pragma once
 
+#include "precision_engine.hpp" // exprtk in float, long double, quad and multi; must precede exprtk.hpp
 #include "exprtk.hpp"
+#include "bytecode.hpp"  // Alternative register-based evaluation backend
+#include "jit.hpp"       // Native x86-64 code for long evaluation loops
+#include "expression_cache.hpp"
+#include "parallel_sampler.hpp" // Multi-threaded sampling for the graphing tool
+#include "sample_buffer.hpp"
+#include "adaptive_sampler.hpp"   // Curvature-driven sampling for the graphing tool
+#include "interval.hpp"           // Guaranteed Y bounds and pole detection
+#include "simplifier.hpp"         // Algebraic rewriting ahead of compilation
+#include "differentiator.hpp"     // Symbolic d/dx
+#include "autodiff.hpp"           // Dual / hyper-dual evaluation for f' and f''
+#include "root_finder.hpp"        // Bracketing plus Brent / Newton refinement
+#include "integrator.hpp"         // Adaptive Gauss-Kronrod quadrature
+#include "series_accumulators.hpp" // Compensated, thread-count independent series reduction
+#include "series_acceleration.hpp" // Limits of infinite series from their partial sums
+#include "factorial.hpp"          // Exact big-integer factorials (prime swing, Karatsuba)
+#include "integer_gcd.hpp"        // Exact binary GCD / LCM of integer batches
+#include "number_theory.hpp"      // Primality, factorization, prime sieve and prime counting
+#include "linear_algebra.hpp"     // Blocked SIMD matrix multiply, LU, Cholesky
+#include "fft.hpp"                // Split-radix / Bluestein FFT and spectral peaks
 #include "termcolor.hpp" // For colored output
 #include <iostream>
 #include <vector>
@@ -9,15 +29,47 @@
 #include <iomanip>    // For std::setprecision, std::fixed
 #include <limits>     // For std::numeric_limits
 #include <algorithm>  // For std::min, std::max (though direct comparison is often used)
+#include <array>
+#include <span>       // For std::span (batch evaluation)
+#include <cctype>     // For std::isalpha, std::isdigit
+#include <string_view>
+#include <memory>
+#include <optional>
+#include <tuple>      // For std::tie
+#include <chrono>     // For timing the root finder
+#include <fstream>    // For saving long factorials
+#include <sstream>
+#include <charconv>   // For std::from_chars
+#include <random>     // For rand(n) test matrices
 // Using namespaces within the .hpp for brevity as it's a self-contained example.
 // In larger projects, prefer 'std::' and 'termcolor::' prefixes or 'using' declarations in .cpp files / specific scopes.
 using namespace std;
 using namespace termcolor;
 
+// Which engine evaluates compiled expressions. exprtk always parses and validates the input;
+// the other tiers then take over for every expression the bytecode tree parser understands.
+enum class EvalBackend {
+    Exprtk,   // Always walk the exprtk node tree
+    Bytecode, // Register-based bytecode VM
+    Jit,      // Native x86-64 code (the bytecode VM where no JIT is available)
+    Auto      // exprtk for short runs, JIT once a loop asks for JIT_SAMPLE_THRESHOLD samples or more
+};
+
 class Calculator {
 public:
-    Calculator() : m_x_val(0), m_graphPlotDensityFactor(1) {
+    // samplingThreads == 0 uses every hardware thread for graph sampling
+    // resultDigits > 0 prints results with that many significant digits instead of the default
+    explicit Calculator(EvalBackend backend = EvalBackend::Auto, unsigned samplingThreads = 0, Precision precision = Precision::Double,
+                        int resultDigits = 0)
+                 : m_x_val(0), m_graphPlotDensityFactor(1),
+                   m_xBlock(), m_yBlock(),
+                   m_xBlockView(m_xBlock.data(), BATCH_LANES), m_yBlockView(m_yBlock.data(), BATCH_LANES),
+                   m_expressionCache(EXPRESSION_CACHE_CAPACITY),
+                   m_evalBackend(backend), m_bytecodeValid(false),
+                   m_parallelSampler(bindStandardSymbols, samplingThreads) {
         setupSymbolTable(); // Initialize the symbol table once
+        setPrecision(precision);
+        m_resultDigits = std::max(resultDigits, 0);
     }
 
     // Main entry point to run the calculator
@@ -25,7 +77,7 @@ public:
         cout << red << bold << underline << "Welcome to SMCTL's sci-calc! version " << APP_VERSION << reset << endl;
         char mode_choice;
         while (true) {
-            cout << green << bold << "\nPlease enter operation: [s]cientific, [g]raphing, [e]xtra (NYI), [q]uit: " << reset;
+            cout << green << bold << "\nPlease enter operation: [s]cientific, [g]raphing, [e]xtra (number theory, matrices), [q]uit: " << reset;
             cin >> mode_choice;
             cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Consume newline
 
@@ -37,7 +89,7 @@ public:
                     showGraphingTool();
                     break;
                 case 'e':
-                    cout << yellow << "Extra features are not yet implemented." << reset << endl;
+                    showExtra();
                     break;
                 case 'q':
                     cout << bright_blue << "Exiting calculator. Goodbye!" << reset << endl;
@@ -54,55 +106,446 @@ private:
     static constexpr const char* APP_VERSION = "2.0 - Refactored";
     static constexpr double PI_CONST = 3.14159265358979323846;
     static constexpr double E_CONST  = 2.71828182845904523536;
+    static constexpr std::size_t BATCH_LANES = 256; // Samples evaluated per walk of the block expression
+    static constexpr std::size_t JIT_SAMPLE_THRESHOLD = 16384; // Auto backend: loops this long are worth native code
+    static constexpr std::size_t EXPRESSION_CACHE_CAPACITY = 64; // Compiled expressions kept for re-use
+    static constexpr std::size_t INTERVAL_MAX_BOXES = 4096; // Branch-and-bound budget for the Y range
+    static constexpr double INTERVAL_RANGE_TOLERANCE = 1e-4; // Of the Y range; far below one text row
+    static constexpr int ROOT_GRID_INTERVALS = 100000; // Default sign-check grid of the root finder
+    static constexpr std::size_t ROOT_BRACKETS_PER_TASK = 256; // Brackets refined per parallel work item
+    static constexpr std::size_t ROOTS_SHOWN = 20; // Roots listed by the root finder; the rest are counted
+    static constexpr double INTEGRATION_TOLERANCE = 1e-10; // Default absolute and relative tolerance
+    static constexpr unsigned long long SERIES_SHARD_TERMS = 1ull << 16; // Series terms folded per parallel work item
+    static constexpr long long SERIES_MAX_INDEX = 1ll << 53; // Beyond this, consecutive integers are not all doubles
+    static constexpr std::uint32_t FACTORIAL_EXACT_LIMIT = 1000000; // Larger n only get the lgamma approximation
+    static constexpr std::size_t FACTORIAL_DIGITS_SHOWN = 1000; // Longer factorials are abbreviated on screen
+    static constexpr std::size_t FACTORIAL_EDGE_DIGITS = 50; // Leading and trailing digits of an abbreviated factorial
+    static constexpr long double FACTORIAL_SIGNIFICAND_LIMIT = 1e15L; // log10(n!) beyond which lgamma leaves no significand
+    static constexpr std::uint64_t PRIME_COUNT_LIMIT = 10000000000000ull; // 10^13: pi(n) takes ~10 s and 50 MB there
+    static constexpr std::uint64_t PRIME_LIST_RANGE = 1000000000ull; // Widest range whose primes are listed
+    static constexpr std::size_t PRIMES_SHOWN = 100; // Primes printed by 'primes'; the rest are counted
+    static constexpr std::size_t MATRIX_SHOWN = 8; // Larger dimensions print only their first and last entries
+    static constexpr std::size_t MATRIX_EDGE_SHOWN = 3; // Entries printed at each end of a larger dimension
+    static constexpr std::uint64_t MATRIX_RANDOM_LIMIT = 8192; // Largest rand(n) and matbench size: 512 MB per matrix
+    static constexpr std::uint64_t MATBENCH_DEFAULT_SIZE = 1024;
+    static constexpr std::uint64_t FFT_DEFAULT_SAMPLES = 1 << 16;
+    static constexpr std::uint64_t FFT_MAX_SAMPLES = 1 << 25; // ~1.5 GB of samples, grid and transform at the top
+    static constexpr std::size_t FFT_PEAKS_SHOWN = 10; // Strongest spectral peaks listed by 'fft'
+    static constexpr double FFT_PEAK_FRACTION = 0.02; // Weaker peaks than this, relative to the strongest, are left out
 
     // --- Member Variables ---
     double m_x_val; // Value for the 'x' variable in expressions
     int m_graphPlotDensityFactor; // Controls how many points are evaluated for graphing relative to width
 
+    // Everything built for one expression string. Entries live in m_expressionCache, so compiling a
+    // string again (re-plotting, re-summing) skips the exprtk parse, the lowering and the JIT.
+    struct CompiledExpression {
+        std::string normalizedStr; // Canonical text: what exprtk compiled and the bytecode tree parser lowers
+        exprtk::expression<double> expression; // Bound to m_symbolTable
+        // Block evaluation: the expression compiled a second time with 'x' bound to a
+        // BATCH_LANES-wide vector, so every node of the exprtk tree processes a whole block per visit.
+        exprtk::expression<double> blockExpression; // Bound to m_blockSymbolTable
+        bool blockExpressionValid = false; // False when the expression must be evaluated one sample at a time
+        bool blockAttempted = false;
+        // Bytecode / JIT tiers, built on demand by prepareEvaluation()
+        std::optional<BytecodeProgram> bytecodeProgram; // Empty if the expression is outside the bytecode subset
+        bool bytecodeLowered = false; // Lowering has been attempted
+        ExprPtr tree; // Simplified syntax tree for interval evaluation; null outside the tree parser's subset
+        bool treeParsed = false;
+        std::unique_ptr<JitFunction> jitFunction; // Set once native code has been generated
+        bool jitAttempted = false;
+    };
+
     // exprtk objects
     exprtk::symbol_table<double> m_symbolTable;
-    exprtk::expression<double> m_expression;
     exprtk::parser<double> m_parser;
     std::string m_currentExpressionStr; // Stores the last successfully compiled expression string
 
+    // Vector-bound variables shared by every cached block expression
+    std::array<double, BATCH_LANES> m_xBlock;
+    std::array<double, BATCH_LANES> m_yBlock;
+    exprtk::vector_view<double> m_xBlockView;
+    exprtk::vector_view<double> m_yBlockView;
+    exprtk::symbol_table<double> m_blockSymbolTable;
+
+    LruCache<std::shared_ptr<CompiledExpression>> m_expressionCache;
+    std::shared_ptr<CompiledExpression> m_compiled; // The current expression; stays valid if evicted
+    std::size_t m_simplifiedExpressions = 0; // Simplifier statistics over every compiled expression
+    std::size_t m_nodesBeforeSimplification = 0;
+    std::size_t m_nodesAfterSimplification = 0;
+
+    EvalBackend m_evalBackend;
+    BytecodeVM m_bytecodeVM;
+    bool m_bytecodeValid; // True when m_bytecodeVM holds the current expression
+
+    ParallelSampler m_parallelSampler; // Per-thread evaluators for long graph sampling runs
+
+    // Forward-mode automatic differentiation: the bytecode of one expression run on dual numbers
+    ProgramEvaluator<Dual> m_dualEvaluator;
+    ProgramEvaluator<HyperDual> m_hyperDualEvaluator;
+    std::shared_ptr<CompiledExpression> m_autodiffSource; // Entry the evaluators were loaded from
+    static_assert(BATCH_LANES <= BytecodeVM::BLOCK_LANES, "Batch blocks must fit in the VM's lane registers");
+
+    // Scalar type of general expressions, finite series and uniform graph samples. Anything but
+    // double goes through the matching engine, created on first use.
+    Precision m_precision = Precision::Double;
+    std::unique_ptr<PrecisionEngine<float>> m_floatEngine;
+    std::unique_ptr<PrecisionEngine<long double>> m_longDoubleEngine;
+#ifdef MATHD_QUADMATH
+    std::unique_ptr<PrecisionEngine<Float128>> m_quadEngine;
+#endif
+    std::unique_ptr<PrecisionEngine<MultiPrecisionFloat>> m_multiEngine;
+    int m_resultDigits = 0; // Significant digits of scientific-mode results; 0 for each precision's default
+
     // --- exprtk Setup ---
     // Custom function for cbrt to be registered with exprtk
     static double exprtk_cbrt_impl(double val) {
         return std::cbrt(val);
     }
 
-    void setupSymbolTable() {
-        m_symbolTable.add_variable("x", m_x_val);
-        m_symbolTable.add_constant("pi", PI_CONST);
-        m_symbolTable.add_constant("e", E_CONST);
-        m_symbolTable.add_function("cbrt", exprtk_cbrt_impl);
+    // Binds 'x' to xVar and adds the constants and functions every expression can use.
+    // Also used for the per-thread symbol tables of m_parallelSampler.
+    static void bindStandardSymbols(exprtk::symbol_table<double>& table, double& xVar) {
+        table.add_variable("x", xVar);
+        table.add_constant("pi", PI_CONST);
+        table.add_constant("e", E_CONST);
+        table.add_function("cbrt", exprtk_cbrt_impl);
         // exprtk typically registers standard math functions (sin, cos, log, etc.) by default.
         // If not, they can be added:
-        // m_symbolTable.add_package(exprtk::common::numeric::package);
-        // m_symbolTable.add_package(exprtk::common::trigonometry::package);
+        // table.add_package(exprtk::common::numeric::package);
+        // table.add_package(exprtk::common::trigonometry::package);
         // etc.
-        m_expression.register_symbol_table(m_symbolTable);
+    }
+
+    void setupSymbolTable() {
+        bindStandardSymbols(m_symbolTable, m_x_val);
+
+        m_blockSymbolTable.add_vector("x", m_xBlockView);
+        m_blockSymbolTable.add_vector("yblk_", m_yBlockView);
+        m_blockSymbolTable.add_constant("pi", PI_CONST);
+        m_blockSymbolTable.add_constant("e", E_CONST);
+    }
+
+    // Returns true if the expression only uses operators and functions that exprtk applies
+    // element-wise to a vector 'x'. Anything else (min/max, %, ternaries, reductions, control
+    // flow, user functions such as cbrt) would silently change meaning in vector form.
+    // Powers are excluded too: the vector form routes every '^' through std::pow, while the
+    // scalar tree specialises integer exponents and ends up several times faster.
+    static bool isBlockEvaluable(const std::string& expressionStr) {
+        static const char* const ELEMENTWISE_IDENTIFIERS[] = {
+            "x", "pi", "e", "sin", "cos", "tan", "asin", "acos", "atan", "sinh", "cosh", "tanh",
+            "asinh", "acosh", "atanh", "exp", "log", "log10", "log2", "sqrt", "abs",
+            "floor", "ceil", "round"
+        };
+        std::size_t i = 0;
+        while (i < expressionStr.size()) {
+            const unsigned char c = expressionStr[i];
+            if (std::isdigit(c) || c == '.') { // Numeric literal, including an optional exponent
+                while (i < expressionStr.size() && (std::isdigit(static_cast<unsigned char>(expressionStr[i])) || expressionStr[i] == '.')) ++i;
+                if (i + 1 < expressionStr.size() && (expressionStr[i] == 'e' || expressionStr[i] == 'E')) {
+                    std::size_t j = i + 1;
+                    if (expressionStr[j] == '+' || expressionStr[j] == '-') ++j;
+                    if (j < expressionStr.size() && std::isdigit(static_cast<unsigned char>(expressionStr[j]))) {
+                        i = j;
+                        while (i < expressionStr.size() && std::isdigit(static_cast<unsigned char>(expressionStr[i]))) ++i;
+                    }
+                }
+            } else if (std::isalpha(c) || c == '_') {
+                std::size_t start = i;
+                while (i < expressionStr.size() && (std::isalnum(static_cast<unsigned char>(expressionStr[i])) || expressionStr[i] == '_')) ++i;
+                const std::string ident = expressionStr.substr(start, i - start);
+                if (std::find(std::begin(ELEMENTWISE_IDENTIFIERS), std::end(ELEMENTWISE_IDENTIFIERS), ident) == std::end(ELEMENTWISE_IDENTIFIERS)) {
+                    return false;
+                }
+            } else if (std::string_view("+-*/()<>=!, \t").find(static_cast<char>(c)) != std::string_view::npos) {
+                ++i;
+            } else {
+                return false; // %, ?, :, ;, [, ', etc.
+            }
+        }
+        return true;
     }
 
     // Compiles the given expression string. Returns true on success, false on error.
-    // Stores the compiled expression in m_expression and the string in m_currentExpressionStr.
+    // Makes it the current expression (m_compiled) and stores the string in m_currentExpressionStr.
+    // Expressions the tree parser understands are simplified first and compiled in canonical form,
+    // which is also their cache key, so "x*x+1" and "1 + x^2" share one entry. A string seen before
+    // is not parsed again at all; failures are never cached.
     bool compileExpression(const std::string& expressionStr) {
-        if (!m_parser.compile(expressionStr, m_expression)) {
-            cerr << red << "Error parsing expression: " << m_parser.error() << reset << endl;
-            m_currentExpressionStr.clear(); // Clear invalid expression
-            return false;
+        const std::string key = normalizeExpressionKey(expressionStr);
+        if (std::shared_ptr<CompiledExpression>* cached = m_expressionCache.find(key)) {
+            m_compiled = *cached;
+        } else {
+            const ExprPtr parsed = ExpressionTreeParser::parse(key);
+            const ExprPtr simplified = parsed ? simplifyExpression(parsed) : nullptr;
+            const std::string canonical = simplified ? formatExpression(simplified) : key;
+            std::shared_ptr<CompiledExpression>* equivalent = (canonical != key) ? m_expressionCache.find(canonical) : nullptr;
+            if (equivalent) {
+                std::shared_ptr<CompiledExpression> shared = *equivalent;
+                m_compiled = m_expressionCache.insert(key, std::move(shared)); // This spelling now hits directly
+            } else {
+                auto entry = std::make_shared<CompiledExpression>();
+                entry->normalizedStr = canonical;
+                entry->tree = simplified;
+                entry->treeParsed = simplified != nullptr;
+                entry->expression.register_symbol_table(m_symbolTable);
+                bool compiled = canonical != key && m_parser.compile(canonical, entry->expression);
+                if (!compiled) { // Nothing was rewritten (or exprtk rejects the rewrite): compile as typed
+                    entry->normalizedStr = key;
+                    compiled = m_parser.compile(expressionStr, entry->expression);
+                }
+                if (!compiled) {
+                    cerr << red << "Error parsing expression: " << m_parser.error() << reset << endl;
+                    m_currentExpressionStr.clear(); // Clear invalid expression
+                    m_compiled.reset();
+                    m_bytecodeValid = false;
+                    return false;
+                }
+                if (simplified) reportSimplification(canonical, countExprNodes(parsed), countExprNodes(simplified));
+                const std::string entryKey = entry->normalizedStr;
+                m_compiled = m_expressionCache.insert(entryKey, std::move(entry));
+                if (entryKey != key) m_expressionCache.insert(key, m_compiled);
+            }
         }
         m_currentExpressionStr = expressionStr;
+
+        m_bytecodeValid = false; // The VM may hold a different entry's program
+        prepareEvaluation(1); // Bytecode and Jit backends switch over right away; Auto waits for a long loop
+        if (!m_bytecodeValid && !m_compiled->blockAttempted) {
+            // Best effort: if the vector form does not compile, evaluateBatch() falls back to scalar walks.
+            m_compiled->blockAttempted = true;
+            m_compiled->blockExpression.register_symbol_table(m_blockSymbolTable);
+            m_compiled->blockExpressionValid = isBlockEvaluable(m_compiled->normalizedStr) &&
+                m_parser.compile("yblk_ := (" + m_compiled->normalizedStr + ")", m_compiled->blockExpression);
+        }
         return true;
     }
 
+    // Tallies a simplified expression and shows the rewrite if it saved any evaluation work
+    void reportSimplification(const std::string& canonical, std::size_t nodesBefore, std::size_t nodesAfter) {
+        ++m_simplifiedExpressions;
+        m_nodesBeforeSimplification += nodesBefore;
+        m_nodesAfterSimplification += nodesAfter;
+        if (nodesAfter < nodesBefore) {
+            cout << bright_cyan << "Simplified to " << canonical << " (" << nodesBefore << " -> " << nodesAfter << " nodes)" << reset << endl;
+        }
+    }
+
     // Evaluates the currently compiled expression.
-    // Assumes m_expression is valid and compiled.
+    // Assumes m_compiled is valid and compiled.
     // For expressions involving 'x', m_x_val should be set before calling.
     double evaluateCurrentlyCompiledExpression() {
-        return m_expression.value();
+        if (m_compiled->jitFunction) return m_compiled->jitFunction->evaluate(m_x_val);
+        return m_bytecodeValid ? m_bytecodeVM.evaluate(m_x_val) : m_compiled->expression.value();
+    }
+
+    // Selects the evaluation tier before a loop evaluates the current expression sampleCount times.
+    // Tiers are built lazily and only ever move up for a given compiled expression.
+    void prepareEvaluation(std::size_t sampleCount) {
+        const bool wantJit = m_evalBackend == EvalBackend::Jit ||
+                             (m_evalBackend == EvalBackend::Auto && sampleCount >= JIT_SAMPLE_THRESHOLD);
+        if (!wantJit && m_evalBackend != EvalBackend::Bytecode) return;
+        if (!m_compiled) return;
+
+        CompiledExpression& compiled = *m_compiled;
+        if (!lowerToBytecode(compiled)) return; // Outside the bytecode subset: stay on exprtk
+        if (!m_bytecodeValid) {
+            m_bytecodeVM.load(*compiled.bytecodeProgram);
+            m_bytecodeValid = true;
+        }
+        if (wantJit && !compiled.jitAttempted) {
+            compiled.jitAttempted = true;
+            compiled.jitFunction = JitFunction::compile(*compiled.bytecodeProgram); // nullptr keeps us on the VM
+        }
+    }
+
+    // The entry's bytecode program, lowered on first use; nullptr outside the bytecode subset
+    static const BytecodeProgram* lowerToBytecode(CompiledExpression& compiled) {
+        if (!compiled.bytecodeLowered) {
+            compiled.bytecodeLowered = true;
+            compiled.bytecodeProgram = compileToBytecode(compiled.normalizedStr);
+        }
+        return compiled.bytecodeProgram ? &*compiled.bytecodeProgram : nullptr;
+    }
+
+    // Loads the current expression into the dual and hyper-dual evaluators, which keep it until the
+    // next call. Returns false outside the bytecode subset, which is all they can run.
+    bool prepareAutodiff() {
+        if (!m_compiled) return false;
+        if (m_autodiffSource == m_compiled) return true;
+        const BytecodeProgram* program = lowerToBytecode(*m_compiled);
+        if (!program) return false;
+        m_dualEvaluator.load(*program);
+        m_hyperDualEvaluator.load(*program);
+        m_autodiffSource = m_compiled;
+        return true;
+    }
+
+    // f'(x) (order 1, one dual pass) or f''(x) (order 2, one hyper-dual pass) at every x in xs, for
+    // the expression last loaded by prepareAutodiff()
+    void evaluateDerivativeBatch(int order, std::span<const double> xs, std::span<double> ys) {
+        const std::size_t count = std::min(xs.size(), ys.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            ys[i] = (order == 1) ? m_dualEvaluator.evaluate(Dual::variable(xs[i])).d
+                                 : m_hyperDualEvaluator.evaluate(HyperDual::variable(xs[i])).e12;
+        }
+    }
+
+    // Evaluates the currently compiled expression at every x in xs, writing f(x) to ys.
+    // JIT code handles the span in one call. Otherwise input is processed in blocks of BATCH_LANES:
+    // the bytecode VM and element-wise exprtk expressions run once per block, anything else walks
+    // the tree once per sample through m_x_val.
+    void evaluateBatch(std::span<const double> xs, std::span<double> ys) {
+        const std::size_t count = std::min(xs.size(), ys.size());
+        if (m_compiled->jitFunction) { // Native code loops over the whole span itself
+            m_compiled->jitFunction->evaluate(xs.data(), ys.data(), count);
+            return;
+        }
+        for (std::size_t base = 0; base < count; base += BATCH_LANES) {
+            const std::size_t lanes = std::min(BATCH_LANES, count - base);
+            if (m_bytecodeValid) {
+                m_bytecodeVM.evaluateBlock(xs.data() + base, ys.data() + base, lanes);
+            } else if (m_compiled->blockExpressionValid) {
+                std::copy_n(xs.begin() + base, lanes, m_xBlock.begin());
+                // Pad a partial block with a valid sample so the unused lanes stay well-defined
+                std::fill(m_xBlock.begin() + lanes, m_xBlock.end(), xs[base + lanes - 1]);
+                m_compiled->blockExpression.value();
+                std::copy_n(m_yBlock.begin(), lanes, ys.begin() + base);
+            } else {
+                for (std::size_t i = 0; i < lanes; ++i) {
+                    m_x_val = xs[base + i];
+                    ys[base + i] = evaluateCurrentlyCompiledExpression();
+                }
+            }
+        }
     }
     
+    // evaluateBatch() spread over m_parallelSampler's threads, in chunks of CHUNK_SAMPLES, when the
+    // batch is long enough to be worth it. Each chunk is evaluated the same way on any thread count.
+    void evaluateBatchParallel(std::span<const double> xs, std::span<double> ys) {
+        const std::size_t count = std::min(xs.size(), ys.size());
+        if (!prepareParallelSampling(count)) {
+            evaluateBatch(xs, ys);
+            return;
+        }
+        m_parallelSampler.forEach(ParallelSampler::chunkCount(count), [&](std::size_t chunk, ParallelSampler::Evaluator& worker) {
+            const std::size_t begin = chunk * ParallelSampler::CHUNK_SAMPLES;
+            worker.evaluate(xs.data() + begin, ys.data() + begin, std::min(ParallelSampler::CHUNK_SAMPLES, count - begin));
+        });
+    }
+
+    // Readies m_parallelSampler for sampleCount samples of the current expression on the tier the
+    // calculator itself would use. Returns false if the run is too short to be worth threads.
+    bool prepareParallelSampling(std::size_t sampleCount) {
+        return m_compiled && m_parallelSampler.worthParallel(sampleCount) && prepareParallelWorkers();
+    }
+
+    // Readies m_parallelSampler's per-thread evaluators for the current expression. Workers get the
+    // bytecode program whenever the expression lowers, so they can also run it on dual numbers.
+    bool prepareParallelWorkers() {
+        const BytecodeProgram* program = lowerToBytecode(*m_compiled);
+        ParallelSampler::Tier tier = ParallelSampler::Tier::Exprtk;
+        if (m_compiled->jitFunction) tier = ParallelSampler::Tier::Jit;
+        else if (m_bytecodeValid) tier = ParallelSampler::Tier::Bytecode;
+        return m_parallelSampler.prepare(m_compiled->normalizedStr, program, tier);
+    }
+
+    // Switches the scientific and graphing modes to another precision; quad needs a build with
+    // MATHD_QUADMATH. Returns false (after saying why) if the precision is not available.
+    bool setPrecision(Precision precision) {
+        if (!precisionAvailable(precision)) {
+            cerr << red << "Quad precision needs a build with libquadmath (MATHD_QUADMATH); staying in "
+                 << precisionName(m_precision) << "." << reset << endl;
+            return false;
+        }
+        m_precision = precision;
+        return true;
+    }
+
+    template <typename Scalar>
+    static PrecisionEngine<Scalar>& engineFor(std::unique_ptr<PrecisionEngine<Scalar>>& engine) {
+        if (!engine) engine = std::make_unique<PrecisionEngine<Scalar>>();
+        return *engine;
+    }
+
+    // Calls use(engine) with the engine of the current precision. Returns false in double precision,
+    // which the calculator's own tiers handle.
+    template <typename Use>
+    bool withPrecisionEngine(Use&& use) {
+        switch (m_precision) {
+            case Precision::Float: use(engineFor(m_floatEngine)); return true;
+            case Precision::LongDouble: use(engineFor(m_longDoubleEngine)); return true;
+            case Precision::Quad:
+#ifdef MATHD_QUADMATH
+                use(engineFor(m_quadEngine));
+                return true;
+#else
+                break; // setPrecision() never selects it
+#endif
+            case Precision::Multi: use(engineFor(m_multiEngine)); return true;
+            case Precision::Double: break;
+        }
+        return false;
+    }
+
+    // value with the requested number of significant digits, or all that Scalar always preserves
+    template <typename Scalar>
+    std::string formatInPrecision(const Scalar& value) const {
+        return PrecisionEngine<Scalar>::format(value, m_resultDigits > 0 ? m_resultDigits : PrecisionEngine<Scalar>::DIGITS);
+    }
+
+    // Compiles exprStr in the engine of the current precision, reporting errors like compileExpression()
+    template <typename Scalar>
+    static bool compileInPrecision(PrecisionEngine<Scalar>& engine, const std::string& exprStr) {
+        if (engine.compile(exprStr)) return true;
+        cerr << red << "Error parsing expression: " << engine.error() << reset << endl;
+        return false;
+    }
+
+    // Scientific-mode "precision [name] [digits]": shows or changes the precision, and the number of
+    // significant digits results are printed with ("default" for the precision's own)
+    void showPrecisionCommand(const std::string& inputStr) {
+        std::istringstream in(inputStr.substr(std::string_view("precision").size()));
+        std::vector<std::string> words;
+        for (std::string word; in >> word;) words.push_back(word);
+        if (words.size() >= 2 && words[0] == "long" && words[1] == "double") words.erase(words.begin() + 1);
+        std::string name, digits;
+        for (const std::string& word : words) {
+            const bool isDigits = word == "default" || word.find_first_not_of("0123456789") == std::string::npos;
+            (isDigits ? digits : name) = word;
+        }
+        if (!name.empty()) {
+            const std::optional<Precision> precision = precisionFromName(name);
+            if (!precision) {
+                cerr << red << "Unknown precision '" << name << "': use float, double, long, quad or multi." << reset << endl;
+                return;
+            }
+            if (!setPrecision(*precision)) return;
+        }
+        if (digits == "default") {
+            m_resultDigits = 0;
+        } else if (!digits.empty()) {
+            int count = 0;
+            const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), count);
+            if (error != std::errc() || end != digits.data() + digits.size() || count < 1) {
+                cerr << red << "Invalid digit count '" << digits << "': use a positive number or 'default'." << reset << endl;
+                return;
+            }
+            m_resultDigits = count;
+        }
+        const int maxDigits = precisionMaxDigits(m_precision);
+        cout << bright_cyan << "Precision: " << precisionName(m_precision) << ", results to "
+             << (m_resultDigits > 0 ? std::min(m_resultDigits, maxDigits) : precisionDigits(m_precision)) << " digits";
+        if (m_precision != Precision::Double) cout << " (general expressions, finite series and uniform graphs; the rest stays double)";
+        cout << reset << endl;
+        if (m_resultDigits > maxDigits) {
+            cout << yellow << precisionName(m_precision) << " holds at most " << maxDigits << " digits";
+            if (m_precision != Precision::Multi) cout << "; 'precision multi' holds " << precisionMaxDigits(Precision::Multi);
+            else cout << "; rebuild with a larger MATHD_MULTI_LIMBS for more";
+            cout << "." << reset << endl;
+        }
+    }
+
     // Evaluates a new expression string. Compiles it first.
     // This is for one-off evaluations. For loops, compile once then update m_x_val.
     double evaluateNewExpression(const std::string& expressionStr) {
@@ -112,93 +555,608 @@ private:
         return NAN; // Return NaN on error
     }
 
+    // Number of leading "d/dx" prefixes of input; body receives the expression after them
+    static int splitDerivativeCommand(std::string_view input, std::string& body) {
+        static constexpr std::string_view DERIVATIVE_PREFIX = "d/dx";
+        int order = 0;
+        while (true) {
+            const std::size_t start = input.find_first_not_of(" \t");
+            input.remove_prefix(start == std::string_view::npos ? input.size() : start);
+            if (input.substr(0, DERIVATIVE_PREFIX.size()) != DERIVATIVE_PREFIX) break;
+            input.remove_prefix(DERIVATIVE_PREFIX.size());
+            ++order;
+        }
+        body = std::string(input);
+        return order;
+    }
 
-    // --- Core Calculation Functions ---
-    long long calculateFactorial(int n_val) {
-        if (n_val < 0) return 0; // Factorial not defined for negative numbers
-        if (n_val > 20) { // Prevent overflow for long long
-            cerr << yellow << "Factorial for n > 20 might overflow." << reset << endl;
-            // Or return a specific error code / throw exception
+    // Handles the "d/dx" command: each leading "d/dx" is stripped and the rest of exprStr replaced by
+    // its symbolic derivative ("d/dx d/dx f" is f''). The result is ordinary expression text, so it is
+    // compiled and cached like anything the user types. Returns false (after saying why) on failure.
+    bool expandDerivativeCommand(std::string& exprStr) {
+        std::string body;
+        const int order = splitDerivativeCommand(exprStr, body);
+        if (order == 0) return true;
+
+        ExprPtr tree = ExpressionTreeParser::parse(normalizeExpressionKey(body));
+        if (!tree) {
+            cerr << red << "d/dx needs an expression in x using the standard operators and functions." << reset << endl;
+            return false;
         }
-        long long result = 1;
-        for (int i = 1; i <= n_val; ++i) {
-            result *= i;
+        for (int i = 0; i < order && tree; ++i) tree = differentiateExpression(tree);
+        if (!tree) {
+            cerr << red << "No symbolic derivative: x % f(x) cannot be differentiated." << reset << endl;
+            return false;
         }
-        return result;
+        const std::string derivativeStr = formatExpression(tree);
+        cout << bright_cyan;
+        for (int i = 0; i < order; ++i) cout << "d/dx ";
+        cout << "[" << body << "] = " << derivativeStr << reset << endl;
+        exprStr = derivativeStr;
+        return true;
     }
 
-    double calculateGcd(double a_val, double b_val) {
-        // Using std::fmod for doubles. Note: GCD for non-integers can be tricky.
-        // This implementation assumes integer-like behavior.
-        a_val = std::abs(a_val);
-        b_val = std::abs(b_val);
-        while (std::abs(b_val) > 1e-9) { // Tolerance for double comparison
-            double temp = b_val;
-            b_val = std::fmod(a_val, b_val);
-            a_val = temp;
+    // Scientific-mode "d/dx f": shows f' and optionally evaluates it at a point. First and second
+    // derivatives are evaluated by one hyper-dual pass over f, which also gives f and f''.
+    void showDerivative(const std::string& inputStr) {
+        std::string body;
+        const int order = splitDerivativeCommand(inputStr, body);
+        std::string derivativeStr = inputStr;
+        if (!expandDerivativeCommand(derivativeStr) || !compileExpression(derivativeStr)) return;
+        cout << bright_blue << "Evaluate at x (blank to skip): " << reset;
+        string pointStr;
+        getline(cin, pointStr);
+        if (pointStr.empty()) return;
+        const double point = evaluateNewExpression(pointStr); // Allows "pi/4" and the like
+        if (std::isnan(point)) return;
+
+        double result;
+        if (order <= 2 && compileExpression(body) && prepareAutodiff()) {
+            const HyperDual jet = m_hyperDualEvaluator.evaluate(HyperDual::variable(point));
+            cout << bright_cyan << setprecision(10) << "f = " << jet.value << ", f' = " << jet.e1 << ", f'' = " << jet.e12
+                 << " (automatic differentiation)" << reset << endl;
+            result = (order == 1) ? jet.e1 : jet.e12;
+        } else {
+            if (!compileExpression(derivativeStr)) return;
+            m_x_val = point;
+            result = evaluateCurrentlyCompiledExpression();
         }
-        return a_val;
+        cout << red << underline << bold << fixed << setprecision(10) << "Result: " << result << reset << endl;
     }
 
-    double calculateLcm(double a_val, double b_val) {
-        if (std::abs(a_val) < 1e-9 || std::abs(b_val) < 1e-9) return 0; // LCM with zero is zero
-        double gcd_val = calculateGcd(a_val, b_val);
-        if (std::abs(gcd_val) < 1e-9) return NAN; // Should not happen if a or b is non-zero
-        return std::abs(a_val * b_val) / gcd_val;
-    }
+    // Scientific-mode "f": exact n! for n up to FACTORIAL_EXACT_LIMIT, or n! ~ significand * 10^power
+    // from lgamma for any n >= 0 (non-integers give Gamma(n + 1)). Long exact results are abbreviated
+    // on screen and can be streamed to a file in full.
+    void showFactorial() {
+        string tempInput;
+        cout << bright_blue << "Enter integer value for factorial n: " << reset;
+        getline(cin, tempInput);
+        long double n = 0.0L;
+        try {
+            n = std::stold(tempInput);
+        } catch (const std::exception&) {
+            cerr << red << "Invalid value for n: " << tempInput << reset << endl;
+            return;
+        }
+        if (!(n >= 0.0L) || std::isinf(n)) {
+            cerr << red << "Factorial is only defined here for finite n >= 0." << reset << endl;
+            return;
+        }
+        bool exact = n == std::floor(n) && n <= FACTORIAL_EXACT_LIMIT;
+        if (exact) {
+            cout << bright_blue << "[e]xact or [a]pproximate (default e): " << reset;
+            getline(cin, tempInput);
+            exact = tempInput.empty() || std::tolower(static_cast<unsigned char>(tempInput[0])) != 'a';
+        }
+        if (!exact) {
+            const long double log10Value = log10Factorial(n);
+            cout << red << underline << bold << defaultfloat << setprecision(15) << "Factorial(" << static_cast<double>(n) << ") ~ ";
+            if (log10Value < FACTORIAL_SIGNIFICAND_LIMIT) {
+                const long double power = std::floor(log10Value);
+                const int reliableDigits = std::clamp(18 - static_cast<int>(std::log10(std::max(1.0L, log10Value))), 1, 15);
+                cout << setprecision(reliableDigits) << static_cast<double>(std::pow(10.0L, log10Value - power)) << "e+"
+                     << static_cast<long long>(power);
+            } else { // The significand would be all rounding error: give the magnitude only
+                cout << "10^" << static_cast<double>(log10Value);
+            }
+            cout << reset << endl;
+            return;
+        }
 
-    // Calculates product of f(x) from start_x to end_x (integer steps)
-    double calculateProductSeries(const std::string& exprStr, int start_x, int end_x) {
-        if (!compileExpression(exprStr)) {
-            return NAN;
+        const std::uint32_t n_val = static_cast<std::uint32_t>(n);
+        const auto start = std::chrono::steady_clock::now();
+        const BigUnsigned result = calculateFactorial(n_val);
+        const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const std::size_t digits = result.digitCount();
+        cout << red << underline << bold << "Factorial(" << n_val << ") = ";
+        if (digits <= FACTORIAL_DIGITS_SHOWN) {
+            result.writeDecimal(cout);
+        } else {
+            cout << result.leadingDigits(FACTORIAL_EDGE_DIGITS) << "..." << result.trailingDigits(FACTORIAL_EDGE_DIGITS);
         }
-        double totalProduct = 1.0;
-        for (int i = start_x; i <= end_x; ++i) {
-            m_x_val = static_cast<double>(i);
-            totalProduct *= evaluateCurrentlyCompiledExpression();
-            if (std::isnan(totalProduct) || std::isinf(totalProduct)) break; // Stop on invalid result
+        cout << reset << endl;
+        cout << bright_cyan << digits << " digits, " << fixed << setprecision(2) << elapsedMs << " ms" << reset << endl;
+        if (digits <= FACTORIAL_DIGITS_SHOWN) return;
+
+        cout << bright_blue << "Write all digits to file (path, blank to skip): " << reset;
+        getline(cin, tempInput);
+        if (tempInput.empty()) return;
+        std::ofstream file(tempInput);
+        result.writeDecimal(file);
+        file << '\n';
+        if (!file) {
+            cerr << red << "Could not write " << tempInput << reset << endl;
+            return;
         }
-        return totalProduct;
+        cout << yellow << "Wrote " << digits << " digits to " << tempInput << reset << endl;
     }
 
-    // Calculates sum of f(x) from start_x to end_x (integer steps)
-    double calculateSumSeries(const std::string& exprStr, int start_x, int end_x) {
-        if (!compileExpression(exprStr)) {
-            return NAN;
+    // Scientific-mode "g" and "l": the exact GCD or LCM of a list of integers of any size, typed in or
+    // read from a file ("@path"). Long results are abbreviated like factorials.
+    void showGcdLcm(bool lcm) {
+        const char* name = lcm ? "LCM" : "GCD";
+        string tempInput;
+        cout << bright_blue << "Enter integers separated by spaces or commas, or @path to read them from a file: " << reset;
+        getline(cin, tempInput);
+        std::string text = tempInput;
+        if (!tempInput.empty() && tempInput[0] == '@') {
+            std::ifstream file(tempInput.substr(1));
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            if (!file) {
+                cerr << red << "Could not read " << tempInput.substr(1) << reset << endl;
+                return;
+            }
+            text = contents.str();
         }
-        double totalSum = 0.0;
-        for (int i = start_x; i <= end_x; ++i) {
-            m_x_val = static_cast<double>(i);
-            totalSum += evaluateCurrentlyCompiledExpression();
-            if (std::isnan(totalSum) && !(i==start_x && std::isnan(m_expression.value())) ) break; // Stop on invalid result unless first term is NaN
+        IntegerBatch batch;
+        std::string badToken;
+        if (!batch.parse(text, badToken)) {
+            cerr << red << "Not an integer: " << badToken << reset << endl;
+            return;
+        }
+        if (batch.size() == 0) {
+            cerr << red << "No integers given." << reset << endl;
+            return;
         }
-        return totalSum;
+
+        const auto start = std::chrono::steady_clock::now();
+        const BigNatural result = lcm ? calculateLcm(batch) : calculateGcd(batch);
+        const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const std::string digits = result.toDecimal();
+        cout << red << underline << bold << name << " = ";
+        if (digits.size() <= FACTORIAL_DIGITS_SHOWN) {
+            cout << digits;
+        } else {
+            cout << digits.substr(0, FACTORIAL_EDGE_DIGITS) << "..." << digits.substr(digits.size() - FACTORIAL_EDGE_DIGITS);
+        }
+        cout << reset << endl;
+        cout << bright_cyan << batch.size() << (batch.size() == 1 ? " integer, " : " integers, ");
+        if (digits.size() > FACTORIAL_DIGITS_SHOWN) cout << digits.size() << " digits, ";
+        cout << fixed << setprecision(2) << elapsedMs << " ms" << reset << endl;
     }
 
-    // Calculates Min and Max Y values for an expression over an X range
-    void calculateMinMaxY(const std::string& exprStr, double xMin, double xMax, int numSamples, double& outMinY, double& outMaxY) {
-        outMinY = std::numeric_limits<double>::infinity();
-        outMaxY = -std::numeric_limits<double>::infinity();
+    // Scientific-mode "r": every zero of f on [xMin, xMax]. f is sampled on a grid like a graph (so
+    // long grids run threaded and as native code), and each sign change is refined to a root.
+    // Roots closer together than the grid spacing, and roots where f touches zero without crossing
+    // it, can be missed.
+    void showRoots() {
+        string exprStr, tempInput;
+        cout << bright_blue << "Enter function f(x): " << reset;
+        getline(cin, exprStr);
+        cout << bright_blue << "Enter X-min: " << reset;
+        getline(cin, tempInput);
+        const double xMin = evaluateNewExpression(tempInput); // Allows "-10*pi" and the like
+        cout << bright_blue << "Enter X-max: " << reset;
+        getline(cin, tempInput);
+        const double xMax = evaluateNewExpression(tempInput);
+        int intervals = ROOT_GRID_INTERVALS;
+        cout << bright_blue << "Enter grid intervals (default " << intervals << "): " << reset;
+        getline(cin, tempInput);
+        if (!tempInput.empty()) intervals = std::max(1, std::stoi(tempInput));
+        cout << bright_blue << "Refine with [n]ewton or [b]rent (default n): " << reset;
+        getline(cin, tempInput);
+        const bool useNewton = tempInput.empty() || std::tolower(static_cast<unsigned char>(tempInput[0])) != 'b';
+        if (std::isnan(xMin) || std::isnan(xMax)) return;
 
-        if (xMin >= xMax || numSamples <= 0) {
-             cerr << yellow << "Invalid range or zero samples for MinMaxY calculation." << reset << endl;
-            outMinY = NAN; outMaxY = NAN;
+        const auto start = std::chrono::steady_clock::now();
+        SampleBuffer grid;
+        if (!sampleExpression(exprStr, xMin, xMax, intervals + 1, grid)) return;
+        const RootFindingResult found = findRootsInSamples(grid, useNewton);
+        const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        cout << bright_cyan << "Found " << found.roots.size() << " roots in [" << xMin << ", " << xMax << "] ("
+             << found.brackets << " sign changes, " << found.discontinuities << " poles or jumps skipped, "
+             << found.evaluations << " " << (found.newton ? "Newton" : "Brent") << " evaluations, "
+             << fixed << setprecision(2) << elapsedMs << " ms)" << reset << endl;
+        for (std::size_t i = 0; i < std::min(found.roots.size(), ROOTS_SHOWN); ++i) {
+            cout << red << bold << fixed << setprecision(10) << "x = " << found.roots[i] << reset << endl;
+        }
+        if (found.roots.size() > ROOTS_SHOWN) {
+            cout << yellow << "... and " << found.roots.size() - ROOTS_SHOWN << " more." << reset << endl;
+        }
+    }
+
+    // Scientific-mode "fft f(x)" or "fft @path": the strongest frequencies of f sampled on a uniform
+    // grid over [xMin, xMax), or of the numbers in a file taken at a fixed spacing. The grid is
+    // sampled like a graph (threaded and as native code when long); the transform is fft.hpp's, a
+    // real-input split-radix FFT for powers of two and Bluestein's algorithm for other counts.
+    void showSpectrum(const std::string& argument) {
+        const std::size_t first = argument.find_first_not_of(' ');
+        if (first == std::string::npos) {
+            cerr << red << "Usage: fft f(x) or fft @path" << reset << endl;
             return;
         }
-        if (!compileExpression(exprStr)) { // Compile the expression once
-            outMinY = NAN; outMaxY = NAN;
+        const std::string source = argument.substr(first);
+        string tempInput;
+        std::vector<double> samples;
+        double xMin = 0.0, spacing = 1.0, samplingMs = 0.0;
+        if (source[0] == '@') {
+            std::ifstream file(source.substr(1));
+            if (!file) {
+                cerr << red << "Could not read " << source.substr(1) << reset << endl;
+                return;
+            }
+            std::string token;
+            while (file >> token) {
+                char* end = nullptr;
+                const double value = std::strtod(token.c_str(), &end);
+                if (end != token.c_str() + token.size()) {
+                    cerr << red << "Not a number: " << token << reset << endl;
+                    return;
+                }
+                samples.push_back(value);
+            }
+            cout << bright_blue << "Enter sample spacing (default 1): " << reset;
+            getline(cin, tempInput);
+            if (!tempInput.empty()) spacing = evaluateNewExpression(tempInput);
+        } else {
+            cout << bright_blue << "Enter X-min (default 0): " << reset;
+            getline(cin, tempInput);
+            if (!tempInput.empty()) xMin = evaluateNewExpression(tempInput); // Allows "-10*pi" and the like
+            double xMax = 2.0 * PI_CONST;
+            cout << bright_blue << "Enter X-max (default 2*pi): " << reset;
+            getline(cin, tempInput);
+            if (!tempInput.empty()) xMax = evaluateNewExpression(tempInput);
+            std::uint64_t count = FFT_DEFAULT_SAMPLES;
+            cout << bright_blue << "Enter number of samples (default " << FFT_DEFAULT_SAMPLES << ", e.g. 2^20): " << reset;
+            getline(cin, tempInput);
+            if (!tempInput.empty()) {
+                const std::optional<std::uint64_t> parsed = parseNaturalNumber(tempInput);
+                if (!parsed || *parsed < 4 || *parsed > FFT_MAX_SAMPLES) {
+                    cerr << red << "The number of samples must be from 4 to 2^25." << reset << endl;
+                    return;
+                }
+                count = *parsed;
+            }
+            if (!std::isfinite(xMin) || !std::isfinite(xMax) || xMin >= xMax) {
+                cerr << red << "X-min and X-max must be finite, with X-min < X-max." << reset << endl;
+                return;
+            }
+            spacing = (xMax - xMin) / static_cast<double>(count); // Periodic grid: xMax itself is the next period's first sample
+            const auto start = std::chrono::steady_clock::now();
+            SampleBuffer grid;
+            if (!sampleExpression(source, xMin, xMax - spacing, static_cast<int>(count), grid)) return;
+            samples = std::move(grid.ys);
+            samplingMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (samples.size() < 4 || samples.size() > FFT_MAX_SAMPLES) {
+            cerr << red << "A spectrum needs from 4 to 2^25 samples, not " << samples.size() << "." << reset << endl;
             return;
         }
+        if (!std::isfinite(spacing) || spacing <= 0.0) {
+            cerr << red << "The sample spacing must be a positive number." << reset << endl;
+            return;
+        }
+        const auto nonFinite = std::find_if(samples.begin(), samples.end(), [](double y) { return !std::isfinite(y); });
+        if (nonFinite != samples.end()) {
+            cerr << red << "Sample " << (nonFinite - samples.begin()) << " (x = " << xMin + spacing * static_cast<double>(nonFinite - samples.begin())
+                 << ") is not finite; a spectrum needs finite values." << reset << endl;
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        NeumaierSum total;
+        for (const double y : samples) total.add(y);
+        const std::vector<SpectralPeak> peaks = spectralPeaks(samples, FFT_PEAKS_SHOWN, FFT_PEAK_FRACTION);
+        const double fftMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const double n = static_cast<double>(samples.size());
+        const double resolution = 1.0 / (n * spacing); // Cycles per unit of x between neighbouring bins
+        cout << bright_cyan << defaultfloat << setprecision(6) << samples.size() << " samples, spacing " << spacing << ", Hann window, resolution "
+             << resolution << " cycles per unit" << reset << endl;
+        cout << red << underline << bold << defaultfloat << setprecision(10) << "Mean: " << total.value() / n << reset << endl;
+        if (peaks.empty()) {
+            cout << yellow << "No peaks: the samples are constant." << reset << endl;
+        } else {
+            cout << bright_green << right << setw(18) << "frequency" << setw(18) << "angular freq." << setw(18) << "period" << setw(18) << "amplitude" << reset << endl;
+            for (const SpectralPeak& peak : peaks) {
+                const double frequency = peak.bin * resolution;
+                cout << red << bold << defaultfloat << setprecision(8) << setw(18) << frequency << setw(18) << 2.0 * PI_CONST * frequency
+                     << setw(18) << 1.0 / frequency << setw(18) << peak.amplitude << reset << endl;
+            }
+        }
+        cout << bright_cyan << fixed << setprecision(2);
+        if (samplingMs > 0.0) cout << "Sampling " << samplingMs << " ms, ";
+        cout << "FFT " << fftMs << " ms" << reset << endl;
+    }
+
+    // Scientific-mode "i": the integral of f over [a, b] by adaptive Gauss-Kronrod quadrature. Every
+    // round's nodes are evaluated as one batch, threaded when it is long enough.
+    void showIntegral() {
+        string exprStr, tempInput;
+        cout << bright_blue << "Enter function f(x): " << reset;
+        getline(cin, exprStr);
+        cout << bright_blue << "Enter lower limit a: " << reset;
+        getline(cin, tempInput);
+        const double lower = evaluateNewExpression(tempInput);
+        cout << bright_blue << "Enter upper limit b: " << reset;
+        getline(cin, tempInput);
+        const double upper = evaluateNewExpression(tempInput);
+        IntegrationOptions options;
+        options.absoluteTolerance = options.relativeTolerance = INTEGRATION_TOLERANCE;
+        cout << bright_blue << "Enter tolerance (default " << INTEGRATION_TOLERANCE << "): " << reset;
+        getline(cin, tempInput);
+        if (!tempInput.empty()) options.absoluteTolerance = options.relativeTolerance = std::stod(tempInput);
+        if (!std::isfinite(lower) || !std::isfinite(upper)) {
+            cerr << red << "The limits must be finite numbers." << reset << endl;
+            return;
+        }
+        if (!compileExpression(exprStr)) return;
+        prepareEvaluation(options.maxEvaluations);
+
+        const auto start = std::chrono::steady_clock::now();
+        const IntegrationResult integral = integrateAdaptively(lower, upper, options, [this](std::span<const double> xs, std::span<double> ys) {
+            evaluateBatchParallel(xs, ys);
+        });
+        const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        cout << bright_cyan << scientific << setprecision(2) << "Estimated error " << integral.errorEstimate << " ("
+             << integral.evaluations << " evaluations, " << integral.intervals << " subintervals, "
+             << fixed << elapsedMs << " ms)" << reset << endl;
+        if (integral.roundoffLimited) {
+            cout << yellow << "Tolerance not reached: rounding error in f limits the attainable accuracy." << reset << endl;
+        } else if (!integral.converged) {
+            cout << yellow << "Tolerance not reached: the integrand may be singular or too oscillatory for the evaluation budget." << reset << endl;
+        }
+        cout << red << underline << bold << defaultfloat << setprecision(15) << "Integral: " << integral.value << reset << endl;
+    }
+
+
+    // --- Core Calculation Functions ---
+    // Exact n!, by the prime-swing algorithm on big integers (see factorial.hpp)
+    BigUnsigned calculateFactorial(std::uint32_t n_val) {
+        return exactFactorial(n_val);
+    }
+
+    // GCD and LCM of every integer in the batch, exactly, on the sampling threads (see integer_gcd.hpp)
+    BigNatural calculateGcd(const IntegerBatch& batch) {
+        return batchGcd(batch, m_parallelSampler.threadCount());
+    }
+
+    BigNatural calculateLcm(const IntegerBatch& batch) {
+        return batchLcm(batch, m_parallelSampler.threadCount());
+    }
+
+    // Calculates product of f(x) from start_x to end_x (integer steps). Terms are multiplied in
+    // ScaledProduct form on the same sharded path as sums, so products far beyond the double range
+    // (and any thread count) give the same, finite answer. The mantissa is NaN on error.
+    ScaledProduct calculateProductSeries(const std::string& exprStr, long long start_x, long long end_x) {
+        std::vector<ScaledProduct> shards;
+        if (!accumulateSeriesShards(exprStr, start_x, end_x, shards)) return {NAN, 0};
+        return reducePairwise(std::move(shards));
+    }
+
+    // Calculates sum of f(x) from start_x to end_x (integer steps). Terms are added with Neumaier
+    // compensation within each shard and the shards are merged pairwise, so the result is accurate
+    // to a few ulps and identical on any thread count.
+    double calculateSumSeries(const std::string& exprStr, long long start_x, long long end_x) {
+        std::vector<NeumaierSum> shards;
+        if (!accumulateSeriesShards(exprStr, start_x, end_x, shards)) return NAN;
+        return reducePairwise(std::move(shards)).value();
+    }
+
+    // Limit of the sum of f(x) for x = start_x, start_x + 1, ... by convergence acceleration (see
+    // sumInfiniteSeries()). Terms are evaluated in doubling stages, so a classic series costs tens
+    // to a few thousand evaluations. terms is 0 if the expression is invalid.
+    SeriesLimitResult calculateInfiniteSumSeries(const std::string& exprStr, long long start_x) {
+        const SeriesLimitOptions options;
+        if (start_x < -SERIES_MAX_INDEX || start_x > SERIES_MAX_INDEX - static_cast<long long>(options.maxTerms)) {
+            cerr << red << "Series indices must lie within +/-2^53, where every integer is a double." << reset << endl;
+            return {};
+        }
+        if (!compileExpression(exprStr)) {
+            return {};
+        }
+        std::vector<double> xs;
+        return sumInfiniteSeries(options, [&](std::size_t first, std::span<double> ys) {
+            xs.resize(ys.size());
+            for (std::size_t k = 0; k < ys.size(); ++k) xs[k] = static_cast<double>(start_x + static_cast<long long>(first + k));
+            prepareEvaluation(first + ys.size()); // Tiers move up as the stages grow
+            evaluateBatch(xs, ys);
+        });
+    }
+
+    // Evaluates f at every integer x in [first, last] and folds the terms into one Accumulator per
+    // shard of SERIES_SHARD_TERMS consecutive indices (Accumulator::add(term) for each, in order).
+    // Shards run on m_parallelSampler's threads, each with its own evaluator, when there are enough;
+    // their boundaries and contents do not depend on the thread count. An empty range gives no
+    // shards. Returns false if the expression or the range is invalid.
+    template <typename Accumulator>
+    bool accumulateSeriesShards(const std::string& exprStr, long long first, long long last, std::vector<Accumulator>& shards) {
+        shards.clear();
+        if (first < -SERIES_MAX_INDEX || last > SERIES_MAX_INDEX || last < -SERIES_MAX_INDEX || first > SERIES_MAX_INDEX) {
+            cerr << red << "Series indices must lie within +/-2^53, where every integer is a double." << reset << endl;
+            return false;
+        }
+        if (!compileExpression(exprStr)) {
+            return false;
+        }
+        if (last < first) return true;
+        const unsigned long long terms = static_cast<unsigned long long>(last - first) + 1;
+        const std::size_t shardCount = static_cast<std::size_t>((terms + SERIES_SHARD_TERMS - 1) / SERIES_SHARD_TERMS);
+        shards.assign(shardCount, Accumulator{});
+        prepareEvaluation(static_cast<std::size_t>(terms));
 
-        double step = (xMax - xMin) / std::max(1, numSamples - 1);
-        for (int i = 0; i < numSamples; ++i) {
-            m_x_val = xMin + i * step;
-            double y = evaluateCurrentlyCompiledExpression();
-            if (!std::isnan(y)) {
-                if (y < outMinY) outMinY = y;
-                if (y > outMaxY) outMaxY = y;
+        // Folds shard 'shard' into its accumulator, evaluating CHUNK_SAMPLES terms per call of evaluate(xs, ys)
+        auto foldShard = [&](std::size_t shard, auto&& evaluate) {
+            std::array<double, ParallelSampler::CHUNK_SAMPLES> xs, ys;
+            const unsigned long long begin = static_cast<unsigned long long>(shard) * SERIES_SHARD_TERMS;
+            const unsigned long long end = std::min(terms, begin + SERIES_SHARD_TERMS);
+            Accumulator& accumulator = shards[shard];
+            for (unsigned long long base = begin; base < end; base += ParallelSampler::CHUNK_SAMPLES) {
+                const std::size_t lanes = static_cast<std::size_t>(std::min<unsigned long long>(ParallelSampler::CHUNK_SAMPLES, end - base));
+                for (std::size_t k = 0; k < lanes; ++k) xs[k] = static_cast<double>(first + static_cast<long long>(base + k));
+                evaluate(xs.data(), ys.data(), lanes);
+                for (std::size_t k = 0; k < lanes; ++k) accumulator.add(ys[k]);
             }
+        };
+        if (shardCount >= 2 && prepareParallelSampling(static_cast<std::size_t>(terms))) {
+            m_parallelSampler.forEach(shardCount, [&](std::size_t shard, ParallelSampler::Evaluator& worker) {
+                foldShard(shard, [&worker](const double* xs, double* ys, std::size_t count) { worker.evaluate(xs, ys, count); });
+            });
+        } else {
+            for (std::size_t shard = 0; shard < shardCount; ++shard) {
+                foldShard(shard, [this](const double* xs, double* ys, std::size_t count) {
+                    evaluateBatch(std::span<const double>(xs, count), std::span<double>(ys, count));
+                });
+            }
+        }
+        return true;
+    }
+
+    // Compiles exprStr and evaluates it on a uniform grid of numSamples points over [xMin, xMax].
+    // Long runs are spread over m_parallelSampler's threads. Returns false if the expression is invalid.
+    bool sampleExpression(const std::string& exprStr, double xMin, double xMax, int numSamples, SampleBuffer& out) {
+        out = SampleBuffer();
+        if (xMin >= xMax || numSamples <= 0) {
+             cerr << yellow << "Invalid range or zero samples for sampling." << reset << endl;
+            return false;
+        }
+        if (!compileExpression(exprStr)) { // Compile the expression once
+            return false;
+        }
+        const std::size_t count = static_cast<std::size_t>(numSamples);
+        out = SampleBuffer::uniformGrid(xMin, xMax, count);
+        bool sampledInPrecision = true;
+        if (withPrecisionEngine([&](auto& engine) {
+                sampledInPrecision = compileInPrecision(engine, exprStr);
+                if (sampledInPrecision) engine.sample(out.xs, out.ys);
+            })) {
+            return sampledInPrecision;
+        }
+        prepareEvaluation(count);
+
+        if (prepareParallelSampling(count)) {
+            // Chunks cover disjoint slices of the buffer, so workers write straight into it
+            const double step = (xMax - xMin) / static_cast<double>(std::max<std::size_t>(1, count - 1));
+            m_parallelSampler.run(xMin, step, count, [&](std::size_t chunk, std::span<const double>, std::span<const double> ys) {
+                std::copy(ys.begin(), ys.end(), out.ys.begin() + static_cast<std::ptrdiff_t>(chunk * ParallelSampler::CHUNK_SAMPLES));
+            });
+        } else {
+            evaluateBatch(out.xs, out.ys);
+        }
+        return true;
+    }
+
+    // Compiles exprStr and samples it adaptively over [xMin, xMax] within options.budget evaluations.
+    // Where automatic differentiation applies, intervals are also refined by their curvature.
+    bool sampleExpressionAdaptively(const std::string& exprStr, double xMin, double xMax,
+                                    const AdaptiveSamplingOptions& options, SampleBuffer& out) {
+        out = SampleBuffer();
+        if (xMin >= xMax || options.budget < 2) {
+             cerr << yellow << "Invalid range or evaluation budget for adaptive sampling." << reset << endl;
+            return false;
+        }
+        if (!compileExpression(exprStr)) {
+            return false;
+        }
+        prepareEvaluation(options.budget);
+        if (prepareAutodiff()) { // One hyper-dual pass per sample gives f and the curvature f''
+            out = sampleAdaptively(xMin, xMax, options, [this](std::span<const double> xs, std::span<double> ys, std::span<double> d2) {
+                for (std::size_t i = 0; i < xs.size(); ++i) {
+                    const HyperDual jet = m_hyperDualEvaluator.evaluate(HyperDual::variable(xs[i]));
+                    ys[i] = jet.value;
+                    d2[i] = jet.e12;
+                }
+            });
+        } else {
+            out = sampleAdaptively(xMin, xMax, options, [this](std::span<const double> xs, std::span<double> ys) {
+                evaluateBatch(xs, ys);
+            });
+        }
+        return true;
+    }
+
+    // Zeros of the current expression, bracketed by sign changes between neighbouring samples (which
+    // must be sorted by x) and refined to machine precision. Newton steps on dual numbers are used if
+    // asked for and the expression lowers to bytecode, Brent's method otherwise. Many brackets are
+    // refined on m_parallelSampler's threads, in tasks of ROOT_BRACKETS_PER_TASK.
+    RootFindingResult findRootsInSamples(const SampleBuffer& samples, bool useNewton) {
+        RootFindingResult result;
+        const std::vector<RootBracket> brackets = findSignChanges(samples, result.roots);
+        result.brackets = brackets.size();
+        if (brackets.empty() || !m_compiled) return result;
+        result.newton = useNewton && prepareAutodiff();
+
+        std::vector<RootEstimate> estimates(brackets.size());
+        const std::size_t tasks = (brackets.size() + ROOT_BRACKETS_PER_TASK - 1) / ROOT_BRACKETS_PER_TASK;
+        if (tasks >= 2 && m_parallelSampler.threadCount() > 1 && prepareParallelWorkers()) {
+            std::vector<std::size_t> taskEvaluations(tasks, 0);
+            m_parallelSampler.forEach(tasks, [&](std::size_t task, ParallelSampler::Evaluator& worker) {
+                const std::size_t begin = task * ROOT_BRACKETS_PER_TASK;
+                const std::size_t count = std::min(ROOT_BRACKETS_PER_TASK, brackets.size() - begin);
+                taskEvaluations[task] = root_finding::refineBrackets(
+                    std::span<const RootBracket>(brackets).subspan(begin, count), std::span<RootEstimate>(estimates).subspan(begin, count),
+                    [&worker](double x) { return worker.value(x); },
+                    [&worker](double x) { return worker.valueAndDerivative(x); },
+                    result.newton && worker.hasDerivative());
+            });
+            for (const std::size_t evaluations : taskEvaluations) result.evaluations += evaluations;
+        } else {
+            result.evaluations = root_finding::refineBrackets(brackets, estimates,
+                [this](double x) {
+                    m_x_val = x;
+                    return evaluateCurrentlyCompiledExpression();
+                },
+                [this](double x) { return m_dualEvaluator.evaluate(Dual::variable(x)); },
+                result.newton);
+        }
+
+        for (std::size_t i = 0; i < brackets.size(); ++i) {
+            if (root_finding::isRoot(brackets[i], estimates[i])) result.roots.push_back(estimates[i].x);
+            else ++result.discontinuities;
+        }
+        std::sort(result.roots.begin(), result.roots.end());
+        return result;
+    }
+
+    // Bounds the current expression over [xMin, xMax] by interval branch and bound. Poles are resolved
+    // to half a column of a width-column plot. Returns false if the expression is outside the
+    // interval evaluator's subset or no point of the range is defined.
+    bool boundYRangeWithIntervals(double xMin, double xMax, int width, IntervalRangeResult& out) {
+        if (!m_compiled) return false;
+        if (!m_compiled->treeParsed) {
+            m_compiled->treeParsed = true;
+            m_compiled->tree = ExpressionTreeParser::parse(m_compiled->normalizedStr);
         }
+        if (!m_compiled->tree) return false;
+        const double minWidth = (xMax - xMin) / std::max(1, width) * 0.5;
+        out = intervalRangeSearch(*m_compiled->tree, xMin, xMax, minWidth, INTERVAL_MAX_BOXES, INTERVAL_RANGE_TOLERANCE,
+            [this](double x) {
+                m_x_val = x;
+                return evaluateCurrentlyCompiledExpression();
+            });
+        return !std::isnan(out.minY);
+    }
+
+    // Calculates Min and Max Y values from the samples of an expression
+    void calculateMinMaxY(const SampleBuffer& samples, double& outMinY, double& outMaxY) {
+        if (samples.empty()) {
+            outMinY = NAN; outMaxY = NAN;
+            return;
+        }
+        std::tie(outMinY, outMaxY) = samples.yRange();
          if (std::isinf(outMinY) || std::isinf(outMaxY)) {
             // If only one bound was found, set the other to something reasonable or indicate error
             if (std::isinf(outMinY) && !std::isinf(outMaxY)) outMinY = outMaxY -1; // Default if only max found
@@ -228,8 +1186,8 @@ private:
              << setw(20) << bold << bright_green << "Absolute/Min/Max" << reset
              << setw(15) << bold << bright_green << "Other" << reset << '\n';
         cout << bold << green << string(60, '-') << reset << '\n';
-        cout << bright_green << left << setw(15) << " floor(x)" << setw(20) << " abs(x)" << setw(15) << " gcd(a,b) ('G')" << reset << '\n';
-        cout << bright_green << left << setw(15) << " ceil(x)" << setw(20) << " min(a,b)" << setw(15) << " lcm(a,b) ('L')" << reset << '\n';
+        cout << bright_green << left << setw(15) << " floor(x)" << setw(20) << " abs(x)" << setw(15) << " gcd(a,b,...) ('G')" << reset << '\n';
+        cout << bright_green << left << setw(15) << " ceil(x)" << setw(20) << " min(a,b)" << setw(15) << " lcm(a,b,...) ('L')" << reset << '\n';
         cout << bright_green << left << setw(15) << " round(x)" << setw(20) << " max(a,b)" << setw(15) << " factorial(n) ('F')" << reset << '\n';
         cout << bold << green << string(60, '-') << reset << '\n';
         cout << setw(0) << bold << bright_green << "Series Operations (enter 'P' or 'S')" << reset << '\n';
@@ -237,15 +1195,383 @@ private:
         cout << bright_green << left << setw(30) << " Product ('P'): PI[f(x)]" << setw(30) << " Sum ('S'): SIGMA[f(x)]" << reset << '\n';
         cout << bold << green << string(60, '-') << reset << '\n';
         cout << bright_green << "# NOTE: For general expressions, just type them e.g., 5+4*8-sin(pi/2)+pow(2,3)" << reset << '\n';
+        cout << bright_green << "# Type 'd/dx f(x)' for the symbolic derivative (also accepted by the graphing tool)." << reset << '\n';
+        cout << bright_green << "# Type 'r' to find every root of f(x) on a range, 'i' for a definite integral." << reset << '\n';
+        cout << bright_green << "# Type 'fft f(x)' or 'fft @file' for the dominant frequencies of f or of sampled data." << reset << '\n';
+        cout << bright_green << "# Type 'c' for compiled-expression cache statistics." << reset << '\n';
+        cout << bright_green << "# Type 'precision float|double|long|quad|multi [digits]' to evaluate in another precision." << reset << '\n';
+        cout << bright_green << "# Type 'm' for menu, 'q' to return to main menu." << reset << endl;
+    }
+
+    void displayExtraMenu() {
+        cout << bold << green << string(60, '-') << reset << '\n';
+        cout << setw(0) << bold << bright_green << "Number Theory (64-bit integers)" << reset << '\n';
+        cout << bold << green << string(60, '-') << reset << '\n';
+        cout << bright_green << left << setw(30) << " isprime n" << setw(30) << " factor n" << reset << '\n';
+        cout << bright_green << left << setw(30) << " pi n   (primes <= n)" << setw(30) << " nth n  (n-th prime)" << reset << '\n';
+        cout << bright_green << left << setw(30) << " count a b" << setw(30) << " primes a b" << reset << '\n';
+        cout << bold << green << string(60, '-') << reset << '\n';
+        cout << setw(0) << bold << bright_green << "Matrices (" << matrixKernelName() << " kernel)" << reset << '\n';
+        cout << bold << green << string(60, '-') << reset << '\n';
+        cout << bright_green << left << setw(30) << " det A" << setw(30) << " inv A" << reset << '\n';
+        cout << bright_green << left << setw(30) << " lu A   (P A = L U)" << setw(30) << " chol A (A = L L^T)" << reset << '\n';
+        cout << bright_green << left << setw(30) << " solve A B  (A X = B)" << setw(30) << " mul A B" << reset << '\n';
+        cout << bright_green << left << setw(30) << " matbench [n]" << reset << '\n';
+        cout << bold << green << string(60, '-') << reset << '\n';
+        cout << bright_green << "# Numbers may be written as 1000000, 1e6 or 10^6." << reset << '\n';
+        cout << bright_green << "# Matrices: [1 2; 3 4], @path (rows on lines) or rand(n)." << reset << '\n';
         cout << bright_green << "# Type 'm' for menu, 'q' to return to main menu." << reset << endl;
     }
 
+    void displayExpressionCacheStats() {
+        const std::size_t lookups = m_expressionCache.hits() + m_expressionCache.misses();
+        cout << bright_cyan << "Expression cache: " << m_expressionCache.size() << "/" << m_expressionCache.capacity()
+             << " entries, " << m_expressionCache.hits() << " hits, " << m_expressionCache.misses() << " misses";
+        if (lookups > 0) {
+            cout << " (" << fixed << setprecision(1) << 100.0 * static_cast<double>(m_expressionCache.hits()) / static_cast<double>(lookups) << "% hit rate)";
+        }
+        cout << reset << endl;
+        cout << bright_cyan << "Simplifier: " << m_simplifiedExpressions << " expressions, " << m_nodesBeforeSimplification
+             << " -> " << m_nodesAfterSimplification << " tree nodes" << reset << endl;
+    }
+
+    // Extra mode: number theory on 64-bit integers (see number_theory.hpp) and dense matrices (see
+    // linear_algebra.hpp). Prime counts use the O(n^(3/4)) recursion up to PRIME_COUNT_LIMIT; ranges
+    // of primes are sieved, and matrices multiplied and factored, on the sampling threads.
+    void showExtra() {
+        string inputStr;
+        displayExtraMenu();
+
+        while (true) {
+            cout << bold << bright_blue << "\nExtra > " << reset;
+            getline(cin, inputStr);
+
+            if (inputStr.empty()) continue;
+            if (inputStr == "q" || inputStr == "Q") break;
+            if (inputStr == "m" || inputStr == "M") {
+                displayExtraMenu();
+                continue;
+            }
+
+            std::istringstream words(inputStr);
+            std::string command, firstWord, secondWord;
+            words >> command;
+            if (command == "det" || command == "inv" || command == "lu" || command == "chol" || command == "solve" ||
+                command == "mul" || command == "matbench") {
+                std::string operands;
+                getline(words, operands);
+                runMatrixCommand(command, operands);
+                continue;
+            }
+            words >> firstWord >> secondWord;
+            const std::optional<std::uint64_t> first = parseNaturalNumber(firstWord);
+            const std::optional<std::uint64_t> second = parseNaturalNumber(secondWord);
+            const bool range = command == "count" || command == "primes";
+            if (!range && command != "isprime" && command != "factor" && command != "pi" && command != "nth") {
+                cout << yellow << "Unknown command '" << command << "'. Try 'm' for menu." << reset << endl;
+                continue;
+            }
+            if (!first || (range && !second)) {
+                cerr << red << "Expected " << (range ? "two integers" : "an integer") << " from 0 to 2^64 - 1 after '" << command
+                     << "'." << reset << endl;
+                continue;
+            }
+            const std::uint64_t n = *first;
+            const unsigned threads = m_parallelSampler.threadCount();
+            const auto start = std::chrono::steady_clock::now();
+
+            if (command == "isprime") {
+                cout << red << underline << bold << n << (isPrime(n) ? " is prime" : " is not prime") << reset << endl;
+            } else if (command == "factor") {
+                if (n == 0) {
+                    cerr << red << "0 has no prime factorization." << reset << endl;
+                    continue;
+                }
+                const std::vector<PrimePower> factors = factorize(n);
+                cout << red << underline << bold << n << " = ";
+                if (factors.empty()) cout << "1";
+                for (std::size_t i = 0; i < factors.size(); ++i) {
+                    cout << (i > 0 ? " * " : "") << factors[i].prime;
+                    if (factors[i].exponent > 1) cout << "^" << factors[i].exponent;
+                }
+                cout << reset << endl;
+            } else if (command == "pi") {
+                if (n > PRIME_COUNT_LIMIT) {
+                    cerr << red << "pi(n) is limited to n <= 10^13." << reset << endl;
+                    continue;
+                }
+                cout << red << underline << bold << "pi(" << n << ") = " << countPrimes(n) << reset << endl;
+            } else if (command == "nth") {
+                const std::uint64_t prime = nthPrime(n, threads);
+                if (prime == 0) {
+                    cerr << red << (n == 0 ? "Primes are numbered from 1." : "That prime lies beyond 10^14.") << reset << endl;
+                    continue;
+                }
+                cout << red << underline << bold << "Prime #" << n << " = " << prime << reset << endl;
+            } else { // count or primes
+                const std::uint64_t low = n, high = *second;
+                if (high > SegmentedSieve::LIMIT) {
+                    cerr << red << "Ranges of primes are limited to 10^14; use 'pi' for counts from 0." << reset << endl;
+                    continue;
+                }
+                if (command == "count") {
+                    cout << red << underline << bold << "Primes in [" << low << ", " << high << "]: " << countPrimesInRange(low, high, threads) << reset << endl;
+                } else if (high >= low && high - low >= PRIME_LIST_RANGE) {
+                    cerr << red << "Primes are listed for ranges of up to 10^9 numbers; use 'count' for wider ones." << reset << endl;
+                    continue;
+                } else {
+                    const std::vector<std::uint64_t> primes = primesInRange(low, high, threads);
+                    cout << red << underline << bold << primes.size() << " primes in [" << low << ", " << high << "]" << reset << endl;
+                    for (std::size_t i = 0; i < std::min(primes.size(), PRIMES_SHOWN); ++i) cout << red << primes[i] << (i + 1 < primes.size() ? " " : "");
+                    if (primes.size() > PRIMES_SHOWN) cout << "... (" << primes.size() - PRIMES_SHOWN << " more)";
+                    cout << reset << endl;
+                }
+            }
+            const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            cout << bright_cyan << fixed << setprecision(2) << elapsedMs << " ms" << reset << endl;
+        }
+    }
+
+    // A non-negative integer written as digits, "<digits>e<digits>" or "<digits>^<digits>", if it fits 64 bits
+    static std::optional<std::uint64_t> parseNaturalNumber(const std::string& text) {
+        const std::size_t split = text.find_first_of("eE^");
+        std::uint64_t base = 0, exponent = 1;
+        const char* end = text.data() + text.size();
+        const char* baseEnd = text.data() + (split == std::string::npos ? text.size() : split);
+        const auto parsedBase = std::from_chars(text.data(), baseEnd, base);
+        if (text.empty() || parsedBase.ec != std::errc() || parsedBase.ptr != baseEnd) return std::nullopt;
+        if (split == std::string::npos) return base;
+        const auto parsedExponent = std::from_chars(baseEnd + 1, end, exponent);
+        if (parsedExponent.ec != std::errc() || parsedExponent.ptr != end || baseEnd + 1 == end) return std::nullopt;
+        std::uint64_t value = (text[split] == '^') ? 1 : base;
+        const std::uint64_t factor = (text[split] == '^') ? base : 10;
+        for (std::uint64_t i = 0; i < exponent && value != 0 && factor != 1; ++i) {
+            if (factor != 0 && value > UINT64_MAX / factor) return std::nullopt;
+            value *= factor;
+        }
+        return value;
+    }
+
+    // Extra-mode matrix commands. operandText holds the matrices: "[1 2; 3 4]", "@path" or "rand(n)".
+    void runMatrixCommand(const std::string& command, const std::string& operandText) {
+        const unsigned threads = m_parallelSampler.threadCount();
+        if (command == "matbench") {
+            benchmarkMatrices(operandText, threads);
+            return;
+        }
+        std::vector<Matrix> operands;
+        std::string error;
+        if (!parseMatrixOperands(operandText, operands, error)) {
+            cerr << red << error << reset << endl;
+            return;
+        }
+        const bool binary = command == "solve" || command == "mul";
+        if (operands.size() != (binary ? 2u : 1u)) {
+            cerr << red << "'" << command << "' takes " << (binary ? "two matrices" : "one matrix") << ", e.g. " << command
+                 << (binary ? " [2 1; 1 3] [1; 2]" : " [2 1; 1 3]") << reset << endl;
+            return;
+        }
+        const Matrix& a = operands[0];
+        if (command != "mul" && !a.square()) {
+            cerr << red << "'" << command << "' needs a square matrix, not " << a.rows() << "x" << a.cols() << "." << reset << endl;
+            return;
+        }
+        if (binary && (command == "mul" ? a.cols() : a.rows()) != operands[1].rows()) {
+            cerr << red << "Sizes do not match: " << a.rows() << "x" << a.cols() << " and " << operands[1].rows() << "x" << operands[1].cols()
+                 << "." << reset << endl;
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto elapsedMs = [&] { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+        double computeMs = 0.0;
+        if (command == "mul") {
+            const Matrix product = multiply(a, operands[1], threads);
+            computeMs = elapsedMs();
+            printMatrix("A B", product);
+        } else if (command == "chol") {
+            if (!isSymmetric(a.view())) {
+                cerr << red << "Cholesky needs a symmetric matrix." << reset << endl;
+                return;
+            }
+            Matrix factor = a;
+            if (!choleskyInPlace(factor, threads)) {
+                cerr << red << "The matrix is not positive definite." << reset << endl;
+                return;
+            }
+            computeMs = elapsedMs();
+            printMatrix("L", factor);
+        } else {
+            const LuDecomposition lu = luDecompose(a, threads);
+            if (command == "det") {
+                const ScaledProduct det = lu.determinant();
+                computeMs = elapsedMs();
+                cout << red << underline << bold << defaultfloat << setprecision(15) << "det(A) = ";
+                if (lu.singular) {
+                    cout << 0;
+                } else if (det.fitsDouble()) {
+                    cout << det.value();
+                } else { // Beyond the double range: print the exponent ourselves
+                    const auto [significand, power] = det.decimal();
+                    cout << significand << "e" << (power < 0 ? "-" : "+") << std::llabs(power);
+                }
+                cout << reset << endl;
+            } else if (command == "lu") {
+                Matrix lower = Matrix::identity(a.rows()), upper(a.rows(), a.cols());
+                for (std::size_t i = 0; i < a.rows(); ++i) {
+                    std::copy(lu.factors.row(i), lu.factors.row(i) + i, lower.row(i));
+                    std::copy(lu.factors.row(i) + i, lu.factors.row(i) + a.cols(), upper.row(i) + i);
+                }
+                std::vector<std::size_t> order(a.rows());
+                for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+                for (std::size_t k = 0; k < lu.pivots.size(); ++k) std::swap(order[k], order[lu.pivots[k]]);
+                computeMs = elapsedMs();
+                printMatrix("L", lower);
+                printMatrix("U", upper);
+                cout << red << bold << "Rows of A in P A:" << reset << red;
+                for (std::size_t i = 0; i < order.size(); ++i) {
+                    if (order.size() > MATRIX_SHOWN && i == MATRIX_EDGE_SHOWN) {
+                        cout << " ...";
+                        i = order.size() - MATRIX_EDGE_SHOWN;
+                    }
+                    cout << " " << order[i] + 1;
+                }
+                cout << reset << endl;
+            } else { // inv or solve
+                if (lu.singular) {
+                    cerr << red << "The matrix is singular." << reset << endl;
+                    return;
+                }
+                Matrix result = command == "inv" ? lu.inverse(threads) : operands[1];
+                if (command == "solve") lu.solveInPlace(result.view(), threads);
+                computeMs = elapsedMs();
+                printMatrix(command == "inv" ? "inv(A)" : "X", result);
+            }
+            const double nearlySingular = static_cast<double>(a.rows()) * std::numeric_limits<double>::epsilon();
+            if (!lu.singular && (command == "inv" || command == "solve") && lu.pivotRatio() < nearlySingular) {
+                cout << yellow << "Warning: the matrix is singular to working precision (pivot ratio " << scientific << setprecision(1)
+                     << lu.pivotRatio() << "); the result may have no correct digits." << reset << endl;
+            }
+        }
+        cout << bright_cyan << fixed << setprecision(2) << computeMs << " ms" << reset << endl;
+    }
+
+    // Matrices from "[...]" (see Matrix::parse), "@path" (the file holds one row per line) or
+    // "rand(n)" (n x n, uniform in [-1, 1)), separated by spaces
+    static bool parseMatrixOperands(const std::string& text, std::vector<Matrix>& operands, std::string& error) {
+        std::size_t pos = text.find_first_not_of(" \t");
+        while (pos != std::string::npos) {
+            Matrix matrix;
+            std::size_t next = std::string::npos;
+            if (text[pos] == '[') {
+                const std::size_t close = text.find(']', pos);
+                if (close == std::string::npos) {
+                    error = "Missing ']' after " + text.substr(pos);
+                    return false;
+                }
+                if (!matrix.parse(text.substr(pos, close - pos + 1), error)) return false;
+                next = close + 1;
+            } else if (text[pos] == '@') {
+                next = text.find_first_of(" \t", pos);
+                const std::string path = text.substr(pos + 1, next == std::string::npos ? std::string::npos : next - pos - 1);
+                std::ifstream file(path);
+                std::ostringstream contents;
+                contents << file.rdbuf();
+                if (!file) {
+                    error = "Could not read " + path;
+                    return false;
+                }
+                if (!matrix.parse(contents.str(), error)) return false;
+            } else if (text.compare(pos, 5, "rand(") == 0 && text.find(')', pos) != std::string::npos) {
+                const std::size_t close = text.find(')', pos);
+                const std::optional<std::uint64_t> size = parseNaturalNumber(text.substr(pos + 5, close - pos - 5));
+                if (!size || *size == 0 || *size > MATRIX_RANDOM_LIMIT) {
+                    error = "rand(n) takes a size from 1 to " + std::to_string(MATRIX_RANDOM_LIMIT) + ".";
+                    return false;
+                }
+                matrix = randomMatrix(*size);
+                next = close + 1;
+            } else {
+                error = "Expected a matrix such as [1 2; 3 4], @path or rand(n) at: " + text.substr(pos);
+                return false;
+            }
+            operands.push_back(std::move(matrix));
+            pos = next == std::string::npos ? next : text.find_first_not_of(" \t", next);
+        }
+        return true;
+    }
+
+    static Matrix randomMatrix(std::size_t n) {
+        static std::mt19937_64 generator(std::random_device{}());
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        Matrix result(n, n);
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = 0; j < n; ++j) result(i, j) = uniform(generator);
+        }
+        return result;
+    }
+
+    // Prints m, eliding the middle of any dimension longer than MATRIX_SHOWN
+    static void printMatrix(const char* name, const Matrix& m) {
+        cout << red << underline << bold << name << " (" << m.rows() << "x" << m.cols() << "):" << reset << '\n';
+        auto shown = [](std::size_t count, std::size_t& i) { // Advances i, skipping the middle; false after the end
+            if (count > MATRIX_SHOWN && i == MATRIX_EDGE_SHOWN) i = count - MATRIX_EDGE_SHOWN;
+            return i < count;
+        };
+        for (std::size_t i = 0; shown(m.rows(), i); ++i) {
+            if (m.rows() > MATRIX_SHOWN && i == m.rows() - MATRIX_EDGE_SHOWN) cout << red << "  ..." << reset << '\n';
+            cout << red << defaultfloat << setprecision(6);
+            for (std::size_t j = 0; shown(m.cols(), j); ++j) {
+                if (m.cols() > MATRIX_SHOWN && j == m.cols() - MATRIX_EDGE_SHOWN) cout << "  ...";
+                cout << right << setw(14) << m(i, j);
+            }
+            cout << reset << '\n';
+        }
+        cout << flush;
+    }
+
+    // "matbench [n]": GFLOP/s of the n x n multiply on one thread and on all of them, of LU and of Cholesky
+    void benchmarkMatrices(const std::string& operandText, unsigned threads) {
+        std::istringstream words(operandText);
+        std::string sizeWord;
+        words >> sizeWord;
+        const std::optional<std::uint64_t> size = sizeWord.empty() ? std::optional<std::uint64_t>(MATBENCH_DEFAULT_SIZE) : parseNaturalNumber(sizeWord);
+        if (!size || *size == 0 || *size > MATRIX_RANDOM_LIMIT) {
+            cerr << red << "matbench takes a size from 1 to " << MATRIX_RANDOM_LIMIT << "." << reset << endl;
+            return;
+        }
+        const std::size_t n = *size;
+        const double cube = static_cast<double>(n) * static_cast<double>(n) * static_cast<double>(n);
+        const Matrix a = randomMatrix(n), b = randomMatrix(n);
+        Matrix spd = Matrix::identity(n); // a a^T + n I is symmetric positive definite
+        multiplyAdd(a.view(), a.view().transposed(), spd.view(), 1.0, threads);
+        for (std::size_t i = 0; i < n; ++i) spd(i, i) *= static_cast<double>(n);
+
+        auto report = [&](const std::string& label, double flops, auto&& body) {
+            const auto start = std::chrono::steady_clock::now();
+            body();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            cout << bright_cyan << left << setw(30) << label << right << fixed << setprecision(2) << setw(10) << seconds * 1e3 << " ms"
+                 << setprecision(1) << setw(10) << flops / seconds * 1e-9 << " GFLOP/s" << reset << endl;
+        };
+        cout << bright_cyan << n << "x" << n << " doubles, " << matrixKernelName() << " kernel" << reset << endl;
+        Matrix product(n, n);
+        report("multiply, 1 thread", 2.0 * cube, [&] { multiplyAdd(a.view(), b.view(), product.view(), 1.0, 1); });
+        if (threads > 1) {
+            report("multiply, " + std::to_string(threads) + " threads", 2.0 * cube, [&] { multiplyAdd(a.view(), b.view(), product.view(), 1.0, threads); });
+        }
+        report("LU", 2.0 * cube / 3.0, [&] { (void)luDecompose(a, threads); });
+        report("Cholesky", cube / 3.0, [&] { (void)choleskyInPlace(spd, threads); });
+    }
+
     void showScientificCalculator() {
         string inputStr;
         displayScientificMenu();
 
         while (true) {
-            cout << bold << bright_blue << "\nSciCalc > " << reset;
+            cout << bold << bright_blue << "\nSciCalc";
+            if (m_precision != Precision::Double) cout << " [" << precisionName(m_precision) << "]";
+            cout << " > " << reset;
             getline(cin, inputStr);
 
             if (inputStr.empty()) continue;
@@ -259,50 +1585,96 @@ private:
             if (inputStr.length() == 1 && std::isalpha(firstChar)) {
                 firstChar = std::tolower(firstChar);
                 if (firstChar == 'f') { // Factorial
-                    int n_val;
-                    cout << bright_blue << "Enter integer value for factorial n: " << reset;
-                    cin >> n_val;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    cout << red << underline << bold << "Factorial(" << n_val << ") = " << calculateFactorial(n_val) << reset << endl;
+                    showFactorial();
                 } else if (firstChar == 'g' || firstChar == 'l') { // GCD or LCM
-                    double val_a, val_b;
-                    cout << bright_blue << "Enter a: " << reset; cin >> val_a;
-                    cout << bright_blue << "Enter b: " << reset; cin >> val_b;
-                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    if (firstChar == 'g') {
-                        cout << red << underline << bold << "GCD(" << val_a << ", " << val_b << ") = " << calculateGcd(val_a, val_b) << reset << endl;
-                    } else {
-                        cout << red << underline << bold << "LCM(" << val_a << ", " << val_b << ") = " << calculateLcm(val_a, val_b) << reset << endl;
-                    }
+                    showGcdLcm(firstChar == 'l');
                 } else if (firstChar == 'p' || firstChar == 's') { // Product or Sum Series
                     string seriesExprStr;
-                    int start_idx, end_idx;
+                    long long start_idx, end_idx = 0;
+                    string endStr;
                     cout << bright_blue << "Enter function f(x) for series: " << reset; getline(cin, seriesExprStr);
                     cout << bright_blue << "Enter integer start index for x: " << reset; cin >> start_idx;
-                    cout << bright_blue << "Enter integer end index for x: " << reset; cin >> end_idx;
+                    cout << bright_blue << "Enter integer end index for x" << (firstChar == 's' ? " ('inf' for an infinite series)" : "")
+                         << ": " << reset; cin >> endStr;
                     cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                    if (firstChar == 'p') {
-                        double result = calculateProductSeries(seriesExprStr, start_idx, end_idx);
-                        cout << red << underline << bold << "Product Series Result: " << result << reset << endl;
+                    const bool infinite = endStr == "inf" || endStr == "INF";
+                    if (!infinite) {
+                        try {
+                            end_idx = std::stoll(endStr);
+                        } catch (const std::exception&) {
+                            cerr << red << "Invalid end index: " << endStr << reset << endl;
+                            continue;
+                        }
+                    }
+                    if (infinite && firstChar == 'p') {
+                        cerr << red << "Infinite products are not supported; give an end index." << reset << endl;
+                    } else if (infinite) {
+                        const SeriesLimitResult limit = calculateInfiniteSumSeries(seriesExprStr, start_idx);
+                        if (limit.terms == 0) continue;
+                        cout << bright_cyan << scientific << setprecision(2) << "Limit by " << series_acceleration::methodName(limit.method)
+                             << " after " << limit.terms << " terms, estimated error " << limit.errorEstimate << reset << endl;
+                        if (!limit.converged) {
+                            cout << yellow << "Tolerance not reached: the series may diverge or converge too slowly to extrapolate." << reset << endl;
+                        }
+                        cout << red << underline << bold << defaultfloat << setprecision(15) << "Sum Series Result: " << limit.value << reset << endl;
+                    } else if (withPrecisionEngine([&](auto& engine) {
+                                   if (!compileInPrecision(engine, seriesExprStr)) return;
+                                   const auto result = (firstChar == 'p') ? engine.product(start_idx, end_idx) : engine.sum(start_idx, end_idx);
+                                   cout << red << underline << bold << (firstChar == 'p' ? "Product" : "Sum") << " Series Result: "
+                                        << formatInPrecision(result) << reset << endl;
+                               })) {
+                        // Evaluated in the selected precision, one term at a time
+                    } else if (firstChar == 'p') {
+                        const ScaledProduct result = calculateProductSeries(seriesExprStr, start_idx, end_idx);
+                        cout << red << underline << bold << defaultfloat << setprecision(15) << "Product Series Result: ";
+                        if (result.fitsDouble()) {
+                            cout << result.value();
+                        } else { // Beyond the double range: print the exponent ourselves
+                            const auto [significand, power] = result.decimal();
+                            cout << significand << "e" << (power < 0 ? "-" : "+") << std::llabs(power);
+                        }
+                        cout << reset << endl;
                     } else {
                         double result = calculateSumSeries(seriesExprStr, start_idx, end_idx);
-                        cout << red << underline << bold << "Sum Series Result: " << result << reset << endl;
+                        cout << red << underline << bold << defaultfloat << setprecision(15) << "Sum Series Result: " << result << reset << endl;
                     }
+                } else if (firstChar == 'c') { // Compiled-expression cache statistics
+                    displayExpressionCacheStats();
+                } else if (firstChar == 'r') { // Roots of f(x) on a range
+                    showRoots();
+                } else if (firstChar == 'i') { // Definite integral
+                    showIntegral();
                 } else {
                      cout << yellow << "Unknown single-letter command. Try 'm' for menu." << reset << endl;
                 }
+            } else if (inputStr.compare(0, 4, "d/dx") == 0) { // Symbolic derivative
+                showDerivative(inputStr);
+            } else if (inputStr.compare(0, 9, "precision") == 0) {
+                showPrecisionCommand(inputStr);
+            } else if (inputStr.compare(0, 4, "fft ") == 0) { // Spectrum of f(x) or of a data file
+                showSpectrum(inputStr.substr(4));
+            } else if (withPrecisionEngine([&](auto& engine) {
+                           if (!compileInPrecision(engine, inputStr)) return;
+                           cout << red << underline << bold << "Result: " << formatInPrecision(engine.evaluate(0)) << reset << endl;
+                       })) {
+                // Evaluated in the selected precision
             } else { // General expression
                 double result = evaluateNewExpression(inputStr);
-                if (!std::isnan(result)) {
+                if (!std::isnan(result) && m_resultDigits > 0) {
+                    cout << red << underline << bold << defaultfloat << setprecision(std::min(m_resultDigits, precisionMaxDigits(Precision::Double)))
+                         << "Result: " << result << reset << endl;
+                } else if (!std::isnan(result)) {
                     cout << red << underline << bold << fixed << setprecision(10) << "Result: " << result << reset << endl;
                 }
             }
         }
     }
     
-    void plotAsciiGraph(const std::string& exprStr, int width, int height,
+    // Rasterizes previously computed samples of exprStr; no expression is evaluated here.
+    // Roots are marked with 'o' on the y = 0 row.
+    void plotAsciiGraph(const std::string& exprStr, const SampleBuffer& samples, int width, int height,
                         double xMin, double xMax, double yMinActual, double yMaxActual,
-                        int plotDensityFactor) {
+                        int plotDensityFactor, const std::vector<double>& roots) {
         if (width <= 0 || height <= 0) {
             cerr << red << "Error: Graph width and height must be positive." << reset << endl;
             return;
@@ -319,12 +1691,6 @@ private:
             }
          }
 
-
-        // Compile the expression once for the entire plotting process
-        if (!compileExpression(exprStr)) {
-            return; // Error message already printed by compileExpression
-        }
-
         vector<string> canvas(height, string(width, ' '));
 
         // --- Axis Drawing ---
@@ -361,25 +1727,27 @@ private:
         }
         
         // --- Plotting Points ---
-        // Number of points to evaluate based on width and density factor
-        int numEvalPoints = std::max(width, width * plotDensityFactor); // Ensure at least 'width' points
-        double xStep = (xMax - xMin) / std::max(1, numEvalPoints - 1);
-
-        for (int i = 0; i < numEvalPoints; ++i) {
-            m_x_val = xMin + i * xStep;
-            double y = evaluateCurrentlyCompiledExpression();
+        auto plotPoint = [&](double x, double y, char mark = '*') {
+            if (std::isnan(y)) return;
+            // Map x to canvas column
+            int plotX = static_cast<int>((x - xMin) * (width - 1) / (xMax - xMin));
+            // Map y to canvas row (inverted: 0 at top for console)
+            int plotY = static_cast<int>((yMaxActual - y) * (height - 1) / (yMaxActual - yMinActual));
 
-            if (!std::isnan(y)) {
-                // Map x to canvas column
-                int plotX = static_cast<int>((m_x_val - xMin) * (width - 1) / (xMax - xMin));
-                // Map y to canvas row (inverted: 0 at top for console)
-                int plotY = static_cast<int>((yMaxActual - y) * (height - 1) / (yMaxActual - yMinActual));
-
-                if (plotX >= 0 && plotX < width && plotY >= 0 && plotY < height) {
-                    canvas[plotY][plotX] = '*';
-                }
+            if (plotX >= 0 && plotX < width && plotY >= 0 && plotY < height) {
+                canvas[plotY][plotX] = mark;
             }
+        };
+        // Number of points to plot based on width and density factor, picked from the sample buffer.
+        // Adaptive samples are within half a cell of their chords, so interpolating them is faithful;
+        // they are also drawn themselves so that the detail they were placed for shows up.
+        int numEvalPoints = std::max(width, width * plotDensityFactor); // Ensure at least 'width' points
+        const SampleBuffer plotted = samples.resample(static_cast<std::size_t>(numEvalPoints));
+        for (std::size_t i = 0; i < plotted.size(); ++i) plotPoint(plotted.xs[i], plotted.ys[i]);
+        if (!samples.uniform) {
+            for (std::size_t i = 0; i < samples.size(); ++i) plotPoint(samples.xs[i], samples.ys[i]);
         }
+        for (const double root : roots) plotPoint(root, 0.0, 'o');
 
         // Print the canvas
         cout << bold << bright_cyan << "\n--- Graph of y = " << exprStr << " ---" << reset << endl;
@@ -397,12 +1765,15 @@ private:
         double xMin = -10.0, xMax = 10.0;    // Default X range
         int densityFactor = 1;               // Default density
 
-        cout << bold << bright_blue << "Enter expression in terms of x (e.g., x^2, sin(x)): " << reset;
+        cout << bold << bright_blue << "Enter expression in terms of x (e.g., x^2, sin(x), d/dx x^3): " << reset;
         getline(cin, exprStr);
         if (exprStr.empty()) {
             cout << yellow << "No expression entered. Aborting graph." << reset << endl;
             return;
         }
+        std::string derivativeOf;
+        const int derivativeOrder = splitDerivativeCommand(exprStr, derivativeOf);
+        if (!expandDerivativeCommand(exprStr)) return; // "d/dx f" plots f'
 
         cout << bold << bright_blue << "Enter graph width (default " << graphWidth << "): " << reset;
         string tempInput;
@@ -427,25 +1798,104 @@ private:
         
         m_graphPlotDensityFactor = std::max(1, densityFactor); // Ensure it's at least 1
 
+        cout << bold << bright_blue << "Sampling mode, [u]niform or [a]daptive (default u): " << reset;
+        getline(cin, tempInput);
+        const bool adaptive = !tempInput.empty() && std::tolower(static_cast<unsigned char>(tempInput[0])) == 'a';
+        AdaptiveSamplingOptions adaptiveOptions;
+        if (adaptive) {
+            adaptiveOptions.budget = static_cast<std::size_t>(std::max(graphWidth, 1)) * 4 * static_cast<std::size_t>(m_graphPlotDensityFactor);
+            cout << bold << bright_blue << "Enter evaluation budget (default " << adaptiveOptions.budget << "): " << reset;
+            getline(cin, tempInput);
+            if (!tempInput.empty()) adaptiveOptions.budget = static_cast<std::size_t>(std::max(2, std::stoi(tempInput)));
+            adaptiveOptions.columns = graphWidth;
+            adaptiveOptions.rows = graphHeight;
+            adaptiveOptions.initialIntervals = static_cast<std::size_t>(std::max(graphWidth / 2, 8));
+        }
+
         if (graphWidth <= 0 || graphHeight <=0 || xMin >= xMax) {
             cerr << red << "Invalid graph parameters. Aborting." << reset << endl;
             return;
         }
 
+        // f' and f'' are sampled by differentiating f automatically, which costs one dual-number pass
+        // per sample however large the symbolic derivative grows; the symbolic form is still compiled
+        // for the interval bounds.
+        const bool autodiffPlot = (derivativeOrder == 1 || derivativeOrder == 2) && compileExpression(derivativeOf) && prepareAutodiff();
+
         double actualMinY, actualMaxY;
-        // Calculate Min/Max Y. Sample more points than densityFactor for better accuracy.
-        int samplesForMinMax = std::max(graphWidth * m_graphPlotDensityFactor * 2, 500); // e.g. twice the plot points or at least 500
+        if (m_precision != Precision::Double && !adaptive && !autodiffPlot) {
+            cout << yellow << "Sampling in " << precisionName(m_precision) << " precision." << reset << endl;
+        }
         cout << yellow << "Calculating Y range for the expression..." << reset << endl;
-        calculateMinMaxY(exprStr, xMin, xMax, samplesForMinMax, actualMinY, actualMaxY);
+        if (!compileExpression(exprStr)) {
+            return; // Error message already printed by compileExpression
+        }
+        // Interval branch and bound gives a guaranteed Y range and the poles for most expressions.
+        // Without it, sample once more finely than the plot (e.g. twice the plot points or at least 500),
+        // on a grid that contains every plotted x, and take the range from those samples.
+        IntervalRangeResult bounds;
+        const bool haveBounds = boundYRangeWithIntervals(xMin, xMax, graphWidth, bounds);
+        const std::size_t plotPoints = static_cast<std::size_t>(std::max(graphWidth, graphWidth * m_graphPlotDensityFactor));
+        const std::size_t uniformSamples = haveBounds ? plotPoints
+                                                      : SampleBuffer::nestedSize(std::max<std::size_t>(plotPoints * 2, 500), plotPoints);
+        if (haveBounds) {
+            adaptiveOptions.yMin = bounds.minY;
+            adaptiveOptions.yMax = bounds.maxY;
+        }
+        SampleBuffer samples;
+        bool sampled = true;
+        if (autodiffPlot) {
+            auto derivativeBatch = [this, derivativeOrder](std::span<const double> xs, std::span<double> ys) {
+                evaluateDerivativeBatch(derivativeOrder, xs, ys);
+            };
+            if (adaptive) {
+                samples = sampleAdaptively(xMin, xMax, adaptiveOptions, derivativeBatch);
+            } else {
+                samples = SampleBuffer::uniformGrid(xMin, xMax, uniformSamples);
+                derivativeBatch(samples.xs, samples.ys);
+            }
+        } else {
+            sampled = adaptive ? sampleExpressionAdaptively(exprStr, xMin, xMax, adaptiveOptions, samples)
+                               : sampleExpression(exprStr, xMin, xMax, static_cast<int>(uniformSamples), samples);
+        }
+        if (!sampled) {
+            return; // Error message already printed by compileExpression
+        }
+        if (adaptive) {
+            cout << yellow << "Adaptive sampling used " << samples.size() << " of " << adaptiveOptions.budget << " evaluations." << reset << endl;
+        }
+        if (haveBounds) {
+            actualMinY = bounds.minY;
+            actualMaxY = bounds.maxY;
+            samples.poles = bounds.poles;
+            cout << yellow << "Y range bounded by interval arithmetic: f(x) in [" << bounds.lowerBound << ", " << bounds.upperBound
+                 << "] away from poles (" << bounds.boxes << " boxes, " << bounds.pointEvaluations << " evaluations"
+                 << (bounds.converged ? "" : ", budget exhausted") << ")." << reset << endl;
+            if (!bounds.poles.empty()) {
+                cout << yellow << "Poles near x =";
+                for (const auto& [poleLo, poleHi] : bounds.poles) cout << " " << (poleLo + poleHi) * 0.5;
+                cout << " (not drawn across)." << reset << endl;
+            }
+        } else {
+            calculateMinMaxY(samples, actualMinY, actualMaxY);
+        }
 
         if (std::isnan(actualMinY) || std::isnan(actualMaxY)) {
             cerr << red << "Could not determine Y range for the expression. Aborting graph." << reset << endl;
-            // This can happen if compileExpression failed inside calculateMinMaxY or all points were NaN
             return;
         }
         
         cout << green << "Calculated Y range: [" << actualMinY << ", " << actualMaxY << "]" << reset << endl;
 
-        plotAsciiGraph(exprStr, graphWidth, graphHeight, xMin, xMax, actualMinY, actualMaxY, m_graphPlotDensityFactor);
+        // The samples already bracket the roots; refining them costs a few evaluations each
+        const RootFindingResult roots = findRootsInSamples(samples, true);
+        if (!roots.roots.empty()) {
+            cout << yellow << "Roots in view (marked o):";
+            for (std::size_t i = 0; i < std::min(roots.roots.size(), ROOTS_SHOWN); ++i) cout << " " << roots.roots[i];
+            if (roots.roots.size() > ROOTS_SHOWN) cout << " ... (" << roots.roots.size() << " in total)";
+            cout << reset << endl;
+        }
+
+        plotAsciiGraph(exprStr, samples, graphWidth, graphHeight, xMin, xMax, actualMinY, actualMaxY, m_graphPlotDensityFactor, roots.roots);
     }
 };
@@ -0,0 +1,18 @@
+#pragma once
+
+// Instruction set extensions checked at run time. The build targets the baseline x86-64 (SSE2), so
+// code for newer units is compiled per function with [[gnu::target(...)]] and only called when the
+// CPU reports them.
+
+// True on x86-64 CPUs with AVX2 and FMA (Haswell, Zen and later)
+inline bool cpuHasAvx2Fma() {
+#if defined(__x86_64__)
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
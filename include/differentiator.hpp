@@ -0,0 +1,103 @@
+#pragma once
+
+#include "expression_tree.hpp"
+#include "simplifier.hpp"
+
+// Symbolic d/dx over the ExprNode tree. The rules are applied structurally and the result is run
+// through the simplifier, so "x^3" gives "3*x^2" rather than "3*x^(3-1)*1". The derivative is the
+// formal one: d/dx log(x) = 1/x is also defined where log(x) is not. Piecewise-constant functions
+// (floor, ceil, round, comparisons) differentiate to 0, and abs/min/max pick the active branch.
+// Returns nullptr for x % g(x), whose derivative the tree cannot express.
+class ExpressionDifferentiator {
+public:
+    static ExprPtr differentiate(const ExprPtr& root) {
+        const ExprPtr derivative = derive(root);
+        return derivative ? simplifyExpression(derivative) : nullptr;
+    }
+
+private:
+    static constexpr double LN10_CONST = 2.30258509299404568402;
+    static constexpr double LN2_CONST  = 0.69314718055994530942;
+
+    static ExprPtr num(double v) { return makeConstant(v); }
+    static ExprPtr add(ExprPtr a, ExprPtr b) { return makeBinary(ExprKind::Add, std::move(a), std::move(b)); }
+    static ExprPtr sub(ExprPtr a, ExprPtr b) { return makeBinary(ExprKind::Sub, std::move(a), std::move(b)); }
+    static ExprPtr mul(ExprPtr a, ExprPtr b) { return makeBinary(ExprKind::Mul, std::move(a), std::move(b)); }
+    static ExprPtr div(ExprPtr a, ExprPtr b) { return makeBinary(ExprKind::Div, std::move(a), std::move(b)); }
+    static ExprPtr pow(ExprPtr a, ExprPtr b) { return makeBinary(ExprKind::Pow, std::move(a), std::move(b)); }
+    static ExprPtr neg(ExprPtr a) { return makeUnary(ExprKind::Neg, std::move(a)); }
+    static ExprPtr call(ExprKind f, ExprPtr a) { return makeUnary(f, std::move(a)); }
+
+    // True if the subtree does not depend on x
+    static bool isConstantTree(const ExprNode& node) {
+        if (node.kind == ExprKind::VariableX) return false;
+        for (const auto& child : node.children) {
+            if (!isConstantTree(*child)) return false;
+        }
+        return true;
+    }
+
+    static ExprPtr derive(const ExprPtr& node) {
+        if (isConstantTree(*node)) return num(0.0);
+        if (node->kind == ExprKind::VariableX) return num(1.0);
+
+        const ExprPtr& u = node->children[0];
+        const ExprPtr& v = node->children.size() > 1 ? node->children[1] : node->children[0];
+        const ExprPtr du = derive(u);
+        const ExprPtr dv = node->children.size() > 1 ? derive(v) : du;
+        if (!du || !dv) return nullptr;
+
+        switch (node->kind) {
+            case ExprKind::Neg: return neg(du);
+            case ExprKind::Add: return add(du, dv);
+            case ExprKind::Sub: return sub(du, dv);
+            case ExprKind::Mul: return add(mul(du, v), mul(u, dv));
+            case ExprKind::Div: return div(sub(mul(du, v), mul(u, dv)), pow(v, num(2.0)));
+            case ExprKind::Mod: // fmod(u, c) - u has slope 1 between its jumps
+                return isConstantTree(*v) ? du : nullptr;
+            case ExprKind::Pow:
+                if (isConstantTree(*v)) return mul(mul(v, pow(u, sub(v, num(1.0)))), du);       // c*u^(c-1)*u'
+                if (isConstantTree(*u)) return mul(mul(node, call(ExprKind::Log, u)), dv);      // a^v*ln(a)*v'
+                return mul(node, add(mul(dv, call(ExprKind::Log, u)), div(mul(v, du), u)));     // u^v*(v'ln(u) + v*u'/u)
+
+            case ExprKind::Less: case ExprKind::LessEq: case ExprKind::Greater: case ExprKind::GreaterEq:
+            case ExprKind::Equal: case ExprKind::NotEqual: case ExprKind::Floor: case ExprKind::Ceil: case ExprKind::Round:
+                return num(0.0);
+            case ExprKind::Min: // The derivative of whichever operand is smaller (larger for max)
+                return add(mul(makeBinary(ExprKind::LessEq, u, v), du), mul(makeBinary(ExprKind::Greater, u, v), dv));
+            case ExprKind::Max:
+                return add(mul(makeBinary(ExprKind::GreaterEq, u, v), du), mul(makeBinary(ExprKind::Less, u, v), dv));
+            case ExprKind::Atan2: // (v*u' - u*v') / (u^2 + v^2)
+                return div(sub(mul(v, du), mul(u, dv)), add(pow(u, num(2.0)), pow(v, num(2.0))));
+            case ExprKind::Hypot: // (u*u' + v*v') / hypot(u, v)
+                return div(add(mul(u, du), mul(v, dv)), node);
+            case ExprKind::Abs: // sign(u)*u', 0 at the kink
+                return mul(sub(makeBinary(ExprKind::Greater, u, num(0.0)), makeBinary(ExprKind::Less, u, num(0.0))), du);
+
+            case ExprKind::Sin:   return mul(call(ExprKind::Cos, u), du);
+            case ExprKind::Cos:   return neg(mul(call(ExprKind::Sin, u), du));
+            case ExprKind::Tan:   return div(du, pow(call(ExprKind::Cos, u), num(2.0)));
+            case ExprKind::Asin:  return div(du, call(ExprKind::Sqrt, sub(num(1.0), pow(u, num(2.0)))));
+            case ExprKind::Acos:  return neg(div(du, call(ExprKind::Sqrt, sub(num(1.0), pow(u, num(2.0))))));
+            case ExprKind::Atan:  return div(du, add(num(1.0), pow(u, num(2.0))));
+            case ExprKind::Sinh:  return mul(call(ExprKind::Cosh, u), du);
+            case ExprKind::Cosh:  return mul(call(ExprKind::Sinh, u), du);
+            case ExprKind::Tanh:  return div(du, pow(call(ExprKind::Cosh, u), num(2.0)));
+            case ExprKind::Asinh: return div(du, call(ExprKind::Sqrt, add(pow(u, num(2.0)), num(1.0))));
+            case ExprKind::Acosh: return div(du, call(ExprKind::Sqrt, sub(pow(u, num(2.0)), num(1.0))));
+            case ExprKind::Atanh: return div(du, sub(num(1.0), pow(u, num(2.0))));
+            case ExprKind::Exp:   return mul(node, du);
+            case ExprKind::Log:   return div(du, u);
+            case ExprKind::Log10: return div(du, mul(num(LN10_CONST), u));
+            case ExprKind::Log2:  return div(du, mul(num(LN2_CONST), u));
+            case ExprKind::Sqrt:  return div(du, mul(num(2.0), node));
+            case ExprKind::Cbrt:  return div(du, mul(num(3.0), pow(node, num(2.0))));
+            default: return nullptr;
+        }
+    }
+};
+
+// d/dx of a tree, simplified; nullptr if some part has no symbolic derivative. See ExpressionDifferentiator.
+inline ExprPtr differentiateExpression(const ExprPtr& root) {
+    return ExpressionDifferentiator::differentiate(root);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Canonical form of an expression used as a cache key. exprtk matches identifiers and functions
+// case-insensitively, so the text is lowercased; whitespace is dropped except for one space where
+// it separates two word characters ("x and y", "2 x"), since removing that would change the tokens.
+inline std::string normalizeExpressionKey(const std::string& text) {
+    auto isWordChar = [](char c) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        return std::isalnum(u) || c == '_' || c == '.';
+    };
+    std::string key;
+    key.reserve(text.size());
+    bool pendingSpace = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !key.empty();
+            continue;
+        }
+        if (pendingSpace && isWordChar(key.back()) && isWordChar(c)) key += ' ';
+        pendingSpace = false;
+        key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+// Bounded least-recently-used map from normalized expression strings to compiled state.
+// find() and insert() are O(1); the least recently used entry is evicted once the cache is full.
+template <typename Value>
+class LruCache {
+public:
+    explicit LruCache(std::size_t capacity) : m_capacity(capacity ? capacity : 1), m_hits(0), m_misses(0) {}
+
+    // Returns the cached value for key and marks it most recently used, or nullptr on a miss.
+    Value* find(const std::string& key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return &it->second->second;
+    }
+
+    // Stores value under key as the most recently used entry, replacing any previous value.
+    Value& insert(const std::string& key, Value value) {
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            it->second->second = std::move(value);
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return it->second->second;
+        }
+        if (m_entries.size() >= m_capacity) {
+            m_index.erase(m_entries.back().first);
+            m_entries.pop_back();
+        }
+        m_entries.emplace_front(key, std::move(value));
+        m_index.emplace(key, m_entries.begin());
+        return m_entries.front().second;
+    }
+
+    void clear() {
+        m_entries.clear();
+        m_index.clear();
+    }
+
+    std::size_t size() const { return m_entries.size(); }
+    std::size_t capacity() const { return m_capacity; }
+    std::size_t hits() const { return m_hits; }
+    std::size_t misses() const { return m_misses; }
+
+private:
+    using Entry = std::pair<std::string, Value>;
+
+    std::size_t m_capacity;
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> m_index;
+    std::size_t m_hits;
+    std::size_t m_misses;
+};
@@ -0,0 +1,352 @@
+#pragma once
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A small, self-contained syntax tree for the subset of the exprtk language that mathd's
+// alternative backends understand: numbers, 'x', the pi/e constants, + - * / % ^, comparisons,
+// implicit multiplication and the common math functions. Precedence and associativity follow
+// exprtk ('^' is right-associative and binds tighter than unary minus, comparisons chain left).
+// Anything outside the subset makes the parser give up, and callers fall back to exprtk.
+
+enum class ExprKind : unsigned char {
+    Constant, VariableX,
+    Neg, Add, Sub, Mul, Div, Mod, Pow,
+    Less, LessEq, Greater, GreaterEq, Equal, NotEqual,
+    Min, Max, Atan2, Hypot,
+    Sin, Cos, Tan, Asin, Acos, Atan, Sinh, Cosh, Tanh, Asinh, Acosh, Atanh,
+    Exp, Log, Log10, Log2, Sqrt, Cbrt, Abs, Floor, Ceil, Round
+};
+
+struct ExprNode;
+using ExprPtr = std::shared_ptr<const ExprNode>;
+
+struct ExprNode {
+    ExprKind kind;
+    double value;                  // Only meaningful for ExprKind::Constant
+    std::vector<ExprPtr> children; // Operands, left to right
+
+    bool isConstant() const { return kind == ExprKind::Constant; }
+};
+
+inline ExprPtr makeConstant(double value) {
+    return std::make_shared<const ExprNode>(ExprNode{ExprKind::Constant, value, {}});
+}
+
+inline ExprPtr makeVariableX() {
+    return std::make_shared<const ExprNode>(ExprNode{ExprKind::VariableX, 0.0, {}});
+}
+
+inline ExprPtr makeUnary(ExprKind kind, ExprPtr operand) {
+    return std::make_shared<const ExprNode>(ExprNode{kind, 0.0, {std::move(operand)}});
+}
+
+inline ExprPtr makeBinary(ExprKind kind, ExprPtr lhs, ExprPtr rhs) {
+    return std::make_shared<const ExprNode>(ExprNode{kind, 0.0, {std::move(lhs), std::move(rhs)}});
+}
+
+// Name, kind and arity of every function the tree understands. Min/max accept two or more
+// arguments and are folded left to right, like exprtk's variadic versions.
+struct ExprFunctionInfo {
+    const char* name;
+    ExprKind kind;
+    int arity;
+};
+
+inline const std::vector<ExprFunctionInfo>& exprFunctionTable() {
+    static const std::vector<ExprFunctionInfo> table = {
+        {"sin", ExprKind::Sin, 1},     {"cos", ExprKind::Cos, 1},       {"tan", ExprKind::Tan, 1},
+        {"asin", ExprKind::Asin, 1},   {"acos", ExprKind::Acos, 1},     {"atan", ExprKind::Atan, 1},
+        {"sinh", ExprKind::Sinh, 1},   {"cosh", ExprKind::Cosh, 1},     {"tanh", ExprKind::Tanh, 1},
+        {"asinh", ExprKind::Asinh, 1}, {"acosh", ExprKind::Acosh, 1},   {"atanh", ExprKind::Atanh, 1},
+        {"exp", ExprKind::Exp, 1},     {"log", ExprKind::Log, 1},       {"log10", ExprKind::Log10, 1},
+        {"log2", ExprKind::Log2, 1},   {"sqrt", ExprKind::Sqrt, 1},     {"cbrt", ExprKind::Cbrt, 1},
+        {"abs", ExprKind::Abs, 1},     {"floor", ExprKind::Floor, 1},   {"ceil", ExprKind::Ceil, 1},
+        {"round", ExprKind::Round, 1}, {"pow", ExprKind::Pow, 2},       {"atan2", ExprKind::Atan2, 2},
+        {"hypot", ExprKind::Hypot, 2}, {"min", ExprKind::Min, -1},      {"max", ExprKind::Max, -1}
+    };
+    return table;
+}
+
+inline const ExprFunctionInfo* findExprFunction(const std::string& name) {
+    for (const auto& info : exprFunctionTable()) {
+        if (name == info.name) return &info;
+    }
+    return nullptr;
+}
+
+inline const ExprFunctionInfo* findExprFunction(ExprKind kind) {
+    for (const auto& info : exprFunctionTable()) {
+        if (kind == info.kind) return &info;
+    }
+    return nullptr;
+}
+
+// Recursive-descent parser producing an ExprNode tree. Returns nullptr on anything it does not
+// understand; it never reports errors itself since exprtk has already validated the input.
+class ExpressionTreeParser {
+public:
+    static ExprPtr parse(const std::string& text) {
+        ExpressionTreeParser parser(text);
+        ExprPtr root = parser.parseComparison();
+        parser.skipSpace();
+        if (!root || parser.m_pos != parser.m_text.size()) return nullptr;
+        return root;
+    }
+
+private:
+    static constexpr double PI_CONST = 3.14159265358979323846;
+    static constexpr double E_CONST  = 2.71828182845904523536;
+
+    explicit ExpressionTreeParser(const std::string& text) : m_text(text), m_pos(0) {}
+
+    const std::string& m_text;
+    std::size_t m_pos;
+
+    void skipSpace() {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) ++m_pos;
+    }
+
+    char peek() {
+        skipSpace();
+        return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+    }
+
+    bool accept(const char* token) {
+        skipSpace();
+        const std::size_t len = std::char_traits<char>::length(token);
+        if (m_text.compare(m_pos, len, token) != 0) return false;
+        m_pos += len;
+        return true;
+    }
+
+    // True if the next token can start an operand, i.e. juxtaposition means multiplication ("2x", "(x+1)(x-1)")
+    bool startsImplicitOperand() {
+        const char c = peek();
+        return std::isalpha(static_cast<unsigned char>(c)) || c == '_' || c == '(' ||
+               std::isdigit(static_cast<unsigned char>(c)) || c == '.';
+    }
+
+    ExprPtr parseComparison() {
+        ExprPtr lhs = parseAdditive();
+        while (lhs) {
+            ExprKind kind;
+            if (accept("<=")) kind = ExprKind::LessEq;
+            else if (accept(">=")) kind = ExprKind::GreaterEq;
+            else if (accept("<>") || accept("!=")) kind = ExprKind::NotEqual;
+            else if (accept("==") || accept("=")) kind = ExprKind::Equal;
+            else if (accept("<")) kind = ExprKind::Less;
+            else if (accept(">")) kind = ExprKind::Greater;
+            else break;
+            ExprPtr rhs = parseAdditive();
+            if (!rhs) return nullptr;
+            lhs = makeBinary(kind, lhs, rhs);
+        }
+        return lhs;
+    }
+
+    ExprPtr parseAdditive() {
+        ExprPtr lhs = parseTerm();
+        while (lhs) {
+            ExprKind kind;
+            if (accept("+")) kind = ExprKind::Add;
+            else if (accept("-")) kind = ExprKind::Sub;
+            else break;
+            ExprPtr rhs = parseTerm();
+            if (!rhs) return nullptr;
+            lhs = makeBinary(kind, lhs, rhs);
+        }
+        return lhs;
+    }
+
+    ExprPtr parseTerm() {
+        ExprPtr lhs = parseUnary();
+        while (lhs) {
+            ExprKind kind;
+            if (accept("*")) kind = ExprKind::Mul;
+            else if (accept("/")) kind = ExprKind::Div;
+            else if (accept("%")) kind = ExprKind::Mod;
+            else if (startsImplicitOperand()) kind = ExprKind::Mul;
+            else break;
+            ExprPtr rhs = parseUnary();
+            if (!rhs) return nullptr;
+            lhs = makeBinary(kind, lhs, rhs);
+        }
+        return lhs;
+    }
+
+    ExprPtr parseUnary() {
+        if (accept("-")) {
+            ExprPtr operand = parseUnary();
+            return operand ? makeUnary(ExprKind::Neg, operand) : nullptr;
+        }
+        if (accept("+")) return parseUnary();
+        return parsePower();
+    }
+
+    ExprPtr parsePower() {
+        ExprPtr base = parsePrimary();
+        if (base && accept("^")) {
+            ExprPtr exponent = parseUnary(); // Right-associative, and allows 2^-1
+            return exponent ? makeBinary(ExprKind::Pow, base, exponent) : nullptr;
+        }
+        return base;
+    }
+
+    ExprPtr parsePrimary() {
+        const char c = peek();
+        if (c == '(') {
+            ++m_pos;
+            ExprPtr inner = parseComparison();
+            return (inner && accept(")")) ? inner : nullptr;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') return parseNumber();
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') return parseIdentifier();
+        return nullptr;
+    }
+
+    ExprPtr parseNumber() {
+        const std::size_t start = m_pos;
+        while (m_pos < m_text.size() && (std::isdigit(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '.')) ++m_pos;
+        if (m_pos + 1 < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+            std::size_t j = m_pos + 1;
+            if (m_text[j] == '+' || m_text[j] == '-') ++j;
+            if (j < m_text.size() && std::isdigit(static_cast<unsigned char>(m_text[j]))) {
+                m_pos = j;
+                while (m_pos < m_text.size() && std::isdigit(static_cast<unsigned char>(m_text[m_pos]))) ++m_pos;
+            }
+        }
+        const std::string literal = m_text.substr(start, m_pos - start);
+        char* end = nullptr;
+        const double value = std::strtod(literal.c_str(), &end);
+        if (end != literal.c_str() + literal.size()) return nullptr;
+        return makeConstant(value);
+    }
+
+    ExprPtr parseIdentifier() {
+        const std::size_t start = m_pos;
+        while (m_pos < m_text.size() && (std::isalnum(static_cast<unsigned char>(m_text[m_pos])) || m_text[m_pos] == '_')) ++m_pos;
+        const std::string name = m_text.substr(start, m_pos - start);
+
+        if (name == "x") return makeVariableX();
+        if (name == "pi") return makeConstant(PI_CONST);
+        if (name == "e") return makeConstant(E_CONST);
+
+        const ExprFunctionInfo* info = findExprFunction(name);
+        if (!info || !accept("(")) return nullptr;
+
+        std::vector<ExprPtr> args;
+        do {
+            ExprPtr arg = parseComparison();
+            if (!arg) return nullptr;
+            args.push_back(arg);
+        } while (accept(","));
+        if (!accept(")")) return nullptr;
+
+        if (info->arity < 0) { // Variadic min/max
+            if (args.size() < 2) return nullptr;
+            ExprPtr folded = args[0];
+            for (std::size_t i = 1; i < args.size(); ++i) folded = makeBinary(info->kind, folded, args[i]);
+            return folded;
+        }
+        if (args.size() != static_cast<std::size_t>(info->arity)) return nullptr;
+        return std::make_shared<const ExprNode>(ExprNode{info->kind, 0.0, std::move(args)});
+    }
+};
+
+// Counts the nodes of a tree (shared subtrees are counted once per reference).
+inline std::size_t countExprNodes(const ExprPtr& node) {
+    if (!node) return 0;
+    std::size_t count = 1;
+    for (const auto& child : node->children) count += countExprNodes(child);
+    return count;
+}
+
+// Precedence level of a node when written out: 1 comparison, 2 additive, 3 multiplicative,
+// 4 unary minus, 5 power, 6 primary (numbers, 'x', calls, parenthesized text).
+inline int exprFormatLevel(const ExprNode& node) {
+    switch (node.kind) {
+        case ExprKind::Constant: return (std::isfinite(node.value) && std::signbit(node.value)) ? 4 : 6;
+        case ExprKind::VariableX: return 6;
+        case ExprKind::Neg: return 4;
+        case ExprKind::Pow: return 5;
+        case ExprKind::Mul: case ExprKind::Div: case ExprKind::Mod: return 3;
+        case ExprKind::Add: case ExprKind::Sub: return 2;
+        case ExprKind::Less: case ExprKind::LessEq: case ExprKind::Greater:
+        case ExprKind::GreaterEq: case ExprKind::Equal: case ExprKind::NotEqual: return 1;
+        default: return 6;
+    }
+}
+
+inline void formatExpressionTo(const ExprNode& node, std::string& out);
+
+// Writes an operand, parenthesized if it binds looser than minLevel. A unary minus is never
+// written straight after another operator ("a-(-b)", not "a--b").
+inline void formatExprOperand(const ExprNode& node, int minLevel, bool allowUnary, std::string& out) {
+    const int level = exprFormatLevel(node);
+    const bool parens = level < minLevel || (level == 4 && !allowUnary);
+    if (parens) out += '(';
+    formatExpressionTo(node, out);
+    if (parens) out += ')';
+}
+
+inline void formatExpressionTo(const ExprNode& node, std::string& out) {
+    const char* symbol = nullptr;
+    int level = exprFormatLevel(node);
+    switch (node.kind) {
+        case ExprKind::Constant: {
+            if (std::isnan(node.value)) { out += "(0/0)"; return; }
+            if (std::isinf(node.value)) { out += node.value > 0 ? "(1/0)" : "(-1/0)"; return; }
+            char buffer[32];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), node.value); // Shortest round-trip form
+            out.append(buffer, result.ptr);
+            return;
+        }
+        case ExprKind::VariableX: out += 'x'; return;
+        case ExprKind::Neg:
+            out += '-';
+            formatExprOperand(*node.children[0], 4, false, out);
+            return;
+        case ExprKind::Add: symbol = "+"; break;    case ExprKind::Sub: symbol = "-"; break;
+        case ExprKind::Mul: symbol = "*"; break;    case ExprKind::Div: symbol = "/"; break;
+        case ExprKind::Mod: symbol = "%"; break;    case ExprKind::Pow: symbol = "^"; break;
+        case ExprKind::Less: symbol = "<"; break;   case ExprKind::LessEq: symbol = "<="; break;
+        case ExprKind::Greater: symbol = ">"; break; case ExprKind::GreaterEq: symbol = ">="; break;
+        case ExprKind::Equal: symbol = "=="; break;  case ExprKind::NotEqual: symbol = "!="; break;
+        default: break;
+    }
+    if (symbol) {
+        if (node.kind == ExprKind::Pow) { // Right-associative and tighter than unary minus: keep both sides primary
+            formatExprOperand(*node.children[0], 6, false, out);
+            out += symbol;
+            formatExprOperand(*node.children[1], 6, false, out);
+        } else {
+            formatExprOperand(*node.children[0], level, true, out);
+            out += symbol;
+            formatExprOperand(*node.children[1], level + 1, false, out);
+        }
+        return;
+    }
+    const ExprFunctionInfo* info = findExprFunction(node.kind);
+    out += info ? info->name : "?";
+    out += '(';
+    for (std::size_t i = 0; i < node.children.size(); ++i) {
+        if (i > 0) out += ',';
+        formatExprOperand(*node.children[i], 1, true, out);
+    }
+    out += ')';
+}
+
+// Writes a tree back out as exprtk source with minimal parentheses. The text has no whitespace
+// and is lowercase, i.e. it is already in normalizeExpressionKey() form, and parses back to the
+// same tree (non-finite constants are spelled as divisions, which evaluate to the same value).
+inline std::string formatExpression(const ExprPtr& node) {
+    std::string out;
+    if (node) formatExpressionTo(*node, out);
+    return out;
+}
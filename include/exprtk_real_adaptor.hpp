@@ -0,0 +1,137 @@
+#pragma once
+
+#include <limits>
+#include <type_traits>
+
+// Lets exprtk compile and evaluate expressions over class types that behave like floating-point
+// numbers (Float128, and any other type with a std::numeric_limits specialization). Such a type is
+// registered as one of exprtk's real types, and every numeric primitive that exprtk implements with
+// std:: functions or double constants is overridden below by a more constrained template that calls
+// the type's own functions through argument-dependent lookup instead. The type has to provide abs,
+// sqrt, exp, expm1, log, log1p, log10, log2, pow, fmod, hypot, floor, ceil, trunc, round, sin, cos,
+// tan, asin, acos, atan, atan2, sinh, cosh, tanh, asinh, acosh, atanh, erf and erfc, plus isnan.
+// Literals are parsed by exprtk's own digit loop in T and scaled by powers of ten computed in T, so
+// "0.1" is exact to T's precision. Include this header before anything that includes exprtk.hpp.
+
+template <typename T>
+concept ExprtkAdaptedReal = std::is_class_v<T> && std::numeric_limits<T>::is_specialized && !std::numeric_limits<T>::is_integer;
+
+#ifdef INCLUDE_EXPRTK_HPP
+#error "exprtk_real_adaptor.hpp must be included before exprtk.hpp"
+#endif
+
+// exprtk's operators call details::is_true() by its qualified name, which only sees overloads
+// declared ahead of exprtk itself
+namespace exprtk::details {
+    template <ExprtkAdaptedReal T>
+    inline bool is_true(const T& v) { return v != T(0); }
+
+    // d * 10^exponent for literals; exprtk's own version multiplies by a table of doubles, which are
+    // inexact beyond 10^22 and limited to double's range
+    template <ExprtkAdaptedReal T>
+    inline T compute_pow10(T d, const int exponent) {
+        T scale(1), power(10);
+        for (unsigned int e = static_cast<unsigned int>(exponent < 0 ? -exponent : exponent); e > 0; e >>= 1) {
+            if (e & 1) scale *= power;
+            if (e > 1) power *= power;
+        }
+        return (exponent < 0) ? d / scale : d * scale;
+    }
+}
+
+#include "exprtk.hpp"
+
+namespace exprtk::details {
+    namespace numeric {
+        namespace details {
+            template <ExprtkAdaptedReal T>
+            struct number_type<T> { typedef real_type_tag type; number_type() {} };
+
+            // Tolerance of exprtk's == and != (a relative 1e-10 for double): a few ulps of T
+            template <ExprtkAdaptedReal T>
+            struct epsilon_type<T> {
+                static inline T value() { return std::numeric_limits<T>::epsilon() * T(16); }
+            };
+
+            // Constants to T's full precision, computed once per type
+            template <ExprtkAdaptedReal T>
+            inline const T& adapted_pi() { static const T pi = acos(T(-1)); return pi; }
+            template <ExprtkAdaptedReal T>
+            inline const T& adapted_e() { static const T e = exp(T(1)); return e; }
+
+            template <typename T> requires ExprtkAdaptedReal<T> inline T const_pi_impl(real_type_tag) { return adapted_pi<T>(); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T const_e_impl(real_type_tag) { return adapted_e<T>(); }
+
+            template <typename T> requires ExprtkAdaptedReal<T> inline bool is_nan_impl(const T v, real_type_tag) { return isnan(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline bool is_integer_impl(const T& v, real_type_tag) { return trunc(v) == v; }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T expm1_impl(const T v, real_type_tag) { return expm1(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T modulus_impl(const T v0, const T v1, real_type_tag) { return fmod(v0, v1); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T pow_impl(const T v0, const T v1, real_type_tag) { return pow(v0, v1); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T logn_impl(const T v0, const T v1, real_type_tag) { return log(v0) / log(v1); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T log1p_impl(const T v, real_type_tag) { return log1p(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T hypot_impl(const T v0, const T v1, real_type_tag) { return hypot(v0, v1); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T atan2_impl(const T v0, const T v1, real_type_tag) { return atan2(v0, v1); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T round_impl(const T v, real_type_tag) { return round(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T erf_impl(const T v, real_type_tag) { return erf(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T erfc_impl(const T v, real_type_tag) { return erfc(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T ncdf_impl(const T v, real_type_tag) { return T(0.5) * erfc(-v / sqrt(T(2))); }
+
+            template <typename T> requires ExprtkAdaptedReal<T>
+            inline T root_impl(const T v0, const T v1, real_type_tag) {
+                if (v1 < T(0)) return std::numeric_limits<T>::quiet_NaN();
+                const T n = trunc(v1);
+                if (v0 < T(0) && fmod(n, T(2)) == T(0)) return std::numeric_limits<T>::quiet_NaN();
+                return (v0 < T(0)) ? -pow(-v0, T(1) / n) : pow(v0, T(1) / n);
+            }
+
+            template <typename T> requires ExprtkAdaptedReal<T>
+            inline T roundn_impl(const T v0, const T v1, real_type_tag) {
+                const T scale = pow(T(10), trunc(v1));
+                return round(v0 * scale) / scale;
+            }
+
+            template <typename T> requires ExprtkAdaptedReal<T> inline T shr_impl(const T v0, const T v1, real_type_tag) { return v0 / pow(T(2), trunc(v1)); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T shl_impl(const T v0, const T v1, real_type_tag) { return v0 * pow(T(2), trunc(v1)); }
+
+            template <typename T> requires ExprtkAdaptedReal<T>
+            inline T sinc_impl(const T v, real_type_tag) {
+                return (abs(v) >= std::numeric_limits<T>::epsilon()) ? sin(v) / v : T(1);
+            }
+
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  acos_impl(const T v, real_type_tag) { return acos (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T acosh_impl(const T v, real_type_tag) { return acosh(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  asin_impl(const T v, real_type_tag) { return asin (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T asinh_impl(const T v, real_type_tag) { return asinh(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  atan_impl(const T v, real_type_tag) { return atan (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T atanh_impl(const T v, real_type_tag) { return atanh(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  ceil_impl(const T v, real_type_tag) { return ceil (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   cos_impl(const T v, real_type_tag) { return cos  (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  cosh_impl(const T v, real_type_tag) { return cosh (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   exp_impl(const T v, real_type_tag) { return exp  (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T floor_impl(const T v, real_type_tag) { return floor(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   log_impl(const T v, real_type_tag) { return log  (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T log10_impl(const T v, real_type_tag) { return log10(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  log2_impl(const T v, real_type_tag) { return log2 (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   sin_impl(const T v, real_type_tag) { return sin  (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  sinh_impl(const T v, real_type_tag) { return sinh (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  sqrt_impl(const T v, real_type_tag) { return sqrt (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   tan_impl(const T v, real_type_tag) { return tan  (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  tanh_impl(const T v, real_type_tag) { return tanh (v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   cot_impl(const T v, real_type_tag) { return T(1) / tan(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   sec_impl(const T v, real_type_tag) { return T(1) / cos(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   csc_impl(const T v, real_type_tag) { return T(1) / sin(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   r2d_impl(const T v, real_type_tag) { return v * (T(180) / adapted_pi<T>()); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   d2r_impl(const T v, real_type_tag) { return v * (adapted_pi<T>() / T(180)); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   d2g_impl(const T v, real_type_tag) { return v * T(10) / T(9); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T   g2d_impl(const T v, real_type_tag) { return v * T(9) / T(10); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T  frac_impl(const T v, real_type_tag) { return v - trunc(v); }
+            template <typename T> requires ExprtkAdaptedReal<T> inline T trunc_impl(const T v, real_type_tag) { return trunc(v); }
+        }
+
+        template <ExprtkAdaptedReal T>
+        struct numeric_info<T> {
+            enum { length = 0, size = 32, bound_length = 0,
+                   min_exp = std::numeric_limits<T>::min_exponent10, max_exp = std::numeric_limits<T>::max_exponent10 };
+        };
+    }
+}
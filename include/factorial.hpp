@@ -0,0 +1,64 @@
+#pragma once
+
+#include "big_integer.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Exact n! by Luschny's prime-swing algorithm: n! = ((n/2)!)^2 * swing(n), where the swinging
+// factorial swing(n) = n! / ((n/2)!)^2 is a product of primes p <= n, each raised to the number of
+// k with floor(n / p^k) odd. The prime powers are packed into 32-bit factors and multiplied by
+// binary splitting, so nearly all of the work is a few large balanced Karatsuba products.
+namespace factorial_detail {
+    // Primes up to n by the sieve of Eratosthenes
+    inline std::vector<std::uint32_t> primesUpTo(std::uint32_t n) {
+        std::vector<std::uint32_t> primes;
+        if (n < 2) return primes;
+        std::vector<bool> composite(static_cast<std::size_t>(n) + 1, false);
+        for (std::uint64_t p = 2; p <= n; ++p) {
+            if (composite[p]) continue;
+            primes.push_back(static_cast<std::uint32_t>(p));
+            for (std::uint64_t multiple = p * p; multiple <= n; multiple += p) composite[multiple] = true;
+        }
+        return primes;
+    }
+
+    inline BigUnsigned swing(std::uint32_t n, const std::vector<std::uint32_t>& primes) {
+        std::vector<std::uint32_t> factors;
+        std::uint64_t packed = 1;
+        for (const std::uint32_t p : primes) {
+            if (p > n) break;
+            for (std::uint64_t q = n / p; q > 0; q /= p) {
+                if ((q & 1) == 0) continue;
+                if (packed * p > UINT32_MAX) {
+                    factors.push_back(static_cast<std::uint32_t>(packed));
+                    packed = 1;
+                }
+                packed *= p;
+            }
+        }
+        factors.push_back(static_cast<std::uint32_t>(packed));
+        return BigUnsigned::product(factors);
+    }
+
+    inline BigUnsigned factorial(std::uint32_t n, const std::vector<std::uint32_t>& primes) {
+        static constexpr std::uint32_t SMALL = 32; // Direct products below this
+        if (n < SMALL) {
+            BigUnsigned result(1);
+            for (std::uint32_t k = 2; k <= n; ++k) result *= k;
+            return result;
+        }
+        const BigUnsigned half = factorial(n / 2, primes);
+        return half * half * swing(n, primes);
+    }
+}
+
+inline BigUnsigned exactFactorial(std::uint32_t n) {
+    return factorial_detail::factorial(n, factorial_detail::primesUpTo(n));
+}
+
+// log10(n!) via lgamma in long double (Gamma(n + 1) for non-integer n). The fractional part, and
+// so the significand of n!, keeps about 19 - log10(log10(n!)) significant digits.
+inline long double log10Factorial(long double n) {
+    return std::lgamma(n + 1.0L) / std::log(10.0L);
+}
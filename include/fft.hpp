@@ -0,0 +1,444 @@
+#pragma once
+
+#include "cpu_features.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Discrete Fourier transforms of any length. Powers of two are split-radix, recursive down to
+// LEAF_SIZE points (so each level of the recursion works in cache) and iterative radix-2^2 below
+// that, in place on a bit-reversed copy of the input; the butterflies of both run two complex numbers per
+// AVX2 register when the CPU has AVX2 and FMA. Other lengths use Bluestein's chirp-z algorithm on a
+// power-of-two transform of at least 2n - 1 points. Real input of even length n is transformed as
+// n/2 complex numbers and separated afterwards, at a little over half the cost.
+// Every twiddle factor comes from a table computed once per plan with sin/cos, not by recurrence,
+// so the error grows like log n rather than n.
+
+using Complex = std::complex<double>;
+
+namespace fft_detail {
+    constexpr std::size_t LEAF_SIZE = 1024; // Points per iterative leaf transform: 16 KB, for L1
+    constexpr double TWO_PI = 6.28318530717958647692;
+    constexpr double NOISE_FLOOR = 1e-12; // Spectral peaks this far below the signal are rounding error
+
+    // exp(-2 pi i k / n)
+    inline Complex rootOfUnity(std::size_t k, std::size_t n) {
+        const double angle = -TWO_PI * static_cast<double>(k) / static_cast<double>(n);
+        return {std::cos(angle), std::sin(angle)};
+    }
+
+    // Written out: std::complex's operator* checks for infinities and NaNs through a library call
+    inline Complex multiply(Complex a, Complex b) {
+        return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+    }
+
+    inline Complex timesMinusI(Complex a) { return {a.imag(), -a.real()}; }
+
+    // The butterflies of one transform, on interleaved (re, im) doubles. Both variants compute the same thing.
+    struct Butterflies {
+        // Split-radix step for a size-m transform whose evens (m/2 points at u), 1 mod 4 (m/4 at z1)
+        // and 3 mod 4 (m/4 at z3) are already transformed; twiddle k is w1[k * step], w3[k * step]
+        void (*combine)(Complex* u, std::size_t m, const Complex* w1, const Complex* w3, std::size_t step);
+        // Two fused radix-2 stages: four size-h transforms at x, x + h, x + 2h, x + 3h into one of size
+        // 4h, in place; twiddles w_4h^k are table[k * step] and w_2h^k are table[2 k * step]
+        void (*radix4)(Complex* x, std::size_t h, const Complex* table, std::size_t step);
+    };
+
+    inline void combineGeneric(Complex* u, std::size_t m, const Complex* w1, const Complex* w3, std::size_t step) {
+        const std::size_t quarter = m / 4;
+        Complex* z1 = u + m / 2;
+        Complex* z3 = z1 + quarter;
+        for (std::size_t k = 0; k < quarter; ++k) {
+            const Complex a = multiply(z1[k], w1[k * step]), b = multiply(z3[k], w3[k * step]);
+            const Complex sum = a + b, difference = timesMinusI(a - b);
+            const Complex u0 = u[k], u1 = u[k + quarter];
+            u[k] = u0 + sum;
+            z1[k] = u0 - sum;
+            u[k + quarter] = u1 + difference;
+            z3[k] = u1 - difference;
+        }
+    }
+
+    inline void radix4Generic(Complex* x, std::size_t h, const Complex* table, std::size_t step) {
+        for (std::size_t k = 0; k < h; ++k) {
+            const Complex w4 = table[k * step], w2 = table[2 * k * step];
+            const Complex t1 = multiply(x[k + h], w2), t3 = multiply(x[k + 3 * h], w2);
+            const Complex e0 = x[k] + t1, e1 = x[k] - t1, o0 = x[k + 2 * h] + t3, o1 = x[k + 2 * h] - t3;
+            const Complex v0 = multiply(o0, w4), v1 = timesMinusI(multiply(o1, w4));
+            x[k] = e0 + v0;
+            x[k + 2 * h] = e0 - v0;
+            x[k + h] = e1 + v1;
+            x[k + 3 * h] = e1 - v1;
+        }
+    }
+
+#if defined(__x86_64__)
+    // Two complex products at once: (ar + i ai)(wr + i wi) lane by lane
+    [[gnu::target("avx2,fma")]]
+    inline __m256d multiplyAvx2(__m256d a, __m256d w) {
+        const __m256d wr = _mm256_movedup_pd(w);          // wr0 wr0 wr1 wr1
+        const __m256d wi = _mm256_permute_pd(w, 0xF);     // wi0 wi0 wi1 wi1
+        const __m256d swapped = _mm256_permute_pd(a, 0x5); // ai0 ar0 ai1 ar1
+        return _mm256_fmaddsub_pd(a, wr, _mm256_mul_pd(swapped, wi));
+    }
+
+    [[gnu::target("avx2,fma")]]
+    inline __m256d timesMinusIAvx2(__m256d a) {
+        return _mm256_xor_pd(_mm256_permute_pd(a, 0x5), _mm256_set_pd(-0.0, 0.0, -0.0, 0.0));
+    }
+
+    [[gnu::target("avx2,fma")]]
+    inline __m256d loadAvx2(const Complex* p) { return _mm256_loadu_pd(reinterpret_cast<const double*>(p)); }
+
+    [[gnu::target("avx2,fma")]]
+    inline void storeAvx2(Complex* p, __m256d v) { _mm256_storeu_pd(reinterpret_cast<double*>(p), v); }
+
+    // Twiddles k and k + 1 of a table read with the given step
+    [[gnu::target("avx2,fma")]]
+    inline __m256d loadTwiddlesAvx2(const Complex* table, std::size_t k, std::size_t step) {
+        if (step == 1) return loadAvx2(table + k);
+        const __m128d first = _mm_loadu_pd(reinterpret_cast<const double*>(table + k * step));
+        const __m128d second = _mm_loadu_pd(reinterpret_cast<const double*>(table + (k + 1) * step));
+        return _mm256_insertf128_pd(_mm256_castpd128_pd256(first), second, 1);
+    }
+
+    // m / 4 is even for every m these are called with
+    [[gnu::target("avx2,fma")]]
+    inline void combineAvx2(Complex* u, std::size_t m, const Complex* w1, const Complex* w3, std::size_t step) {
+        const std::size_t quarter = m / 4;
+        Complex* z1 = u + m / 2;
+        Complex* z3 = z1 + quarter;
+        for (std::size_t k = 0; k < quarter; k += 2) {
+            const __m256d a = multiplyAvx2(loadAvx2(z1 + k), loadTwiddlesAvx2(w1, k, step));
+            const __m256d b = multiplyAvx2(loadAvx2(z3 + k), loadTwiddlesAvx2(w3, k, step));
+            const __m256d sum = _mm256_add_pd(a, b), difference = timesMinusIAvx2(_mm256_sub_pd(a, b));
+            const __m256d u0 = loadAvx2(u + k), u1 = loadAvx2(u + k + quarter);
+            storeAvx2(u + k, _mm256_add_pd(u0, sum));
+            storeAvx2(z1 + k, _mm256_sub_pd(u0, sum));
+            storeAvx2(u + k + quarter, _mm256_add_pd(u1, difference));
+            storeAvx2(z3 + k, _mm256_sub_pd(u1, difference));
+        }
+    }
+
+    [[gnu::target("avx2,fma")]]
+    inline void radix4Avx2(Complex* x, std::size_t h, const Complex* table, std::size_t step) {
+        if (h % 2 != 0) { // Only h = 1: a single butterfly
+            radix4Generic(x, h, table, step);
+            return;
+        }
+        for (std::size_t k = 0; k < h; k += 2) {
+            const __m256d w4 = loadTwiddlesAvx2(table, k, step), w2 = loadTwiddlesAvx2(table, k, 2 * step);
+            const __m256d t1 = multiplyAvx2(loadAvx2(x + k + h), w2), t3 = multiplyAvx2(loadAvx2(x + k + 3 * h), w2);
+            const __m256d x0 = loadAvx2(x + k), x2 = loadAvx2(x + k + 2 * h);
+            const __m256d e0 = _mm256_add_pd(x0, t1), e1 = _mm256_sub_pd(x0, t1);
+            const __m256d o0 = _mm256_add_pd(x2, t3), o1 = _mm256_sub_pd(x2, t3);
+            const __m256d v0 = multiplyAvx2(o0, w4), v1 = timesMinusIAvx2(multiplyAvx2(o1, w4));
+            storeAvx2(x + k, _mm256_add_pd(e0, v0));
+            storeAvx2(x + k + 2 * h, _mm256_sub_pd(e0, v0));
+            storeAvx2(x + k + h, _mm256_add_pd(e1, v1));
+            storeAvx2(x + k + 3 * h, _mm256_sub_pd(e1, v1));
+        }
+    }
+#endif
+
+    inline Butterflies selectButterflies() {
+#if defined(__x86_64__)
+        if (cpuHasAvx2Fma()) return {combineAvx2, radix4Avx2};
+#endif
+        return {combineGeneric, radix4Generic};
+    }
+
+    inline bool isPowerOfTwo(std::size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+    // Forward transform of a power-of-two length: X[k] = sum_j x[j] exp(-2 pi i j k / n). The input
+    // is copied in bit-reversed order first, which puts the even points in the first half, the
+    // points 1 mod 4 in the third quarter and those 3 mod 4 in the last, each again bit-reversed: so
+    // the split-radix recursion, and the leaves, work in place on contiguous blocks.
+    class PowerOfTwoFft {
+    public:
+        explicit PowerOfTwoFft(std::size_t n) : m_n(n), m_bits(std::countr_zero(n)), m_leafSize(std::min(n, LEAF_SIZE)), m_butterflies(selectButterflies()) {
+            m_leafTwiddles.resize(m_leafSize / 2);
+            for (std::size_t k = 0; k < m_leafTwiddles.size(); ++k) m_leafTwiddles[k] = rootOfUnity(k, m_leafSize);
+            // The permutation: directly for small n, else BLOCK_BITS at each end around a middle table
+            const int tableBits = m_bits <= 2 * BLOCK_BITS ? m_bits : m_bits - 2 * BLOCK_BITS;
+            m_bitReverse.resize(std::size_t{1} << tableBits);
+            for (std::size_t j = 0; j < m_bitReverse.size(); ++j) m_bitReverse[j] = reverseBits(j, tableBits);
+            if (n > m_leafSize) {
+                m_twiddles.resize(n / 2);
+                for (std::size_t k = 0; k < n / 4; ++k) {
+                    m_twiddles[k] = rootOfUnity(k, n);
+                    m_twiddles[n / 4 + k] = rootOfUnity(3 * k, n);
+                }
+            }
+            // Lower levels read the top table with a stride n / m; small ones get a contiguous copy
+            for (std::size_t m = 2 * m_leafSize; m < n && m <= LEVEL_TABLE_LIMIT; m *= 2) {
+                std::vector<Complex>& level = m_levelTwiddles[std::countr_zero(m)];
+                level.resize(m / 2);
+                for (std::size_t k = 0; k < m / 4; ++k) {
+                    level[k] = m_twiddles[k * (n / m)];
+                    level[m / 4 + k] = m_twiddles[n / 4 + k * (n / m)];
+                }
+            }
+        }
+
+        std::size_t size() const { return m_n; }
+
+        // output = DFT(input); the two must not overlap
+        void transform(const Complex* input, Complex* output) const {
+            bitReverseCopy(input, output);
+            transformInPlace(output, m_n);
+        }
+
+    private:
+        static constexpr int BLOCK_BITS = 5; // Low and high index bits permuted per block: 32 x 32 points, 16 KB
+        static constexpr std::size_t LEVEL_TABLE_LIMIT = 1 << 16; // Largest level with its own twiddle table
+
+        static std::uint32_t reverseBits(std::size_t j, int bits) {
+            std::uint32_t reversed = 0;
+            for (int b = 0; b < bits; ++b) reversed |= static_cast<std::uint32_t>((j >> b) & 1) << (bits - 1 - b);
+            return reversed;
+        }
+
+        // output[reverse(j)] = input[j]. For j = (high, middle, low) with BLOCK_BITS-bit high and low
+        // parts, reverse(j) = (reverse(low), reverse(middle), reverse(high)): a 32 x 32 block for
+        // each middle value reads and writes 32 runs of 32 points, rather than scattering n writes.
+        void bitReverseCopy(const Complex* input, Complex* output) const {
+            if (m_bits <= 2 * BLOCK_BITS) {
+                for (std::size_t j = 0; j < m_n; ++j) output[m_bitReverse[j]] = input[j];
+                return;
+            }
+            constexpr std::size_t BLOCK = std::size_t{1} << BLOCK_BITS;
+            const int highShift = m_bits - BLOCK_BITS;
+            for (std::size_t middle = 0; middle < m_bitReverse.size(); ++middle) {
+                const std::size_t readMiddle = middle << BLOCK_BITS, writeMiddle = std::size_t{m_bitReverse[middle]} << BLOCK_BITS;
+                for (std::size_t high = 0; high < BLOCK; ++high) {
+                    const Complex* source = input + (high << highShift) + readMiddle;
+                    Complex* target = output + writeMiddle + reverseBits(high, BLOCK_BITS);
+                    for (std::size_t low = 0; low < BLOCK; ++low) target[std::size_t{s_blockReverse[low]} << highShift] = source[low];
+                }
+            }
+        }
+
+        // data[0, m) holds m points in bit-reversed order; transforms them in place
+        void transformInPlace(Complex* data, std::size_t m) const {
+            if (m <= m_leafSize) {
+                leaf(data, m);
+                return;
+            }
+            transformInPlace(data, m / 2);
+            transformInPlace(data + m / 2, m / 4);
+            transformInPlace(data + 3 * m / 4, m / 4);
+            const std::vector<Complex>& level = m_levelTwiddles[std::countr_zero(m)];
+            if (!level.empty()) {
+                m_butterflies.combine(data, m, level.data(), level.data() + m / 4, 1);
+            } else {
+                m_butterflies.combine(data, m, m_twiddles.data(), m_twiddles.data() + m_n / 4, m_n / m);
+            }
+        }
+
+        // Iterative radix-2^2 on m <= m_leafSize points; the split makes leaves of m_leafSize / 2 as well
+        void leaf(Complex* data, std::size_t m) const {
+            std::size_t h = 1;
+            if ((std::countr_zero(m) & 1) != 0) { // An odd number of radix-2 stages: do one on its own
+                for (std::size_t j = 0; j < m; j += 2) {
+                    const Complex a = data[j], b = data[j + 1];
+                    data[j] = a + b;
+                    data[j + 1] = a - b;
+                }
+                h = 2;
+            }
+            for (; 4 * h <= m; h *= 4) {
+                const std::size_t step = m_leafSize / (4 * h);
+                for (std::size_t block = 0; block < m; block += 4 * h) m_butterflies.radix4(data + block, h, m_leafTwiddles.data(), step);
+            }
+        }
+
+        static constexpr std::array<std::uint8_t, 32> s_blockReverse = [] {
+            std::array<std::uint8_t, 32> table{};
+            for (std::size_t j = 0; j < table.size(); ++j) {
+                for (int b = 0; b < BLOCK_BITS; ++b) table[j] |= static_cast<std::uint8_t>(((j >> b) & 1) << (BLOCK_BITS - 1 - b));
+            }
+            return table;
+        }();
+
+        std::size_t m_n;
+        int m_bits;                               // log2(n)
+        std::size_t m_leafSize;
+        Butterflies m_butterflies;
+        std::vector<Complex> m_leafTwiddles;      // exp(-2 pi i k / m_leafSize) for k < m_leafSize / 2
+        std::vector<std::uint32_t> m_bitReverse;  // Of all log2(n)-bit indices, or of the middle bits
+        std::vector<Complex> m_twiddles;          // exp(-2 pi i k / n), then exp(-2 pi i 3k / n), for k < n / 4
+        std::array<std::vector<Complex>, 64> m_levelTwiddles; // The same for size 2^level, up to LEVEL_TABLE_LIMIT
+    };
+}
+
+// A plan for transforms of one length n >= 1: the twiddle tables (and, for lengths other than
+// powers of two, Bluestein's chirp and its spectrum) are built by the constructor and shared by
+// every call, which is const and may run on several threads at once
+class Fft {
+public:
+    explicit Fft(std::size_t n) : m_n(n), m_radix(paddedSize(n)) {
+        if (fft_detail::isPowerOfTwo(n)) return;
+        // Bluestein: X[k] = c[k] * sum_j (x[j] c[j]) conj(c[k - j]) with c[k] = exp(-pi i k^2 / n), a
+        // convolution done with a padded power-of-two transform. k^2 is reduced mod 2n exactly first.
+        const std::size_t padded = m_radix.size();
+        m_chirp.resize(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            const std::uint64_t square = static_cast<std::uint64_t>(k) * k % (2 * static_cast<std::uint64_t>(n));
+            m_chirp[k] = fft_detail::rootOfUnity(static_cast<std::size_t>(square), 2 * n);
+        }
+        std::vector<Complex> kernel(padded);
+        kernel[0] = std::conj(m_chirp[0]);
+        for (std::size_t k = 1; k < n; ++k) kernel[k] = kernel[padded - k] = std::conj(m_chirp[k]);
+        m_chirpSpectrum.resize(padded);
+        m_radix.transform(kernel.data(), m_chirpSpectrum.data());
+        for (Complex& value : m_chirpSpectrum) value /= static_cast<double>(padded); // The inverse transform's 1/n, folded in
+    }
+
+    std::size_t size() const { return m_n; }
+
+    // output[k] = sum_j input[j] exp(-2 pi i j k / n). Both spans hold n values and must not overlap.
+    void forward(std::span<const Complex> input, std::span<Complex> output) const {
+        if (m_chirp.empty()) {
+            m_radix.transform(input.data(), output.data());
+            return;
+        }
+        const std::size_t padded = m_radix.size();
+        std::vector<Complex> scaled(padded), convolved(padded);
+        for (std::size_t k = 0; k < m_n; ++k) scaled[k] = fft_detail::multiply(input[k], m_chirp[k]);
+        m_radix.transform(scaled.data(), convolved.data());
+        for (std::size_t k = 0; k < padded; ++k) convolved[k] = std::conj(fft_detail::multiply(convolved[k], m_chirpSpectrum[k]));
+        m_radix.transform(convolved.data(), scaled.data()); // Inverse transform as conj(DFT(conj(.)))
+        for (std::size_t k = 0; k < m_n; ++k) output[k] = fft_detail::multiply(std::conj(scaled[k]), m_chirp[k]);
+    }
+
+    // output[j] = (1/n) sum_k input[k] exp(+2 pi i j k / n), undoing forward()
+    void inverse(std::span<const Complex> input, std::span<Complex> output) const {
+        std::vector<Complex> conjugated(m_n);
+        for (std::size_t k = 0; k < m_n; ++k) conjugated[k] = std::conj(input[k]);
+        forward(conjugated, output);
+        const double scale = 1.0 / static_cast<double>(m_n);
+        for (Complex& value : output.first(m_n)) value = std::conj(value) * scale;
+    }
+
+private:
+    static std::size_t paddedSize(std::size_t n) {
+        if (fft_detail::isPowerOfTwo(n)) return n;
+        std::size_t padded = 1;
+        while (padded < 2 * n - 1) padded *= 2;
+        return padded;
+    }
+
+    std::size_t m_n;
+    fft_detail::PowerOfTwoFft m_radix;   // Of n, or of the Bluestein convolution
+    std::vector<Complex> m_chirp;        // exp(-pi i k^2 / n); empty for powers of two
+    std::vector<Complex> m_chirpSpectrum; // DFT of the conjugate chirp, scaled by 1 / m_radix.size()
+};
+
+// A plan for transforms of n >= 1 real values, which have n/2 + 1 independent outputs (the rest are
+// their conjugates). For even n the values are transformed as n/2 complex numbers z[j] = x[2j] +
+// i x[2j + 1], and the transforms of the even and odd values are separated from Z afterwards.
+class RealFft {
+public:
+    explicit RealFft(std::size_t n) : m_n(n), m_complex(n % 2 == 0 ? n / 2 : n) {
+        if (n % 2 != 0) return;
+        m_twiddles.resize(n / 4 + 1);
+        for (std::size_t k = 0; k < m_twiddles.size(); ++k) m_twiddles[k] = fft_detail::rootOfUnity(k, n);
+    }
+
+    std::size_t size() const { return m_n; }
+
+    // output[k] = sum_j input[j] exp(-2 pi i j k / n) for k = 0..n/2: input holds n values, output n/2 + 1
+    void forward(std::span<const double> input, std::span<Complex> output) const {
+        std::vector<Complex> packed(m_complex.size()), transformed(m_complex.size());
+        if (m_n % 2 != 0) {
+            for (std::size_t j = 0; j < m_n; ++j) packed[j] = input[j];
+            m_complex.forward(packed, transformed);
+            std::copy_n(transformed.begin(), m_n / 2 + 1, output.begin());
+            return;
+        }
+        const std::size_t half = m_n / 2;
+        for (std::size_t j = 0; j < half; ++j) packed[j] = Complex(input[2 * j], input[2 * j + 1]);
+        m_complex.forward(packed, transformed);
+        // With E = (Z[k] + conj Z[half - k]) / 2 and O = -i (Z[k] - conj Z[half - k]) / 2, the
+        // transforms of the even and odd values: X[k] = E + w^k O and X[half - k] = conj(E - w^k O)
+        for (std::size_t k = 0; k <= half / 2; ++k) {
+            const Complex z = transformed[k], mirror = std::conj(transformed[k == 0 ? 0 : half - k]);
+            const Complex even = 0.5 * (z + mirror), odd = fft_detail::timesMinusI(0.5 * (z - mirror));
+            const Complex rotated = fft_detail::multiply(m_twiddles[k], odd);
+            output[k] = even + rotated;
+            output[half - k] = std::conj(even - rotated);
+        }
+    }
+
+private:
+    std::size_t m_n;
+    Fft m_complex;                   // Of n / 2 for even n, else of n
+    std::vector<Complex> m_twiddles; // exp(-2 pi i k / n) for k <= n / 4; empty for odd n
+};
+
+// A peak of the spectrum of real samples: where it lies in bins of 1 / (n * spacing), fractional
+// after interpolation, and the amplitude of the sinusoid that would produce it
+struct SpectralPeak {
+    double bin = 0.0;
+    double amplitude = 0.0;
+};
+
+// The strongest local maxima of the spectrum of uniformly spaced real samples, strongest first: at
+// most maxPeaks, each at least minFraction of the strongest. The samples are weighted by a Hann
+// window, whose sidelobes fall off fast enough to keep leakage from hiding weaker peaks; position
+// and amplitude come from a parabola through the log magnitudes of a peak bin and its neighbours,
+// which is exact at bin centres and within 4% between them. The mean is left out, and so are peaks
+// below rounding noise (NOISE_FLOOR of the largest sample).
+inline std::vector<SpectralPeak> spectralPeaks(std::span<const double> samples, std::size_t maxPeaks, double minFraction) {
+    const std::size_t n = samples.size();
+    if (n < 4) return {};
+    std::vector<Complex> spectrum(n / 2 + 1);
+    RealFft(n).forward(samples, spectrum);
+    spectrum[0] = 0.0; // The mean is no peak, and the window would spread it into bin 1
+    // The periodic Hann window 1/2 - cos(2 pi j / n) / 2 multiplies the spectrum by the kernel
+    // (-1/4, 1/2, -1/4): applied here, it costs no pass over the samples. X[n - k] = conj(X[k]).
+    auto bin = [&](std::size_t k) { return k < spectrum.size() ? spectrum[k] : std::conj(spectrum[n - k]); };
+    std::vector<double> magnitude(spectrum.size());
+    for (std::size_t k = 1; k < spectrum.size(); ++k) magnitude[k] = std::sqrt(std::norm(0.5 * bin(k) - 0.25 * (bin(k - 1) + bin(k + 1))));
+    spectrum.clear();
+    spectrum.shrink_to_fit();
+    // Rounding noise makes local maxima of nearly every other bin; the interpolation raises a
+    // Hann peak by at most 1.5 dB, so half the threshold on the raw magnitude loses none that count
+    double largest = 0.0, strongest = 0.0;
+    for (const double y : samples) largest = std::max(largest, std::abs(y));
+    for (const double m : magnitude) strongest = std::max(strongest, m);
+    const double candidate = std::max(0.5 * minFraction * strongest, fft_detail::NOISE_FLOOR * largest * static_cast<double>(n) / 8.0);
+    std::vector<SpectralPeak> peaks;
+    for (std::size_t k = 1; k + 1 < magnitude.size(); ++k) {
+        if (!(magnitude[k] > magnitude[k - 1] && magnitude[k] >= magnitude[k + 1]) || magnitude[k] < candidate) continue;
+        SpectralPeak peak{static_cast<double>(k), magnitude[k]};
+        if (magnitude[k - 1] > 0.0 && magnitude[k + 1] > 0.0) {
+            const double left = std::log(magnitude[k - 1]), centre = std::log(magnitude[k]), right = std::log(magnitude[k + 1]);
+            const double curvature = left - 2.0 * centre + right;
+            const double offset = curvature < 0.0 ? 0.5 * (left - right) / curvature : 0.0;
+            peak.bin += offset;
+            peak.amplitude = std::exp(centre - 0.25 * (left - right) * offset);
+        }
+        peak.amplitude *= 4.0 / static_cast<double>(n); // A sinusoid of amplitude A peaks at A n / 4 under the window
+        peaks.push_back(peak);
+    }
+    std::sort(peaks.begin(), peaks.end(), [](const SpectralPeak& a, const SpectralPeak& b) { return a.amplitude > b.amplitude; });
+    if (!peaks.empty()) {
+        const double threshold = std::max(minFraction * peaks.front().amplitude, fft_detail::NOISE_FLOOR * largest);
+        std::size_t kept = 0;
+        while (kept < std::min(peaks.size(), maxPeaks) && peaks[kept].amplitude >= threshold) ++kept;
+        peaks.resize(kept);
+    }
+    return peaks;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#ifdef MATHD_QUADMATH // Needs GCC's __float128 and libquadmath (link with -lquadmath)
+
+#include <quadmath.h>
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// IEEE binary128 (113-bit significand, ~34 decimal digits) as a class type. Wrapping the compiler's
+// __float128 lets it have a std::numeric_limits specialization and the usual math functions (as hidden
+// friends, found by argument-dependent lookup), so it can stand in for double in templates such as
+// exprtk's. Arithmetic is done in software by libgcc, roughly 10-50x slower than double.
+class Float128 {
+public:
+    __extension__ typedef __float128 Raw;
+
+    Float128() = default; // Zero
+
+    // Implicit from every built-in arithmetic type, like a built-in floating-point type
+    template <typename A> requires std::is_arithmetic_v<A>
+    Float128(A value) : m_value(static_cast<Raw>(value)) {}
+
+    static Float128 fromRaw(Raw value) {
+        Float128 result;
+        result.m_value = value;
+        return result;
+    }
+
+    Raw raw() const { return m_value; }
+
+    template <typename A> requires std::is_arithmetic_v<A>
+    explicit operator A() const { return static_cast<A>(m_value); }
+
+    // The value with the given number of significant digits, as printf's %g would show it
+    std::string toString(int digits = FLT128_DIG) const;
+
+    Float128 operator-() const { return fromRaw(-m_value); }
+    Float128 operator+() const { return *this; }
+    Float128& operator+=(const Float128& other) { m_value += other.m_value; return *this; }
+    Float128& operator-=(const Float128& other) { m_value -= other.m_value; return *this; }
+    Float128& operator*=(const Float128& other) { m_value *= other.m_value; return *this; }
+    Float128& operator/=(const Float128& other) { m_value /= other.m_value; return *this; }
+
+    friend Float128 operator+(Float128 a, const Float128& b) { return a += b; }
+    friend Float128 operator-(Float128 a, const Float128& b) { return a -= b; }
+    friend Float128 operator*(Float128 a, const Float128& b) { return a *= b; }
+    friend Float128 operator/(Float128 a, const Float128& b) { return a /= b; }
+    friend bool operator==(const Float128& a, const Float128& b) { return a.m_value == b.m_value; }
+    friend bool operator!=(const Float128& a, const Float128& b) { return a.m_value != b.m_value; }
+    friend bool operator<(const Float128& a, const Float128& b) { return a.m_value < b.m_value; }
+    friend bool operator<=(const Float128& a, const Float128& b) { return a.m_value <= b.m_value; }
+    friend bool operator>(const Float128& a, const Float128& b) { return a.m_value > b.m_value; }
+    friend bool operator>=(const Float128& a, const Float128& b) { return a.m_value >= b.m_value; }
+
+    friend std::ostream& operator<<(std::ostream& out, const Float128& value) {
+        return out << value.toString(static_cast<int>(out.precision()));
+    }
+
+    // <cmath> counterparts, computed by libquadmath to within an ulp or so
+    friend Float128 abs(const Float128& v) { return fromRaw(fabsq(v.m_value)); }
+    friend Float128 fabs(const Float128& v) { return fromRaw(fabsq(v.m_value)); }
+    friend Float128 sqrt(const Float128& v) { return fromRaw(sqrtq(v.m_value)); }
+    friend Float128 cbrt(const Float128& v) { return fromRaw(cbrtq(v.m_value)); }
+    friend Float128 exp(const Float128& v) { return fromRaw(expq(v.m_value)); }
+    friend Float128 expm1(const Float128& v) { return fromRaw(expm1q(v.m_value)); }
+    friend Float128 log(const Float128& v) { return fromRaw(logq(v.m_value)); }
+    friend Float128 log1p(const Float128& v) { return fromRaw(log1pq(v.m_value)); }
+    friend Float128 log10(const Float128& v) { return fromRaw(log10q(v.m_value)); }
+    friend Float128 log2(const Float128& v) { return fromRaw(log2q(v.m_value)); }
+    friend Float128 pow(const Float128& a, const Float128& b) { return fromRaw(powq(a.m_value, b.m_value)); }
+    friend Float128 fmod(const Float128& a, const Float128& b) { return fromRaw(fmodq(a.m_value, b.m_value)); }
+    friend Float128 hypot(const Float128& a, const Float128& b) { return fromRaw(hypotq(a.m_value, b.m_value)); }
+    friend Float128 floor(const Float128& v) { return fromRaw(floorq(v.m_value)); }
+    friend Float128 ceil(const Float128& v) { return fromRaw(ceilq(v.m_value)); }
+    friend Float128 trunc(const Float128& v) { return fromRaw(truncq(v.m_value)); }
+    friend Float128 round(const Float128& v) { return fromRaw(roundq(v.m_value)); }
+    friend Float128 sin(const Float128& v) { return fromRaw(sinq(v.m_value)); }
+    friend Float128 cos(const Float128& v) { return fromRaw(cosq(v.m_value)); }
+    friend Float128 tan(const Float128& v) { return fromRaw(tanq(v.m_value)); }
+    friend Float128 asin(const Float128& v) { return fromRaw(asinq(v.m_value)); }
+    friend Float128 acos(const Float128& v) { return fromRaw(acosq(v.m_value)); }
+    friend Float128 atan(const Float128& v) { return fromRaw(atanq(v.m_value)); }
+    friend Float128 atan2(const Float128& a, const Float128& b) { return fromRaw(atan2q(a.m_value, b.m_value)); }
+    friend Float128 sinh(const Float128& v) { return fromRaw(sinhq(v.m_value)); }
+    friend Float128 cosh(const Float128& v) { return fromRaw(coshq(v.m_value)); }
+    friend Float128 tanh(const Float128& v) { return fromRaw(tanhq(v.m_value)); }
+    friend Float128 asinh(const Float128& v) { return fromRaw(asinhq(v.m_value)); }
+    friend Float128 acosh(const Float128& v) { return fromRaw(acoshq(v.m_value)); }
+    friend Float128 atanh(const Float128& v) { return fromRaw(atanhq(v.m_value)); }
+    friend Float128 erf(const Float128& v) { return fromRaw(erfq(v.m_value)); }
+    friend Float128 erfc(const Float128& v) { return fromRaw(erfcq(v.m_value)); }
+    friend bool isnan(const Float128& v) { return isnanq(v.m_value); }
+    friend bool isinf(const Float128& v) { return isinfq(v.m_value); }
+    friend bool isfinite(const Float128& v) { return finiteq(v.m_value); }
+
+private:
+    Raw m_value = 0;
+};
+
+inline std::string Float128::toString(int digits) const {
+    char buffer[64];
+    const int length = quadmath_snprintf(buffer, sizeof(buffer), "%.*Qg", digits > 0 ? digits : 1, m_value);
+    return std::string(buffer, static_cast<std::size_t>(length > 0 ? std::min<int>(length, sizeof(buffer) - 1) : 0));
+}
+
+namespace std {
+template <>
+class numeric_limits<Float128> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = true;
+    static constexpr bool is_iec559 = true;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int radix = 2;
+    static constexpr int digits = FLT128_MANT_DIG;
+    static constexpr int digits10 = FLT128_DIG;
+    static constexpr int max_digits10 = 36;
+    static constexpr int min_exponent = FLT128_MIN_EXP;
+    static constexpr int min_exponent10 = FLT128_MIN_10_EXP;
+    static constexpr int max_exponent = FLT128_MAX_EXP;
+    static constexpr int max_exponent10 = FLT128_MAX_10_EXP;
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+
+    // From ldexpq() rather than quadmath.h's macros, whose Q-suffixed literals need -std=gnu++
+    static Float128 min() { return Float128::fromRaw(ldexpq(1, FLT128_MIN_EXP - 1)); }
+    static Float128 max() { return Float128::fromRaw(ldexpq(2 - ldexpq(1, 1 - FLT128_MANT_DIG), FLT128_MAX_EXP - 1)); }
+    static Float128 lowest() { return -max(); }
+    static Float128 epsilon() { return Float128::fromRaw(ldexpq(1, 1 - FLT128_MANT_DIG)); }
+    static Float128 round_error() { return 0.5; }
+    static Float128 infinity() { return Float128::fromRaw(__builtin_huge_valq()); }
+    static Float128 quiet_NaN() { return Float128::fromRaw(nanq("")); }
+    static Float128 signaling_NaN() { return quiet_NaN(); }
+    static Float128 denorm_min() { return Float128::fromRaw(ldexpq(1, FLT128_MIN_EXP - FLT128_MANT_DIG)); }
+};
+}
+
+#endif // MATHD_QUADMATH
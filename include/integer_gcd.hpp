@@ -0,0 +1,492 @@
+#pragma once
+
+#include "parallel_for.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Exact GCD and LCM of integers of any size. Stein's binary GCD needs no division: the common
+// factors of two are counted with __builtin_ctzll and shifted out, and the difference of two odd
+// numbers is even, so every subtraction removes at least one bit. Values that fit 64 or 128 bits stay
+// in machine integers; longer ones are BigNatural limb vectors, and a GCD with a one-limb operand
+// first reduces the long one modulo it. Batches are cut into shards that are folded on separate
+// threads, and the shard results are merged as a balanced tree whose levels also run in parallel.
+
+__extension__ typedef unsigned __int128 UInt128;
+
+// Trailing zero bits of a nonzero value
+inline int countTrailingZeros(UInt128 value) {
+    const auto low = static_cast<std::uint64_t>(value);
+    return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll(static_cast<std::uint64_t>(value >> 64));
+}
+
+inline std::uint64_t binaryGcd(std::uint64_t a, std::uint64_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    const int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        if (a > b) std::swap(a, b);
+        b -= a;
+    } while (b != 0);
+    return a << shift;
+}
+
+// 128-bit steps until both operands fit 64 bits, which then finish on the cheaper 64-bit loop
+inline UInt128 binaryGcd(UInt128 a, UInt128 b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    const int shift = countTrailingZeros(a | b);
+    a >>= countTrailingZeros(a);
+    b >>= countTrailingZeros(b);
+    while ((a >> 64) != 0 || (b >> 64) != 0) { // Both odd here
+        if (a > b) std::swap(a, b);
+        b -= a;
+        if (b == 0) return a << shift;
+        b >>= countTrailingZeros(b);
+    }
+    return static_cast<UInt128>(binaryGcd(static_cast<std::uint64_t>(a), static_cast<std::uint64_t>(b))) << shift;
+}
+
+// Arbitrary-size unsigned integers in binary, for GCDs and LCMs beyond 128 bits. Limbs are 64-bit,
+// least significant first, with no leading zero limbs (zero has none). Only what binary GCD and
+// exact LCM need: shifts, subtraction, remainder by a limb, schoolbook multiplication and exact
+// (Hensel) division.
+class BigNatural {
+public:
+    using Limb = std::uint64_t;
+
+    BigNatural() = default; // Zero
+
+    explicit BigNatural(UInt128 value) {
+        if (value == 0) return;
+        m_limbs.push_back(static_cast<Limb>(value));
+        if ((value >> 64) != 0) m_limbs.push_back(static_cast<Limb>(value >> 64));
+    }
+
+    // From a string of decimal digits (no sign); 19 digits at a time
+    static BigNatural fromDecimal(std::string_view digits) {
+        BigNatural result;
+        std::size_t position = 0;
+        while (position < digits.size()) {
+            const std::size_t length = std::min<std::size_t>(CHUNK_DIGITS, digits.size() - position);
+            Limb chunk = 0, scale = 1;
+            for (std::size_t i = 0; i < length; ++i, ++position) {
+                chunk = chunk * 10 + static_cast<Limb>(digits[position] - '0');
+                scale *= 10;
+            }
+            result.multiplyAdd(scale, chunk);
+        }
+        return result;
+    }
+
+    bool isZero() const { return m_limbs.empty(); }
+    bool fitsUInt128() const { return m_limbs.size() <= 2; }
+
+    UInt128 toUInt128() const {
+        UInt128 value = 0;
+        for (std::size_t i = std::min<std::size_t>(m_limbs.size(), 2); i-- > 0;) value = (value << 64) | m_limbs[i];
+        return value;
+    }
+
+    // Decimal digits by repeated division by 10^19: quadratic, fine for results of many thousand digits
+    std::string toDecimal() const {
+        if (m_limbs.empty()) return "0";
+        std::vector<Limb> rest = m_limbs;
+        std::string reversed;
+        while (!rest.empty()) {
+            Limb chunk = divideInPlace(rest, CHUNK_SCALE);
+            for (int i = 0; i < CHUNK_DIGITS && (chunk > 0 || !rest.empty()); ++i, chunk /= 10) {
+                reversed.push_back(static_cast<char>('0' + chunk % 10));
+            }
+        }
+        return std::string(reversed.rbegin(), reversed.rend());
+    }
+
+    friend bool operator==(const BigNatural& a, const BigNatural& b) = default;
+
+    // this mod divisor, for a nonzero divisor
+    Limb remainder(Limb divisor) const {
+        UInt128 rest = 0;
+        for (std::size_t i = m_limbs.size(); i-- > 0;) rest = ((rest << 64) | m_limbs[i]) % divisor;
+        return static_cast<Limb>(rest);
+    }
+
+    friend BigNatural operator*(const BigNatural& a, const BigNatural& b) {
+        BigNatural product;
+        if (a.isZero() || b.isZero()) return product;
+        product.m_limbs.assign(a.m_limbs.size() + b.m_limbs.size(), 0);
+        for (std::size_t i = 0; i < a.m_limbs.size(); ++i) {
+            Limb carry = 0;
+            for (std::size_t j = 0; j < b.m_limbs.size(); ++j) {
+                const UInt128 current = static_cast<UInt128>(a.m_limbs[i]) * b.m_limbs[j] + product.m_limbs[i + j] + carry;
+                product.m_limbs[i + j] = static_cast<Limb>(current);
+                carry = static_cast<Limb>(current >> 64);
+            }
+            product.m_limbs[i + b.m_limbs.size()] = carry;
+        }
+        trim(product.m_limbs);
+        return product;
+    }
+
+    BigNatural& operator*=(UInt128 factor) {
+        if ((factor >> 64) != 0) return *this = *this * BigNatural(factor);
+        multiplyAdd(static_cast<Limb>(factor), 0);
+        return *this;
+    }
+
+    friend BigNatural gcd(BigNatural a, BigNatural b) {
+        if (a.isZero()) return b;
+        if (b.isZero()) return a;
+        if (a.m_limbs.size() < b.m_limbs.size()) std::swap(a, b);
+        if (a.fitsUInt128()) return BigNatural(binaryGcd(a.toUInt128(), b.toUInt128()));
+        if (b.m_limbs.size() == 1) return BigNatural(binaryGcd(a.remainder(b.m_limbs[0]), b.m_limbs[0]));
+
+        const std::size_t shift = std::min(a.trailingZeros(), b.trailingZeros());
+        a.shiftRight(a.trailingZeros());
+        b.shiftRight(b.trailingZeros());
+        while (!a.isZero() && (!a.fitsUInt128() || !b.fitsUInt128())) { // b stays odd
+            const std::size_t bitsBefore = a.bitCount() + b.bitCount();
+            approximateSteps(a, b);
+            if (a.bitCount() + b.bitCount() >= bitsBefore) exactStep(a, b);
+        }
+        BigNatural result = a.isZero() ? std::move(b) : BigNatural(binaryGcd(a.toUInt128(), b.toUInt128()));
+        result.shiftLeft(shift);
+        return result;
+    }
+
+    // a / gcd(a, b) * b, dividing the smaller operand; zero if either is zero
+    friend BigNatural lcm(const BigNatural& a, const BigNatural& b) {
+        if (a.isZero() || b.isZero()) return BigNatural();
+        const bool aSmaller = compare(a, b) < 0;
+        const BigNatural& small = aSmaller ? a : b;
+        const BigNatural& large = aSmaller ? b : a;
+        return divideExactly(small, gcd(a, b)) * large;
+    }
+
+    // a / divisor for a divisor of a, by Hensel division from the low limbs: with the factors of two
+    // shifted out the divisor is odd, so each quotient limb is the low limb of the rest times the
+    // divisor's inverse modulo 2^64
+    friend BigNatural divideExactly(BigNatural a, BigNatural divisor) {
+        const std::size_t twos = divisor.trailingZeros();
+        a.shiftRight(twos);
+        divisor.shiftRight(twos);
+        const std::vector<Limb>& d = divisor.m_limbs;
+        if (a.m_limbs.size() < d.size()) return BigNatural();
+        Limb inverse = d[0]; // Right to 3 bits; each Newton step doubles that
+        for (int step = 0; step < 5; ++step) inverse *= 2 - d[0] * inverse;
+
+        BigNatural quotient;
+        quotient.m_limbs.assign(a.m_limbs.size() - d.size() + 1, 0);
+        std::vector<Limb>& rest = a.m_limbs;
+        for (std::size_t i = 0; i < quotient.m_limbs.size(); ++i) {
+            const Limb q = rest[i] * inverse;
+            quotient.m_limbs[i] = q;
+            Limb carry = 0;
+            for (std::size_t j = 0; j < d.size(); ++j) {
+                const UInt128 product = static_cast<UInt128>(q) * d[j] + carry;
+                const Limb low = static_cast<Limb>(product);
+                carry = static_cast<Limb>(product >> 64) + (rest[i + j] < low);
+                rest[i + j] -= low;
+            }
+            for (std::size_t k = i + d.size(); carry != 0 && k < rest.size(); ++k) {
+                const Limb before = rest[k];
+                rest[k] -= carry;
+                carry = before < carry;
+            }
+        }
+        trim(quotient.m_limbs);
+        return quotient;
+    }
+
+private:
+    static constexpr int CHUNK_DIGITS = 19;
+    static constexpr Limb CHUNK_SCALE = 10000000000000000000ull; // 10^19, the largest power of ten in a limb
+    static constexpr int APPROXIMATE_STEPS = 31; // Per approximateSteps(); keeps the cofactors within 32 bits
+
+    __extension__ typedef __int128 Int128;
+
+    static void trim(std::vector<Limb>& limbs) {
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    }
+
+    static int compare(const BigNatural& a, const BigNatural& b) {
+        if (a.m_limbs.size() != b.m_limbs.size()) return a.m_limbs.size() < b.m_limbs.size() ? -1 : 1;
+        for (std::size_t i = a.m_limbs.size(); i-- > 0;) {
+            if (a.m_limbs[i] != b.m_limbs[i]) return a.m_limbs[i] < b.m_limbs[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // Divides limbs by divisor in place (trimmed) and returns the remainder
+    static Limb divideInPlace(std::vector<Limb>& limbs, Limb divisor) {
+        UInt128 rest = 0;
+        for (std::size_t i = limbs.size(); i-- > 0;) {
+            rest = (rest << 64) | limbs[i];
+            limbs[i] = static_cast<Limb>(rest / divisor);
+            rest %= divisor;
+        }
+        trim(limbs);
+        return static_cast<Limb>(rest);
+    }
+
+    // this = this * factor + addend
+    void multiplyAdd(Limb factor, Limb addend) {
+        Limb carry = addend;
+        for (Limb& limb : m_limbs) {
+            const UInt128 current = static_cast<UInt128>(limb) * factor + carry;
+            limb = static_cast<Limb>(current);
+            carry = static_cast<Limb>(current >> 64);
+        }
+        if (carry != 0) m_limbs.push_back(carry);
+        trim(m_limbs);
+    }
+
+    // this -= other, for other <= this
+    void subtract(const BigNatural& other) {
+        Limb borrow = 0;
+        for (std::size_t i = 0; i < m_limbs.size(); ++i) {
+            const Limb subtrahend = i < other.m_limbs.size() ? other.m_limbs[i] : 0;
+            if (subtrahend == 0 && borrow == 0 && i >= other.m_limbs.size()) break;
+            const Limb before = m_limbs[i];
+            m_limbs[i] = before - subtrahend - borrow;
+            borrow = (before < subtrahend) || (before - subtrahend < borrow);
+        }
+        trim(m_limbs);
+    }
+
+    std::size_t bitCount() const {
+        return m_limbs.empty() ? 0 : 64 * m_limbs.size() - static_cast<std::size_t>(__builtin_clzll(m_limbs.back()));
+    }
+
+    // count <= 64 bits from bit position on
+    Limb bitsAt(std::size_t position, int count) const {
+        const std::size_t limb = position / 64;
+        const unsigned offset = static_cast<unsigned>(position % 64);
+        Limb bits = limb < m_limbs.size() ? m_limbs[limb] >> offset : 0;
+        if (offset != 0 && limb + 1 < m_limbs.size()) bits |= m_limbs[limb + 1] << (64 - offset);
+        return count == 64 ? bits : bits & ((Limb(1) << count) - 1);
+    }
+
+    // One step of binary GCD on exact values: a is halved while even, else the smaller of the two
+    // odd values is subtracted from the larger, which takes a's place
+    static void exactStep(BigNatural& a, BigNatural& b) {
+        if (a.m_limbs[0] & 1) {
+            if (compare(a, b) < 0) std::swap(a, b);
+            a.subtract(b);
+        }
+        a.shiftRight(a.trailingZeros());
+    }
+
+    // APPROXIMATE_STEPS steps of binary GCD at once (Pornin, "Optimized Binary GCD for Modular
+    // Inversion"): they run on 64-bit stand-ins made of the low bits, which are exact, and the top
+    // bits of both values at the same position, which only decide the comparisons. The steps are
+    // collected in a matrix of small cofactors and applied to the full values in two linear passes;
+    // the low bits guarantee the exact division by 2^APPROXIMATE_STEPS. A wrong comparison can make a
+    // result negative (its magnitude is kept) or leave the values longer, which gcd() then repairs
+    // with an exactStep(). Needs b odd, and keeps it odd.
+    static void approximateSteps(BigNatural& a, BigNatural& b) {
+        const std::size_t bits = std::max(a.bitCount(), b.bitCount());
+        const int topBits = 64 - APPROXIMATE_STEPS;
+        const Limb lowMask = (Limb(1) << APPROXIMATE_STEPS) - 1;
+        Limb x = (a.bitsAt(0, 64) & lowMask) | (a.bitsAt(bits - topBits, topBits) << APPROXIMATE_STEPS);
+        Limb y = (b.bitsAt(0, 64) & lowMask) | (b.bitsAt(bits - topBits, topBits) << APPROXIMATE_STEPS);
+        std::int64_t f0 = 1, g0 = 0, f1 = 0, g1 = 1; // 2^i x = f0 a + g0 b, 2^i y = f1 a + g1 b
+        for (int i = 0; i < APPROXIMATE_STEPS; ++i) {
+            if (x & 1) {
+                if (x < y) {
+                    std::swap(x, y);
+                    std::swap(f0, f1);
+                    std::swap(g0, g1);
+                }
+                x -= y;
+                f0 -= f1;
+                g0 -= g1;
+            }
+            x >>= 1;
+            f1 *= 2;
+            g1 *= 2;
+        }
+        BigNatural nextA = combine(a, b, f0, g0);
+        b = combine(a, b, f1, g1);
+        a = std::move(nextA);
+    }
+
+    // |a f + b g| / 2^APPROXIMATE_STEPS, for cofactors of at most 2^APPROXIMATE_STEPS in magnitude
+    static BigNatural combine(const BigNatural& a, const BigNatural& b, std::int64_t f, std::int64_t g) {
+        const std::size_t length = std::max(a.m_limbs.size(), b.m_limbs.size());
+        BigNatural result;
+        result.m_limbs.resize(length + 1);
+        Int128 carry = 0;
+        for (std::size_t i = 0; i < length; ++i) {
+            const Int128 term = static_cast<Int128>(i < a.m_limbs.size() ? a.m_limbs[i] : 0) * f
+                              + static_cast<Int128>(i < b.m_limbs.size() ? b.m_limbs[i] : 0) * g + carry;
+            result.m_limbs[i] = static_cast<Limb>(term);
+            carry = term >> 64;
+        }
+        result.m_limbs[length] = static_cast<Limb>(carry);
+        if (carry < 0) { // Two's complement negation
+            Limb borrow = 1;
+            for (Limb& limb : result.m_limbs) {
+                limb = ~limb + borrow;
+                borrow = borrow && limb == 0;
+            }
+        }
+        result.shiftRight(APPROXIMATE_STEPS);
+        return result;
+    }
+
+    std::size_t trailingZeros() const {
+        std::size_t limb = 0;
+        while (limb < m_limbs.size() && m_limbs[limb] == 0) ++limb;
+        return limb == m_limbs.size() ? 0 : 64 * limb + static_cast<std::size_t>(__builtin_ctzll(m_limbs[limb]));
+    }
+
+    void shiftRight(std::size_t bits) {
+        const std::size_t limbs = std::min(bits / 64, m_limbs.size());
+        const unsigned rest = static_cast<unsigned>(bits % 64);
+        m_limbs.erase(m_limbs.begin(), m_limbs.begin() + static_cast<std::ptrdiff_t>(limbs));
+        if (rest != 0) {
+            for (std::size_t i = 0; i < m_limbs.size(); ++i) {
+                m_limbs[i] = (m_limbs[i] >> rest) | (i + 1 < m_limbs.size() ? m_limbs[i + 1] << (64 - rest) : 0);
+            }
+        }
+        trim(m_limbs);
+    }
+
+    void shiftLeft(std::size_t bits) {
+        if (m_limbs.empty() || bits == 0) return;
+        const unsigned rest = static_cast<unsigned>(bits % 64);
+        if (rest != 0) {
+            Limb carry = 0;
+            for (Limb& limb : m_limbs) {
+                const Limb next = limb >> (64 - rest);
+                limb = (limb << rest) | carry;
+                carry = next;
+            }
+            if (carry != 0) m_limbs.push_back(carry);
+        }
+        m_limbs.insert(m_limbs.begin(), bits / 64, 0);
+    }
+
+    std::vector<Limb> m_limbs;
+};
+
+// Integers for a batch GCD or LCM, by magnitude (the sign changes neither). Magnitudes of up to 38
+// digits, which always fit 128 bits, are kept apart from longer ones so the bulk of a batch needs no
+// allocation.
+struct IntegerBatch {
+    std::vector<UInt128> small;
+    std::vector<BigNatural> large;
+
+    std::size_t size() const { return small.size() + large.size(); }
+
+    // Appends the integers in text, separated by whitespace, commas or semicolons, each with an
+    // optional sign. Returns false at the first token that is not an integer, which is stored in badToken.
+    bool parse(std::string_view text, std::string& badToken) {
+        static constexpr std::size_t SMALL_DIGITS = 38;
+        const auto isSeparator = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ';'; };
+        std::size_t position = 0;
+        while (position < text.size()) {
+            if (isSeparator(text[position])) {
+                ++position;
+                continue;
+            }
+            const std::size_t start = position;
+            while (position < text.size() && !isSeparator(text[position])) ++position;
+            std::string_view digits = text.substr(start, position - start);
+            if (digits.front() == '+' || digits.front() == '-') digits.remove_prefix(1);
+            if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                badToken = std::string(text.substr(start, position - start));
+                return false;
+            }
+            while (digits.size() > 1 && digits.front() == '0') digits.remove_prefix(1);
+            if (digits.size() <= SMALL_DIGITS) {
+                UInt128 value = 0;
+                for (const char c : digits) value = value * 10 + static_cast<unsigned>(c - '0');
+                small.push_back(value);
+            } else {
+                large.push_back(BigNatural::fromDecimal(digits));
+            }
+        }
+        return true;
+    }
+};
+
+namespace integer_gcd_detail {
+    constexpr std::size_t SHARD_VALUES = 1 << 14; // Values folded by one task
+
+    // Folds every shard of small values with leaf(shard) and appends each large value as it is, then
+    // merges everything as a balanced tree; each level's merges run concurrently
+    template <typename LeafFn, typename MergeFn>
+    BigNatural reduce(const IntegerBatch& batch, unsigned threadCount, LeafFn&& leaf, MergeFn&& merge) {
+        const std::size_t shards = (batch.small.size() + SHARD_VALUES - 1) / SHARD_VALUES;
+        std::vector<BigNatural> values(shards);
+        parallelFor(shards, threadCount, [&](std::size_t shard) {
+            const std::size_t begin = shard * SHARD_VALUES;
+            values[shard] = leaf(std::span<const UInt128>(batch.small).subspan(begin, std::min(SHARD_VALUES, batch.small.size() - begin)));
+        });
+        values.insert(values.end(), batch.large.begin(), batch.large.end());
+        if (values.empty()) return BigNatural();
+        for (std::size_t stride = 1; stride < values.size(); stride *= 2) {
+            const std::size_t pairs = (values.size() - stride + 2 * stride - 1) / (2 * stride);
+            parallelFor(pairs, threadCount, [&](std::size_t pair) {
+                const std::size_t i = pair * 2 * stride;
+                values[i] = merge(values[i], values[i + stride]);
+            });
+        }
+        return std::move(values[0]);
+    }
+}
+
+// GCD of every integer in the batch; zero if there are none (or all are zero). Shards stop early
+// once any of them reaches 1.
+inline BigNatural batchGcd(const IntegerBatch& batch, unsigned threadCount) {
+    std::atomic<bool> coprime{false};
+    return integer_gcd_detail::reduce(batch, threadCount,
+        [&](std::span<const UInt128> values) {
+            UInt128 result = 0;
+            for (std::size_t i = 0; i < values.size() && !coprime.load(std::memory_order_relaxed); ++i) {
+                result = binaryGcd(result, values[i]);
+                if (result == 1) coprime = true;
+            }
+            return coprime ? BigNatural(1) : BigNatural(result);
+        },
+        [](const BigNatural& a, const BigNatural& b) { return gcd(a, b); });
+}
+
+// LCM of every integer in the batch; zero if any is zero, 1 if there are none. A shard multiplies
+// in 128 bits until the LCM outgrows them, then reduces the BigNatural modulo each 64-bit value.
+inline BigNatural batchLcm(const IntegerBatch& batch, unsigned threadCount) {
+    if (batch.size() == 0) return BigNatural(1);
+    return integer_gcd_detail::reduce(batch, threadCount,
+        [](std::span<const UInt128> values) {
+            UInt128 small = 1;
+            std::size_t i = 0;
+            for (; i < values.size(); ++i) {
+                if (values[i] == 0) return BigNatural();
+                const UInt128 factor = values[i] / binaryGcd(small, values[i]);
+                if (small > std::numeric_limits<UInt128>::max() / factor) break;
+                small *= factor;
+            }
+            BigNatural result(small);
+            for (; i < values.size(); ++i) {
+                const UInt128 value = values[i];
+                if (value == 0) return BigNatural();
+                const UInt128 common = (value >> 64) == 0
+                    ? binaryGcd(result.remainder(static_cast<std::uint64_t>(value)), static_cast<std::uint64_t>(value))
+                    : gcd(result, BigNatural(value)).toUInt128();
+                result *= value / common;
+            }
+            return result;
+        },
+        [](const BigNatural& a, const BigNatural& b) { return lcm(a, b); });
+}
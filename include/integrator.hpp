@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Adaptive Gauss-Kronrod quadrature. Each subinterval is integrated by the 21-point Kronrod rule,
+// whose embedded 10-point Gauss rule gives the error estimate (with QUADPACK's scaling). Subintervals
+// sit in a max-heap keyed by their error; each round bisects the worst of them, just enough that the
+// errors left behind fit the tolerance, and evaluates all of their nodes in one batch call.
+// Results do not depend on how the batch evaluator splits its work.
+
+struct IntegrationOptions {
+    double absoluteTolerance = 1e-10;
+    double relativeTolerance = 1e-10;
+    std::size_t maxEvaluations = 1000000;
+    std::size_t initialIntervals = 8;    // Equal pieces of [a, b] to start from
+    std::size_t intervalsPerRound = 128; // Bisected per batch at most
+};
+
+struct IntegrationResult {
+    double value = 0.0;
+    double errorEstimate = 0.0;
+    std::size_t evaluations = 0;
+    std::size_t intervals = 0; // Subintervals in the final partition
+    bool converged = false;    // The error estimate met the tolerance
+    bool roundoffLimited = false; // Not converged because rounding error dominates somewhere
+};
+
+namespace gauss_kronrod {
+    static constexpr std::size_t NODES = 21;
+
+    // Kronrod abscissae on [-1, 1] (the odd-indexed ones are the Gauss nodes) and weights
+    static constexpr std::array<double, 11> XGK = {
+        0.995657163025808080735527280689003, 0.973906528517171720077964012084452,
+        0.930157491355708226001207180059508, 0.865063366688984510732096688423493,
+        0.780817726586416897063717578345042, 0.679409568299024406234327365114874,
+        0.562757134668604683339000099272694, 0.433395394129247190799265943165784,
+        0.294392862701460198131126603103866, 0.148874338981631210884826001129720,
+        0.000000000000000000000000000000000};
+    static constexpr std::array<double, 11> WGK = {
+        0.011694638867371874278064396062192, 0.032558162307964727478818972459390,
+        0.054755896574351996031381300244580, 0.075039674810919952767043140916190,
+        0.093125454583697605535065465083366, 0.109387158802297641899210590325805,
+        0.123491976262065851077208245851770, 0.134709217311473325928054001771707,
+        0.142775938577060080797094273138717, 0.147739104901338491374841515972068,
+        0.149445554002916905664936468389821};
+    static constexpr std::array<double, 5> WG = { // 10-point Gauss weights for XGK[1], XGK[3], ...
+        0.066671344308688137593568809893332, 0.149451349150580593145776339657697,
+        0.219086362515982043995534934228163, 0.269266719309996355091226921569469,
+        0.295524224714752870173892994651338};
+
+    struct Segment {
+        double a, b;
+        double value;
+        double error;
+        bool roundoffLimited; // The error is the rounding floor 50*eps*integral(|f|): bisecting cannot lower it
+        bool operator<(const Segment& other) const { return error < other.error; } // Max-heap on error
+    };
+
+    // Writes the 21 nodes of [a, b] to xs: the centre, then each abscissa left and right of it
+    inline void nodes(double a, double b, double* xs) {
+        const double centre = 0.5 * (a + b), half = 0.5 * (b - a);
+        xs[0] = centre;
+        for (std::size_t j = 0; j < 10; ++j) {
+            xs[1 + 2 * j] = centre - half * XGK[j];
+            xs[2 + 2 * j] = centre + half * XGK[j];
+        }
+    }
+
+    // The Kronrod estimate and its error from f at nodes(a, b)
+    inline Segment integrate(double a, double b, const double* ys) {
+        static constexpr double EPS = std::numeric_limits<double>::epsilon();
+        static constexpr double UNDERFLOW = std::numeric_limits<double>::min();
+        const double half = 0.5 * (b - a);
+        const double fc = ys[0];
+        double kronrod = WGK[10] * fc, gauss = 0.0, absolute = WGK[10] * std::abs(fc);
+        for (std::size_t j = 0; j < 10; ++j) {
+            const double f1 = ys[1 + 2 * j], f2 = ys[2 + 2 * j];
+            kronrod += WGK[j] * (f1 + f2);
+            absolute += WGK[j] * (std::abs(f1) + std::abs(f2));
+            if (j % 2 == 1) gauss += WG[j / 2] * (f1 + f2);
+        }
+        const double mean = 0.5 * kronrod;
+        double deviation = WGK[10] * std::abs(fc - mean);
+        for (std::size_t j = 0; j < 10; ++j) deviation += WGK[j] * (std::abs(ys[1 + 2 * j] - mean) + std::abs(ys[2 + 2 * j] - mean));
+
+        const double scale = std::abs(half);
+        absolute *= scale;
+        deviation *= scale;
+        double error = std::abs((kronrod - gauss) * half);
+        if (deviation != 0.0 && error != 0.0) error = deviation * std::min(1.0, std::pow(200.0 * error / deviation, 1.5));
+        const bool roundoffLimited = absolute > UNDERFLOW / (50.0 * EPS) && error <= 50.0 * EPS * absolute;
+        if (roundoffLimited) error = 50.0 * EPS * absolute;
+        if (!std::isfinite(kronrod)) error = std::numeric_limits<double>::infinity();
+        return {a, b, kronrod * half, error, roundoffLimited};
+    }
+}
+
+// Integral of f over [a, b]. evaluate(xs, ys) writes f(x) for every x in xs to ys; it is called once
+// per round with the nodes of every subinterval being refined.
+template <typename BatchFn>
+IntegrationResult integrateAdaptively(double a, double b, const IntegrationOptions& options, BatchFn&& evaluate) {
+    using gauss_kronrod::NODES;
+    using gauss_kronrod::Segment;
+    IntegrationResult result;
+    std::vector<Segment> heap;     // Still refinable
+    std::vector<Segment> settled;  // Too narrow to bisect any further, or limited by rounding
+    std::vector<double> xs, ys;
+    std::vector<std::pair<double, double>> pending;
+
+    auto evaluateSegments = [&]() {
+        xs.resize(pending.size() * NODES);
+        ys.resize(xs.size());
+        for (std::size_t i = 0; i < pending.size(); ++i) gauss_kronrod::nodes(pending[i].first, pending[i].second, xs.data() + i * NODES);
+        evaluate(std::span<const double>(xs), std::span<double>(ys));
+        result.evaluations += xs.size();
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            heap.push_back(gauss_kronrod::integrate(pending[i].first, pending[i].second, ys.data() + i * NODES));
+            std::push_heap(heap.begin(), heap.end());
+        }
+        pending.clear();
+    };
+    auto totals = [&]() {
+        result.value = 0.0;
+        result.errorEstimate = 0.0;
+        for (const auto* segments : {&heap, &settled}) {
+            for (const Segment& segment : *segments) {
+                result.value += segment.value;
+                result.errorEstimate += segment.error;
+            }
+        }
+    };
+
+    const std::size_t initial = std::max<std::size_t>(1, options.initialIntervals);
+    for (std::size_t i = 0; i < initial; ++i) {
+        const double lo = a + (b - a) * static_cast<double>(i) / static_cast<double>(initial);
+        const double hi = (i + 1 == initial) ? b : a + (b - a) * static_cast<double>(i + 1) / static_cast<double>(initial);
+        pending.emplace_back(lo, hi);
+    }
+    evaluateSegments();
+    totals();
+
+    while (true) {
+        const double tolerance = std::max(options.absoluteTolerance, options.relativeTolerance * std::abs(result.value));
+        if (result.errorEstimate <= tolerance) {
+            result.converged = true;
+            break;
+        }
+        if (!std::isfinite(result.value) || heap.empty()) break; // A non-finite integrand value ends the search
+
+        // Bisect the worst subintervals until the error of the ones left alone fits the tolerance
+        double remainingError = result.errorEstimate;
+        while (!heap.empty() && remainingError > tolerance && pending.size() < 2 * options.intervalsPerRound &&
+               result.evaluations + (pending.size() + 2) * NODES <= options.maxEvaluations) {
+            std::pop_heap(heap.begin(), heap.end());
+            const Segment worst = heap.back();
+            heap.pop_back();
+            remainingError -= worst.error;
+            const double middle = 0.5 * (worst.a + worst.b);
+            if (worst.roundoffLimited || middle <= worst.a || middle >= worst.b) {
+                settled.push_back(worst);
+                continue;
+            }
+            pending.emplace_back(worst.a, middle);
+            pending.emplace_back(middle, worst.b);
+        }
+        if (pending.empty()) break; // Out of evaluations, or nothing left that bisection would improve
+        evaluateSegments();
+        totals();
+    }
+    result.intervals = heap.size() + settled.size();
+    result.roundoffLimited = !result.converged && std::any_of(settled.begin(), settled.end(), [](const Segment& segment) {
+        return segment.roundoffLimited;
+    });
+    return result;
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include "expression_tree.hpp"
+#include "bytecode.hpp" // bytecode_ops: exprtk's rounding and equality semantics
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Closed interval [lo, hi] of doubles. lo > hi encodes the empty set: the function is undefined
+// (NaN) everywhere on the input. Infinite endpoints mean the enclosure is unbounded.
+struct Interval {
+    double lo;
+    double hi;
+
+    static Interval point(double v) { return {v, v}; }
+    static Interval entire() { return {-INFINITY, INFINITY}; }
+    static Interval emptySet() { return {INFINITY, -INFINITY}; }
+
+    bool isEmpty() const { return lo > hi; }
+    bool isPoint() const { return lo == hi; }
+    bool isBounded() const { return std::isfinite(lo) && std::isfinite(hi); }
+    bool contains(double v) const { return lo <= v && v <= hi; }
+};
+
+// Interval extension of every ExprKind, following the scalar semantics of exprtk and the bytecode VM.
+// Results are widened outward by one ulp after each inexact operation, so for arithmetic and the
+// (<= 1 ulp) libm functions the true range of f over the input is always enclosed.
+namespace interval_ops {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double TWO_PI = 2.0 * PI;
+    constexpr double HALF_PI = 0.5 * PI;
+
+    inline Interval outward(Interval v) {
+        if (v.isEmpty()) return v;
+        if (std::isnan(v.lo)) v.lo = -INFINITY;
+        if (std::isnan(v.hi)) v.hi = INFINITY;
+        return {std::nextafter(v.lo, -INFINITY), std::nextafter(v.hi, INFINITY)};
+    }
+
+    inline Interval clamp(Interval v, double lo, double hi) {
+        return {std::max(v.lo, lo), std::min(v.hi, hi)};
+    }
+
+    // Image of a non-decreasing function: no widening for functions that are exact (floor, ...)
+    template <typename F>
+    Interval increasing(Interval a, F f, bool exact = false) {
+        const Interval r{f(a.lo), f(a.hi)};
+        return exact ? r : outward(r);
+    }
+
+    // True if some p + k * period (k integer) lies in [a.lo, a.hi], allowing for rounding in a
+    inline bool containsPhase(Interval a, double p, double period) {
+        const double slack = 4.0 * std::numeric_limits<double>::epsilon() * std::max({1.0, std::abs(a.lo), std::abs(a.hi)});
+        const double k = std::ceil((a.lo - slack - p) / period);
+        return p + k * period <= a.hi + slack;
+    }
+
+    inline double productOf(double x, double y) { return (x == 0.0 || y == 0.0) ? 0.0 : x * y; } // 0 * inf counts as 0
+
+    inline Interval add(Interval a, Interval b) { return outward({a.lo + b.lo, a.hi + b.hi}); }
+    inline Interval sub(Interval a, Interval b) { return outward({a.lo - b.hi, a.hi - b.lo}); }
+
+    inline Interval mul(Interval a, Interval b) {
+        const double p[4] = {productOf(a.lo, b.lo), productOf(a.lo, b.hi), productOf(a.hi, b.lo), productOf(a.hi, b.hi)};
+        return outward({*std::min_element(p, p + 4), *std::max_element(p, p + 4)});
+    }
+
+    inline Interval div(Interval a, Interval b) {
+        if (b.contains(0.0)) return Interval::entire(); // Pole (or 0/0) somewhere in the input
+        return mul(a, outward({1.0 / b.hi, 1.0 / b.lo}));
+    }
+
+    inline Interval square(Interval a) {
+        if (a.contains(0.0)) return outward({0.0, std::max(a.lo * a.lo, a.hi * a.hi)});
+        const double l = std::min(std::abs(a.lo), std::abs(a.hi)), h = std::max(std::abs(a.lo), std::abs(a.hi));
+        return outward({l * l, h * h});
+    }
+
+    inline Interval integerPower(Interval a, double n) {
+        if (n == 0.0) return Interval::point(1.0);
+        if (n < 0.0) return div(Interval::point(1.0), integerPower(a, -n));
+        const bool even = std::fmod(n, 2.0) == 0.0;
+        if (!even) return increasing(a, [n](double v) { return std::pow(v, n); });
+        if (a.contains(0.0)) return outward({0.0, std::pow(std::max(std::abs(a.lo), std::abs(a.hi)), n)});
+        const double l = std::min(std::abs(a.lo), std::abs(a.hi)), h = std::max(std::abs(a.lo), std::abs(a.hi));
+        return outward({std::pow(l, n), std::pow(h, n)});
+    }
+
+    inline Interval exp(Interval a) { return increasing(a, [](double v) { return std::exp(v); }); }
+
+    inline Interval log(Interval a) { // Undefined below 0, -inf at 0
+        if (a.hi < 0.0) return Interval::emptySet();
+        return increasing({std::max(a.lo, 0.0), a.hi}, [](double v) { return std::log(v); });
+    }
+
+    inline Interval pow(Interval a, Interval b) {
+        if (b.isPoint() && std::trunc(b.lo) == b.lo) return integerPower(a, b.lo);
+        // Real powers need a non-negative base: exp(b * log(a)) on the defined part of a
+        const Interval base{std::max(a.lo, 0.0), a.hi};
+        if (base.isEmpty()) return Interval::emptySet();
+        return exp(mul(b, log(base)));
+    }
+
+    inline Interval sin(Interval a) {
+        if (!a.isBounded() || a.hi - a.lo >= TWO_PI) return {-1.0, 1.0};
+        Interval r = outward({std::min(std::sin(a.lo), std::sin(a.hi)), std::max(std::sin(a.lo), std::sin(a.hi))});
+        if (containsPhase(a, HALF_PI, TWO_PI)) r.hi = 1.0;
+        if (containsPhase(a, -HALF_PI, TWO_PI)) r.lo = -1.0;
+        return clamp(r, -1.0, 1.0);
+    }
+
+    inline Interval cos(Interval a) {
+        if (!a.isBounded() || a.hi - a.lo >= TWO_PI) return {-1.0, 1.0};
+        Interval r = outward({std::min(std::cos(a.lo), std::cos(a.hi)), std::max(std::cos(a.lo), std::cos(a.hi))});
+        if (containsPhase(a, 0.0, TWO_PI)) r.hi = 1.0;
+        if (containsPhase(a, PI, TWO_PI)) r.lo = -1.0;
+        return clamp(r, -1.0, 1.0);
+    }
+
+    inline Interval tan(Interval a) {
+        if (!a.isBounded() || a.hi - a.lo >= PI || containsPhase(a, HALF_PI, PI)) return Interval::entire(); // Pole
+        return increasing(a, [](double v) { return std::tan(v); });
+    }
+
+    inline Interval fmod(Interval a, Interval b) {
+        if (b.isPoint() && b.lo != 0.0 && a.isBounded() && (a.lo >= 0.0 || a.hi <= 0.0) &&
+            std::trunc(a.lo / b.lo) == std::trunc(a.hi / b.lo)) {
+            return increasing(a, [&](double v) { return std::fmod(v, b.lo); }); // No wrap-around inside a
+        }
+        const double m = std::max(std::abs(b.lo), std::abs(b.hi)); // |fmod(a, b)| < |b| and has the sign of a
+        return {std::max(-m, std::min(a.lo, 0.0)), std::min(m, std::max(a.hi, 0.0))};
+    }
+
+    // Comparison result: exactly 0 or 1 when decided for every pair of operands, otherwise [0, 1]
+    inline Interval truth(bool alwaysTrue, bool alwaysFalse) {
+        if (alwaysTrue) return Interval::point(1.0);
+        if (alwaysFalse) return Interval::point(0.0);
+        return {0.0, 1.0};
+    }
+
+    inline Interval equal(Interval a, Interval b) {
+        if (a.isPoint() && b.isPoint()) return Interval::point(bytecode_ops::equal(a.lo, b.lo));
+        const double scale = std::max({1.0, std::abs(a.lo), std::abs(a.hi), std::abs(b.lo), std::abs(b.hi)});
+        const double margin = scale * bytecode_ops::EQUALITY_EPSILON;
+        return truth(false, a.hi + margin < b.lo || b.hi + margin < a.lo);
+    }
+
+    inline Interval atan2(Interval y, Interval x) {
+        // Away from the origin and the branch cut (negative x axis) the extremes are at the corners
+        if (x.lo > 0.0 || y.lo > 0.0 || y.hi < 0.0) {
+            const double c[4] = {std::atan2(y.lo, x.lo), std::atan2(y.lo, x.hi), std::atan2(y.hi, x.lo), std::atan2(y.hi, x.hi)};
+            return clamp(outward({*std::min_element(c, c + 4), *std::max_element(c, c + 4)}), -PI, PI);
+        }
+        return {-PI, PI};
+    }
+}
+
+// Encloses f(x) for every x in the given interval
+inline Interval evaluateInterval(const ExprNode& node, Interval x) {
+    using namespace interval_ops;
+    if (node.kind == ExprKind::Constant) return Interval::point(node.value);
+    if (node.kind == ExprKind::VariableX) return x;
+
+    const Interval a = evaluateInterval(*node.children[0], x);
+    if (a.isEmpty()) return a;
+    Interval b = Interval::point(0.0);
+    if (node.children.size() > 1) {
+        b = evaluateInterval(*node.children[1], x);
+        if (b.isEmpty()) return b;
+    }
+
+    switch (node.kind) {
+        case ExprKind::Neg:       return {-a.hi, -a.lo};
+        case ExprKind::Add:       return add(a, b);
+        case ExprKind::Sub:       return sub(a, b);
+        case ExprKind::Mul:       return mul(a, b);
+        case ExprKind::Div:       return div(a, b);
+        case ExprKind::Mod:       return interval_ops::fmod(a, b);
+        case ExprKind::Pow:       return interval_ops::pow(a, b);
+        case ExprKind::Less:      return truth(a.hi < b.lo, a.lo >= b.hi);
+        case ExprKind::LessEq:    return truth(a.hi <= b.lo, a.lo > b.hi);
+        case ExprKind::Greater:   return truth(a.lo > b.hi, a.hi <= b.lo);
+        case ExprKind::GreaterEq: return truth(a.lo >= b.hi, a.hi < b.lo);
+        case ExprKind::Equal:     return equal(a, b);
+        case ExprKind::NotEqual:  { const Interval e = equal(a, b); return {1.0 - e.hi, 1.0 - e.lo}; }
+        case ExprKind::Min:       return {std::min(a.lo, b.lo), std::min(a.hi, b.hi)};
+        case ExprKind::Max:       return {std::max(a.lo, b.lo), std::max(a.hi, b.hi)};
+        case ExprKind::Atan2:     return interval_ops::atan2(a, b);
+        case ExprKind::Hypot:     return increasing(add(square(a), square(b)), [](double v) { return std::sqrt(v); });
+        case ExprKind::Sin:       return interval_ops::sin(a);
+        case ExprKind::Cos:       return interval_ops::cos(a);
+        case ExprKind::Tan:       return interval_ops::tan(a);
+        case ExprKind::Asin:      { const Interval d = clamp(a, -1.0, 1.0); return d.isEmpty() ? d : increasing(d, [](double v) { return std::asin(v); }); }
+        case ExprKind::Acos:      { const Interval d = clamp(a, -1.0, 1.0); return d.isEmpty() ? d : outward({std::acos(d.hi), std::acos(d.lo)}); }
+        case ExprKind::Atan:      return increasing(a, [](double v) { return std::atan(v); });
+        case ExprKind::Sinh:      return increasing(a, [](double v) { return std::sinh(v); });
+        case ExprKind::Cosh: {
+            const double l = a.contains(0.0) ? 0.0 : std::min(std::abs(a.lo), std::abs(a.hi));
+            return outward({std::cosh(l), std::cosh(std::max(std::abs(a.lo), std::abs(a.hi)))});
+        }
+        case ExprKind::Tanh:      return clamp(increasing(a, [](double v) { return std::tanh(v); }), -1.0, 1.0);
+        case ExprKind::Asinh:     return increasing(a, [](double v) { return std::asinh(v); });
+        case ExprKind::Acosh:     { const Interval d = clamp(a, 1.0, INFINITY); return d.isEmpty() ? d : increasing(d, [](double v) { return std::acosh(v); }); }
+        case ExprKind::Atanh:     { const Interval d = clamp(a, -1.0, 1.0); return d.isEmpty() ? d : increasing(d, [](double v) { return std::atanh(v); }); }
+        case ExprKind::Exp:       return interval_ops::exp(a);
+        case ExprKind::Log:       return interval_ops::log(a);
+        case ExprKind::Log10:     return a.hi < 0.0 ? Interval::emptySet() : increasing({std::max(a.lo, 0.0), a.hi}, [](double v) { return std::log10(v); });
+        case ExprKind::Log2:      return a.hi < 0.0 ? Interval::emptySet() : increasing({std::max(a.lo, 0.0), a.hi}, [](double v) { return std::log(v) / bytecode_ops::LN2_CONST; });
+        case ExprKind::Sqrt:      return a.hi < 0.0 ? Interval::emptySet() : increasing({std::max(a.lo, 0.0), a.hi}, [](double v) { return std::sqrt(v); });
+        case ExprKind::Cbrt:      return increasing(a, [](double v) { return std::cbrt(v); });
+        case ExprKind::Abs:       return a.contains(0.0) ? Interval{0.0, std::max(-a.lo, a.hi)}
+                                                         : Interval{std::min(std::abs(a.lo), std::abs(a.hi)), std::max(std::abs(a.lo), std::abs(a.hi))};
+        case ExprKind::Floor:     return increasing(a, [](double v) { return std::floor(v); }, true);
+        case ExprKind::Ceil:      return increasing(a, [](double v) { return std::ceil(v); }, true);
+        case ExprKind::Round:     return increasing(a, [](double v) { return bytecode_ops::round(v); }, true);
+        case ExprKind::Constant:
+        case ExprKind::VariableX: break; // Handled above
+    }
+    return Interval::entire();
+}
+
+// Result of intervalRangeSearch()
+struct IntervalRangeResult {
+    double minY = NAN;  // Smallest / largest value attained at an evaluated point away from the poles
+    double maxY = NAN;
+    double lowerBound = INFINITY;  // Guaranteed enclosure of f away from the poles. Wider than [minY, maxY]
+    double upperBound = -INFINITY; // by interval overestimation on boxes minWidth wide and by domain ends
+    std::vector<std::pair<double, double>> poles; // x intervals (merged, ascending) where f is unbounded
+    std::size_t boxes = 0;             // Interval evaluations
+    std::size_t pointEvaluations = 0;
+    bool converged = false;            // Search finished within the box budget
+};
+
+// Range of f over [xMin, xMax] by interval branch and bound, in two phases. First, boxes whose
+// enclosure is unbounded are bisected down to minWidth and reported, padded by minWidth / 2 on each
+// side, as poles, so that values next to a pole never steer the search. Then, starting from the bounded boxes, every box whose enclosure
+// could still hold a value below the best minimum or above the best maximum found so far (by more
+// than tolerance times the current range) is split at its midpoint, where f is evaluated with
+// pointEval; the others are settled. Stops once maxBoxes enclosures have been computed.
+template <typename PointEval>
+IntervalRangeResult intervalRangeSearch(const ExprNode& f, double xMin, double xMax, double minWidth,
+                                        std::size_t maxBoxes, double tolerance, PointEval&& pointEval) {
+    IntervalRangeResult result;
+    struct Box {
+        double a, b;
+        Interval enclosure;
+        double priority;
+        bool operator<(const Box& other) const { return priority < other.priority; }
+    };
+    auto enclose = [&](double a, double b) {
+        ++result.boxes;
+        return Box{a, b, evaluateInterval(f, {a, b}), 0.0};
+    };
+
+    // Phase 1: isolate the poles
+    std::vector<Box> regular, pending{enclose(xMin, xMax)};
+    while (!pending.empty()) {
+        const Box box = pending.back();
+        pending.pop_back();
+        if (box.enclosure.isEmpty()) continue; // Undefined everywhere on the box
+        if (box.enclosure.isBounded() || result.boxes >= maxBoxes) {
+            regular.push_back(box);
+        } else if (box.b - box.a <= minWidth) {
+            result.poles.push_back({box.a, box.b});
+        } else {
+            const double mid = box.a + (box.b - box.a) * 0.5;
+            pending.push_back(enclose(mid, box.b));
+            pending.push_back(enclose(box.a, mid));
+        }
+    }
+    // A pole lies somewhere inside its minWidth box; padding by half that on each side keeps the
+    // range from depending on how close a box edge happened to fall to the pole
+    const double pad = minWidth * 0.5;
+    std::sort(result.poles.begin(), result.poles.end());
+    std::vector<std::pair<double, double>> merged;
+    for (auto [lo, hi] : result.poles) {
+        lo = std::max(xMin, lo - pad);
+        hi = std::min(xMax, hi + pad);
+        if (!merged.empty() && merged.back().second >= lo) merged.back().second = std::max(merged.back().second, hi);
+        else merged.push_back({lo, hi});
+    }
+    result.poles = std::move(merged);
+    std::vector<Box> trimmed;
+    for (const Box& box : regular) {
+        double a = box.a, b = box.b;
+        for (const auto& [lo, hi] : result.poles) {
+            if (lo <= a && a < hi) a = hi;
+            if (lo < b && b <= hi) b = lo;
+        }
+        if (a >= b) continue; // Entirely inside a padded pole
+        trimmed.push_back((a == box.a && b == box.b) ? box : enclose(a, b));
+    }
+    regular = std::move(trimmed);
+
+    // Phase 2: branch and bound over the regular boxes. Splitting goes far below minWidth: smooth
+    // extrema converge on the tolerance long before, and only kinks or domain ends get this deep.
+    const double splitWidth = (xMax - xMin) * 1e-9;
+    auto consider = [&](double x) {
+        const double y = pointEval(x);
+        ++result.pointEvaluations;
+        if (!std::isfinite(y)) return;
+        if (!(y >= result.minY)) result.minY = y; // Also replaces the initial NaN
+        if (!(y <= result.maxY)) result.maxY = y;
+    };
+    auto potential = [&](const Interval& e) { // How much a box could still extend the range found so far
+        if (std::isnan(result.minY)) return std::numeric_limits<double>::infinity();
+        return std::max(result.minY - e.lo, e.hi - result.maxY);
+    };
+    auto settle = [&](const Interval& e) { // Box leaves the search: its enclosure bounds the range
+        result.lowerBound = std::min(result.lowerBound, e.lo);
+        result.upperBound = std::max(result.upperBound, e.hi);
+    };
+
+    auto nearPole = [&](double x) {
+        return std::any_of(result.poles.begin(), result.poles.end(), [x](const auto& pole) { return pole.first <= x && x <= pole.second; });
+    };
+    for (const double end : {xMin, xMax}) {
+        if (!nearPole(end)) consider(end);
+    }
+    for (const Box& box : regular) consider(box.a + (box.b - box.a) * 0.5);
+    std::priority_queue<Box> queue;
+    for (Box box : regular) {
+        box.priority = potential(box.enclosure);
+        queue.push(box);
+    }
+    while (!queue.empty() && result.boxes < maxBoxes) {
+        const Box box = queue.top();
+        queue.pop();
+        const double slack = std::isnan(result.minY) ? 0.0 : tolerance * (result.maxY - result.minY);
+        const bool improvable = std::isnan(result.minY) || box.enclosure.lo < result.minY - slack ||
+                                box.enclosure.hi > result.maxY + slack;
+        if (!improvable || box.b - box.a <= splitWidth) {
+            settle(box.enclosure);
+            continue;
+        }
+        const double mid = box.a + (box.b - box.a) * 0.5;
+        consider(mid);
+        for (Box half : {enclose(box.a, mid), enclose(mid, box.b)}) {
+            if (half.enclosure.isEmpty()) continue;
+            half.priority = potential(half.enclosure);
+            queue.push(half);
+        }
+    }
+    result.converged = queue.empty();
+    while (!queue.empty()) { // Out of budget: what is left still bounds the range
+        settle(queue.top().enclosure);
+        queue.pop();
+    }
+    return result;
+}
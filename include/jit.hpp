@@ -0,0 +1,420 @@
+#pragma once
+
+#include "bytecode.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MATHD_JIT_AVAILABLE 1
+#else
+#define MATHD_JIT_AVAILABLE 0
+#endif
+
+// Native x86-64 JIT for BytecodePrograms. Each program becomes one function that loops over
+// the input two samples at a time using packed SSE2 (baseline on every x86-64 CPU). Arithmetic,
+// min/max, abs, sqrt, hypot, comparisons, epsilon equality and integer powers are emitted
+// inline with the same operation order as bytecode_ops; transcendental and rounding functions
+// are called per lane through per-opcode thunks that compile down to a jump into libm. Results therefore match the VM
+// (and exprtk) bit-for-bit. The code lives in its own mmap'd page, writable while it is being
+// emitted and executable afterwards (never both).
+
+// Out-of-line entry points for the ops the JIT does not emit inline (SysV: a in xmm0, b in xmm1).
+// With the opcode fixed at compile time the switch in apply() folds away.
+using JitHelper = double (*)(double, double);
+
+template <OpCode Op>
+double jitHelper(double a, double b) {
+    return bytecode_ops::apply(Op, a, b);
+}
+
+inline JitHelper jitHelperFor(OpCode op) {
+    switch (op) {
+        case OpCode::Mod: return &jitHelper<OpCode::Mod>;
+        case OpCode::Pow: return &jitHelper<OpCode::Pow>;
+        case OpCode::Atan2: return &jitHelper<OpCode::Atan2>;
+        case OpCode::Sin: return &jitHelper<OpCode::Sin>;
+        case OpCode::Cos: return &jitHelper<OpCode::Cos>;
+        case OpCode::Tan: return &jitHelper<OpCode::Tan>;
+        case OpCode::Asin: return &jitHelper<OpCode::Asin>;
+        case OpCode::Acos: return &jitHelper<OpCode::Acos>;
+        case OpCode::Atan: return &jitHelper<OpCode::Atan>;
+        case OpCode::Sinh: return &jitHelper<OpCode::Sinh>;
+        case OpCode::Cosh: return &jitHelper<OpCode::Cosh>;
+        case OpCode::Tanh: return &jitHelper<OpCode::Tanh>;
+        case OpCode::Asinh: return &jitHelper<OpCode::Asinh>;
+        case OpCode::Acosh: return &jitHelper<OpCode::Acosh>;
+        case OpCode::Atanh: return &jitHelper<OpCode::Atanh>;
+        case OpCode::Exp: return &jitHelper<OpCode::Exp>;
+        case OpCode::Log: return &jitHelper<OpCode::Log>;
+        case OpCode::Log10: return &jitHelper<OpCode::Log10>;
+        case OpCode::Log2: return &jitHelper<OpCode::Log2>;
+        case OpCode::Cbrt: return &jitHelper<OpCode::Cbrt>;
+        case OpCode::Floor: return &jitHelper<OpCode::Floor>;
+        case OpCode::Ceil: return &jitHelper<OpCode::Ceil>;
+        case OpCode::Round: return &jitHelper<OpCode::Round>;
+        default: return nullptr; // Emitted inline
+    }
+}
+
+// Minimal x86-64 encoder: only the handful of forms the JIT needs, xmm0-xmm3 only.
+class X86Emitter {
+public:
+    enum Gpr : std::uint8_t { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+                              R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+
+    std::vector<std::uint8_t>& bytes() { return m_bytes; }
+    std::size_t size() const { return m_bytes.size(); }
+
+    void byte(std::uint8_t b) { m_bytes.push_back(b); }
+
+    void bytes(std::initializer_list<std::uint8_t> list) { m_bytes.insert(m_bytes.end(), list); }
+
+    void imm32(std::int32_t v) {
+        for (int i = 0; i < 4; ++i) byte(static_cast<std::uint8_t>((static_cast<std::uint32_t>(v) >> (8 * i)) & 0xFF));
+    }
+
+    void imm64(std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) byte(static_cast<std::uint8_t>((v >> (8 * i)) & 0xFF));
+    }
+
+    // prefix [REX] 0F opcode ModRM(xmm, [base + disp]) [imm8]
+    void sseMem(std::uint8_t prefix, std::uint8_t opcode, std::uint8_t xmm, Gpr base, std::int32_t disp) {
+        byte(prefix);
+        if (base >= 8) byte(0x41); // REX.B
+        bytes({0x0F, opcode});
+        const std::uint8_t rm = base & 7;
+        if (disp == 0 && rm != 5) {
+            byte(static_cast<std::uint8_t>((xmm << 3) | rm));
+        } else {
+            byte(static_cast<std::uint8_t>(0x80 | (xmm << 3) | rm));
+        }
+        if (rm == 4) byte(0x24); // SIB: no index, base = rsp/r12
+        if (disp != 0 || rm == 5) imm32(disp);
+    }
+
+    // prefix 0F opcode ModRM(dst, src) for register-register forms
+    void sseReg(std::uint8_t prefix, std::uint8_t opcode, std::uint8_t dst, std::uint8_t src) {
+        bytes({prefix, 0x0F, opcode, static_cast<std::uint8_t>(0xC0 | (dst << 3) | src)});
+    }
+
+    std::size_t jumpPlaceholder(std::uint8_t condition) { // 0F 8x rel32, returns offset of rel32
+        bytes({0x0F, condition});
+        imm32(0);
+        return size() - 4;
+    }
+
+    void patchJump(std::size_t relOffset, std::size_t target) {
+        const std::int32_t rel = static_cast<std::int32_t>(static_cast<std::int64_t>(target) - static_cast<std::int64_t>(relOffset + 4));
+        std::memcpy(m_bytes.data() + relOffset, &rel, sizeof(rel));
+    }
+
+private:
+    std::vector<std::uint8_t> m_bytes;
+};
+
+// A compiled program plus its register file. Not thread-safe: use one instance per thread.
+class JitFunction {
+public:
+    using Kernel = void (*)(const double* xs, double* ys, std::size_t pairs, double* registerFile);
+
+    ~JitFunction() {
+#if MATHD_JIT_AVAILABLE
+        if (m_code) munmap(m_code, m_codeSize);
+#endif
+    }
+
+    JitFunction(const JitFunction&) = delete;
+    JitFunction& operator=(const JitFunction&) = delete;
+
+    static bool isAvailable() { return MATHD_JIT_AVAILABLE != 0; }
+
+    // Returns nullptr if the platform has no JIT or the code page cannot be mapped
+    static std::unique_ptr<JitFunction> compile(const BytecodeProgram& program);
+
+    void evaluate(const double* xs, double* ys, std::size_t count) {
+        const std::size_t pairs = count / 2;
+        if (pairs) m_kernel(xs, ys, pairs, m_registerFile.data());
+        if (count % 2) { // Odd tail: run a padded pair
+            const double tailX[2] = {xs[count - 1], xs[count - 1]};
+            double tailY[2];
+            m_kernel(tailX, tailY, 1, m_registerFile.data());
+            ys[count - 1] = tailY[0];
+        }
+    }
+
+    double evaluate(double x) {
+        double y;
+        evaluate(&x, &y, 1);
+        return y;
+    }
+
+private:
+    JitFunction() : m_code(nullptr), m_codeSize(0), m_kernel(nullptr) {}
+
+    void* m_code;
+    std::size_t m_codeSize;
+    Kernel m_kernel;
+    std::vector<double> m_registerFile; // Two lanes per register; operator new gives the 16-byte alignment movapd needs
+
+    friend class JitCompiler;
+};
+
+class JitCompiler {
+public:
+    static std::unique_ptr<JitFunction> compile(const BytecodeProgram& program) {
+#if MATHD_JIT_AVAILABLE
+        static_assert(__STDCPP_DEFAULT_NEW_ALIGNMENT__ >= 16, "JIT register file needs 16-byte aligned slots");
+        JitCompiler compiler(program);
+        compiler.emitFunction();
+
+        const std::vector<std::uint8_t>& code = compiler.m_emitter.bytes();
+        const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        const std::size_t mappedSize = (code.size() + pageSize - 1) / pageSize * pageSize;
+        void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return nullptr;
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, mappedSize, PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, mappedSize);
+            return nullptr;
+        }
+
+        std::unique_ptr<JitFunction> function(new JitFunction());
+        function->m_code = memory;
+        function->m_codeSize = mappedSize;
+        function->m_kernel = reinterpret_cast<JitFunction::Kernel>(memory);
+        function->m_registerFile = compiler.initialRegisterFile();
+        return function;
+#else
+        (void)program;
+        return nullptr;
+#endif
+    }
+
+private:
+    // Opcodes of the packed-double SSE2 instructions used (all 66 0F xx)
+    static constexpr std::uint8_t OP_MOVUPD_LOAD = 0x10, OP_MOVUPD_STORE = 0x11;
+    static constexpr std::uint8_t OP_MOVAPD_LOAD = 0x28, OP_MOVAPD_STORE = 0x29;
+    static constexpr std::uint8_t OP_SQRT = 0x51, OP_AND = 0x54, OP_ADD = 0x58, OP_MUL = 0x59;
+    static constexpr std::uint8_t OP_SUB = 0x5C, OP_MIN = 0x5D, OP_DIV = 0x5E, OP_MAX = 0x5F;
+    static constexpr std::uint8_t OP_XOR = 0x57, OP_CMP = 0xC2, OP_UNPCKLPD = 0x14;
+    static constexpr std::uint8_t PREFIX_PD = 0x66, PREFIX_SD = 0xF2; // packed double / scalar double
+    static constexpr std::uint8_t CMP_LT = 1, CMP_LE = 2;
+    static constexpr std::uint8_t XMM0 = 0, XMM1 = 1, XMM2 = 2;
+
+    const BytecodeProgram& m_program;
+    X86Emitter m_emitter;
+    // Extra register-file slots after the program's registers
+    const std::int32_t m_signSlot, m_absSlot, m_oneSlot, m_epsilonSlot;
+
+    explicit JitCompiler(const BytecodeProgram& program)
+        : m_program(program),
+          m_signSlot(program.registerCount), m_absSlot(program.registerCount + 1),
+          m_oneSlot(program.registerCount + 2), m_epsilonSlot(program.registerCount + 3) {}
+
+    std::vector<double> initialRegisterFile() const {
+        std::vector<double> file(static_cast<std::size_t>(m_epsilonSlot + 1) * 2, 0.0);
+        auto setSlot = [&file](std::int32_t slot, double value) { file[2 * slot] = file[2 * slot + 1] = value; };
+        for (std::size_t c = 0; c < m_program.constants.size(); ++c) setSlot(static_cast<std::int32_t>(c + 1), m_program.constants[c]);
+        const std::uint64_t signBits = 0x8000000000000000ull, absBits = 0x7FFFFFFFFFFFFFFFull;
+        double signMask, absMask;
+        std::memcpy(&signMask, &signBits, sizeof(double));
+        std::memcpy(&absMask, &absBits, sizeof(double));
+        setSlot(m_signSlot, signMask);
+        setSlot(m_absSlot, absMask);
+        setSlot(m_oneSlot, 1.0);
+        setSlot(m_epsilonSlot, bytecode_ops::EQUALITY_EPSILON);
+        return file;
+    }
+
+    static std::int32_t slotOffset(std::int32_t slot) { return slot * 16; }
+
+    // xmm = slot / slot = xmm / xmm op= slot / xmm op= xmm
+    void load(std::uint8_t xmm, std::int32_t slot) { m_emitter.sseMem(PREFIX_PD, OP_MOVAPD_LOAD, xmm, X86Emitter::RBX, slotOffset(slot)); }
+    void store(std::int32_t slot, std::uint8_t xmm) { m_emitter.sseMem(PREFIX_PD, OP_MOVAPD_STORE, xmm, X86Emitter::RBX, slotOffset(slot)); }
+    void opMem(std::uint8_t opcode, std::uint8_t xmm, std::int32_t slot) { m_emitter.sseMem(PREFIX_PD, opcode, xmm, X86Emitter::RBX, slotOffset(slot)); }
+    void opReg(std::uint8_t opcode, std::uint8_t dst, std::uint8_t src) { m_emitter.sseReg(PREFIX_PD, opcode, dst, src); }
+    void cmpReg(std::uint8_t dst, std::uint8_t src, std::uint8_t predicate) { opReg(OP_CMP, dst, src); m_emitter.byte(predicate); }
+
+    void emitFunction() {
+        X86Emitter& e = m_emitter;
+        // push rbx, r12-r15: keeps rsp 16-byte aligned for the libm calls
+        e.bytes({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});
+        e.bytes({0x48, 0x89, 0xCB});   // mov rbx, rcx  (register file)
+        e.bytes({0x49, 0x89, 0xFC});   // mov r12, rdi  (xs)
+        e.bytes({0x49, 0x89, 0xF5});   // mov r13, rsi  (ys)
+        e.bytes({0x49, 0x89, 0xD6});   // mov r14, rdx  (pairs)
+        e.bytes({0x4D, 0x85, 0xF6});   // test r14, r14
+        const std::size_t skipLoop = e.jumpPlaceholder(0x84); // jz done
+
+        const std::size_t loopStart = e.size();
+        e.sseMem(PREFIX_PD, OP_MOVUPD_LOAD, XMM0, X86Emitter::R12, 0);
+        store(BytecodeProgram::X_REGISTER, XMM0);
+        for (const Instruction& ins : m_program.code) emitInstruction(ins);
+        load(XMM0, m_program.resultRegister);
+        e.sseMem(PREFIX_PD, OP_MOVUPD_STORE, XMM0, X86Emitter::R13, 0);
+        e.bytes({0x49, 0x83, 0xC4, 0x10}); // add r12, 16
+        e.bytes({0x49, 0x83, 0xC5, 0x10}); // add r13, 16
+        e.bytes({0x49, 0xFF, 0xCE});       // dec r14
+        e.patchJump(e.jumpPlaceholder(0x85), loopStart); // jnz loop
+
+        e.patchJump(skipLoop, e.size());
+        e.bytes({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3}); // pop r15-r12, rbx; ret
+    }
+
+    void emitInstruction(const Instruction& ins) {
+        switch (ins.op) {
+            case OpCode::Add: emitBinary(OP_ADD, ins); break;
+            case OpCode::Sub: emitBinary(OP_SUB, ins); break;
+            case OpCode::Mul: emitBinary(OP_MUL, ins); break;
+            case OpCode::Div: emitBinary(OP_DIV, ins); break;
+            case OpCode::Neg:
+                load(XMM0, ins.lhs);
+                opMem(OP_XOR, XMM0, m_signSlot);
+                store(ins.dst, XMM0);
+                break;
+            case OpCode::Abs: // (v < 0) ? -v : v, which keeps -0.0 as exprtk does
+                load(XMM0, ins.lhs);
+                opReg(OP_XOR, XMM2, XMM2);
+                opReg(OP_MOVAPD_LOAD, XMM1, XMM0);
+                cmpReg(XMM1, XMM2, CMP_LT);
+                opMem(OP_AND, XMM1, m_signSlot);
+                opReg(OP_XOR, XMM0, XMM1);
+                store(ins.dst, XMM0);
+                break;
+            case OpCode::Sqrt:
+                opMem(OP_SQRT, XMM0, ins.lhs);
+                store(ins.dst, XMM0);
+                break;
+            case OpCode::Hypot: // sqrt((a * a) + (b * b))
+                load(XMM0, ins.lhs);
+                opReg(OP_MUL, XMM0, XMM0);
+                load(XMM1, ins.rhs);
+                opReg(OP_MUL, XMM1, XMM1);
+                opReg(OP_ADD, XMM0, XMM1);
+                opReg(OP_SQRT, XMM0, XMM0);
+                store(ins.dst, XMM0);
+                break;
+            // minpd/maxpd return their second operand on ties and NaNs, so min(b, a) == std::min(a, b)
+            case OpCode::Min: emitSwapped(OP_MIN, ins); break;
+            case OpCode::Max: emitSwapped(OP_MAX, ins); break;
+            case OpCode::Less:      emitCompare(ins.dst, ins.lhs, ins.rhs, CMP_LT); break;
+            case OpCode::LessEq:    emitCompare(ins.dst, ins.lhs, ins.rhs, CMP_LE); break;
+            case OpCode::Greater:   emitCompare(ins.dst, ins.rhs, ins.lhs, CMP_LT); break;
+            case OpCode::GreaterEq: emitCompare(ins.dst, ins.rhs, ins.lhs, CMP_LE); break;
+            case OpCode::Equal:     emitEquality(ins, false); break;
+            case OpCode::NotEqual:  emitEquality(ins, true); break;
+            case OpCode::IPow:
+            case OpCode::IPowInv:   emitIntegerPower(ins); break;
+            default:                emitHelperCall(ins); break;
+        }
+    }
+
+    void emitBinary(std::uint8_t opcode, const Instruction& ins) {
+        load(XMM0, ins.lhs);
+        opMem(opcode, XMM0, ins.rhs);
+        store(ins.dst, XMM0);
+    }
+
+    void emitSwapped(std::uint8_t opcode, const Instruction& ins) {
+        load(XMM0, ins.rhs);
+        opMem(opcode, XMM0, ins.lhs);
+        store(ins.dst, XMM0);
+    }
+
+    // dst = (lhs <predicate> rhs) ? 1.0 : 0.0, via the all-ones compare mask
+    void emitCompare(std::int32_t dstSlot, std::int32_t lhsSlot, std::int32_t rhsSlot, std::uint8_t predicate) {
+        load(XMM0, lhsSlot);
+        load(XMM1, rhsSlot);
+        cmpReg(XMM0, XMM1, predicate);
+        opMem(OP_AND, XMM0, m_oneSlot);
+        store(dstSlot, XMM0);
+    }
+
+    // |a - b| <= max(1, max(|a|, |b|)) * epsilon; the not-equal form uses '>' so NaNs give 0 both ways
+    void emitEquality(const Instruction& ins, bool notEqual) {
+        load(XMM0, ins.lhs);
+        opMem(OP_SUB, XMM0, ins.rhs);
+        opMem(OP_AND, XMM0, m_absSlot);
+        load(XMM1, ins.lhs);
+        opMem(OP_AND, XMM1, m_absSlot);
+        load(XMM2, ins.rhs);
+        opMem(OP_AND, XMM2, m_absSlot);
+        opReg(OP_MAX, XMM2, XMM1);
+        opMem(OP_MAX, XMM2, m_oneSlot);
+        opMem(OP_MUL, XMM2, m_epsilonSlot);
+        if (notEqual) {
+            cmpReg(XMM2, XMM0, CMP_LT);
+            opMem(OP_AND, XMM2, m_oneSlot);
+            store(ins.dst, XMM2);
+        } else {
+            cmpReg(XMM0, XMM2, CMP_LE);
+            opMem(OP_AND, XMM0, m_oneSlot);
+            store(ins.dst, XMM0);
+        }
+    }
+
+    // Mirrors bytecode_ops::integerPower multiplication for multiplication; xmm0 = v, result in xmm1
+    void emitIntegerPower(const Instruction& ins) {
+        unsigned int n = ins.rhs;
+        load(XMM0, ins.lhs);
+        auto copyV = [&] { opReg(OP_MOVAPD_LOAD, XMM1, XMM0); };
+        auto mulV = [&] { opReg(OP_MUL, XMM1, XMM0); };
+        auto square = [&] { opReg(OP_MUL, XMM1, XMM1); };
+        switch (n) {
+            case 1: copyV(); break;
+            case 2: copyV(); mulV(); break;
+            case 3: copyV(); mulV(); mulV(); break;
+            case 4: copyV(); mulV(); square(); break;
+            case 5: copyV(); mulV(); square(); mulV(); break;
+            case 6: copyV(); mulV(); mulV(); square(); break;
+            case 7: copyV(); mulV(); mulV(); square(); mulV(); break;
+            case 8: copyV(); mulV(); square(); square(); break;
+            case 9: copyV(); mulV(); square(); square(); mulV(); break;
+            case 10: copyV(); mulV(); square(); mulV(); square(); break;
+            default:
+                load(XMM1, m_oneSlot);
+                while (n) {
+                    if (n % 2 == 1) {
+                        mulV();
+                        --n;
+                    }
+                    opReg(OP_MUL, XMM0, XMM0);
+                    n /= 2;
+                }
+                break;
+        }
+        if (ins.op == OpCode::IPowInv) {
+            load(XMM2, m_oneSlot);
+            opReg(OP_DIV, XMM2, XMM1);
+            store(ins.dst, XMM2);
+        } else {
+            store(ins.dst, XMM1);
+        }
+    }
+
+    // Lane by lane: xmm0 = a, xmm1 = b; call the op's helper. Lane 0's result is parked in dst and
+    // re-joined with lane 1 in a register, so dst is written by one 16-byte store and later packed
+    // loads of it can be store-forwarded.
+    void emitHelperCall(const Instruction& ins) {
+        const JitHelper helper = jitHelperFor(ins.op);
+        for (std::int32_t lane = 0; lane < 2; ++lane) {
+            m_emitter.sseMem(PREFIX_SD, OP_MOVUPD_LOAD, XMM0, X86Emitter::RBX, slotOffset(ins.lhs) + 8 * lane);
+            m_emitter.sseMem(PREFIX_SD, OP_MOVUPD_LOAD, XMM1, X86Emitter::RBX, slotOffset(ins.rhs) + 8 * lane);
+            m_emitter.bytes({0x48, 0xB8}); // mov rax, imm64
+            m_emitter.imm64(reinterpret_cast<std::uint64_t>(helper));
+            m_emitter.bytes({0xFF, 0xD0}); // call rax
+            if (lane == 0) m_emitter.sseMem(PREFIX_SD, OP_MOVUPD_STORE, XMM0, X86Emitter::RBX, slotOffset(ins.dst));
+        }
+        m_emitter.sseMem(PREFIX_SD, OP_MOVUPD_LOAD, XMM1, X86Emitter::RBX, slotOffset(ins.dst));
+        opReg(OP_UNPCKLPD, XMM1, XMM0);
+        store(ins.dst, XMM1);
+    }
+};
+
+inline std::unique_ptr<JitFunction> JitFunction::compile(const BytecodeProgram& program) {
+    return JitCompiler::compile(program);
+}
@@ -0,0 +1,509 @@
+#pragma once
+
+#include "cpu_features.hpp"
+#include "parallel_for.hpp"
+#include "series_accumulators.hpp" // ScaledProduct: determinants far outside the double range
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Dense linear algebra on double matrices: matrix products, LU with partial pivoting, Cholesky, and
+// the solves, inverses and determinants built on them. Everything of O(n^3) cost ends up in one
+// matrix multiply laid out like GotoBLAS/BLIS: B is packed into KC x NC blocks of NR-column slivers
+// (L3), A into MC x KC blocks of MR-row slivers (L2), and a register-tiled kernel multiplies one
+// MR x KC sliver by one KC x NR sliver (L1) into MR x NR accumulators. On x86-64 CPUs with AVX2 and
+// FMA the kernel runs on 12 ymm registers; it is picked at run time, so the build needs no -march and
+// other CPUs get the portable kernel. Row blocks of A are shared out across threads.
+// The factorizations spend their time in the same multiply: LU splits the columns recursively, and
+// Cholesky works through panels of NB columns, updating the rest of the matrix after each.
+
+namespace linear_algebra_detail {
+    constexpr std::size_t MR = 6;    // Rows of the register tile: 6 x 8 accumulators are 12 ymm registers
+    constexpr std::size_t NR = 8;    // Columns of the register tile: two vectors of 4 doubles
+    constexpr std::size_t KC = 256;  // Depth of a packed block: a KC x NR sliver of B is 16 KB, for L1
+    constexpr std::size_t MC = 96;   // Rows of a packed block of A: 96 x 256 doubles are 192 KB, for L2
+    constexpr std::size_t NC = 2048; // Columns of a packed block of B: 256 x 2048 doubles are 4 MB, for L3
+    constexpr std::size_t NB = 64;   // Panel width of Cholesky and block size of the triangular solves
+    constexpr std::size_t UPDATE_ROWS = 256; // Row blocks of the Cholesky update, which skips the upper triangle
+    constexpr double PARALLEL_FLOPS = 4e6;  // Below this, starting threads costs more than it saves
+}
+
+// An m x n window on row-major or strided storage: element (i, j) is at data[i * rowStride + j * colStride].
+// Swapping the strides transposes the view without moving data.
+template <typename Element>
+struct BasicMatrixView {
+    Element* data = nullptr;
+    std::size_t rows = 0;
+    std::size_t cols = 0;
+    std::ptrdiff_t rowStride = 0;
+    std::ptrdiff_t colStride = 1;
+
+    BasicMatrixView() = default;
+    BasicMatrixView(Element* values, std::size_t rowCount, std::size_t colCount, std::ptrdiff_t rowStep, std::ptrdiff_t colStep = 1)
+        : data(values), rows(rowCount), cols(colCount), rowStride(rowStep), colStride(colStep) {}
+
+    // A view of mutable elements converts to a view of const ones
+    template <typename Other, typename = std::enable_if_t<std::is_convertible_v<Other*, Element*>>>
+    BasicMatrixView(const BasicMatrixView<Other>& other)
+        : data(other.data), rows(other.rows), cols(other.cols), rowStride(other.rowStride), colStride(other.colStride) {}
+
+    Element& operator()(std::size_t i, std::size_t j) const {
+        return data[static_cast<std::ptrdiff_t>(i) * rowStride + static_cast<std::ptrdiff_t>(j) * colStride];
+    }
+
+    // The rowCount x colCount window whose top-left element is (row, col)
+    BasicMatrixView block(std::size_t row, std::size_t col, std::size_t rowCount, std::size_t colCount) const {
+        if (rowCount == 0 || colCount == 0) return {data, rowCount, colCount, rowStride, colStride};
+        return {&(*this)(row, col), rowCount, colCount, rowStride, colStride};
+    }
+
+    BasicMatrixView transposed() const { return {data, cols, rows, colStride, rowStride}; }
+};
+
+using MatrixView = BasicMatrixView<double>;
+using ConstMatrixView = BasicMatrixView<const double>;
+
+// A dense, row-major matrix of doubles
+class Matrix {
+public:
+    Matrix() = default;
+    Matrix(std::size_t rows, std::size_t cols, double fill = 0.0) : m_rows(rows), m_cols(cols), m_values(rows * cols, fill) {}
+
+    static Matrix identity(std::size_t n) {
+        Matrix result(n, n);
+        for (std::size_t i = 0; i < n; ++i) result(i, i) = 1.0;
+        return result;
+    }
+
+    std::size_t rows() const { return m_rows; }
+    std::size_t cols() const { return m_cols; }
+    bool empty() const { return m_values.empty(); }
+    bool square() const { return m_rows == m_cols; }
+
+    double& operator()(std::size_t i, std::size_t j) { return m_values[i * m_cols + j]; }
+    double operator()(std::size_t i, std::size_t j) const { return m_values[i * m_cols + j]; }
+    double* row(std::size_t i) { return m_values.data() + i * m_cols; }
+    const double* row(std::size_t i) const { return m_values.data() + i * m_cols; }
+
+    MatrixView view() { return {m_values.data(), m_rows, m_cols, static_cast<std::ptrdiff_t>(m_cols)}; }
+    ConstMatrixView view() const { return {m_values.data(), m_rows, m_cols, static_cast<std::ptrdiff_t>(m_cols)}; }
+
+    // Reads "[1 2; 3 4]": values separated by spaces or commas, rows by ';' or line breaks, the
+    // brackets optional. On failure the matrix is unchanged and error says why.
+    bool parse(const std::string& text, std::string& error) {
+        std::string body = text;
+        const std::size_t open = body.find('['), close = body.rfind(']');
+        if (open != std::string::npos || close != std::string::npos) {
+            if (open == std::string::npos || close == std::string::npos || close < open) {
+                error = "Unbalanced brackets.";
+                return false;
+            }
+            body = body.substr(open + 1, close - open - 1);
+        }
+        std::vector<double> values;
+        std::size_t cols = 0, rows = 0, rowValues = 0;
+        auto endRow = [&] {
+            if (rowValues == 0) return true; // Blank line or trailing ';'
+            if (rows > 0 && rowValues != cols) {
+                error = "Row " + std::to_string(rows + 1) + " has " + std::to_string(rowValues) + " values, row 1 has " + std::to_string(cols) + ".";
+                return false;
+            }
+            cols = rowValues;
+            ++rows;
+            rowValues = 0;
+            return true;
+        };
+        const char* cursor = body.c_str();
+        while (*cursor != '\0') {
+            if (*cursor == ';' || *cursor == '\n') {
+                if (!endRow()) return false;
+                ++cursor;
+            } else if (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == ',') {
+                ++cursor;
+            } else {
+                char* end = nullptr;
+                const double value = std::strtod(cursor, &end);
+                if (end == cursor) {
+                    const std::size_t length = std::strcspn(cursor, " \t\r\n,;");
+                    error = "Not a number: " + std::string(cursor, length);
+                    return false;
+                }
+                values.push_back(value);
+                ++rowValues;
+                cursor = end;
+            }
+        }
+        if (!endRow()) return false;
+        if (values.empty()) {
+            error = "No values given.";
+            return false;
+        }
+        m_rows = rows;
+        m_cols = cols;
+        m_values = std::move(values);
+        return true;
+    }
+
+private:
+    std::size_t m_rows = 0;
+    std::size_t m_cols = 0;
+    std::vector<double> m_values; // Row-major
+};
+
+namespace linear_algebra_detail {
+    constexpr std::size_t roundUp(std::size_t n, std::size_t step) { return (n + step - 1) / step * step; }
+
+    // tile (MR x NR, row-major) = a * b for a packed MR x depth sliver of A and depth x NR sliver of B
+    using Kernel = void (*)(std::size_t depth, const double* a, const double* b, double* tile);
+
+    inline void genericKernel(std::size_t depth, const double* a, const double* b, double* tile) {
+        double sums[MR][NR] = {};
+        for (std::size_t p = 0; p < depth; ++p, a += MR, b += NR) {
+            for (std::size_t i = 0; i < MR; ++i) {
+                for (std::size_t j = 0; j < NR; ++j) sums[i][j] += a[i] * b[j];
+            }
+        }
+        std::copy(&sums[0][0], &sums[0][0] + MR * NR, tile);
+    }
+
+#if defined(__x86_64__)
+    // Per step of depth: two loads of B, six broadcasts of A and twelve fused multiply-adds
+    [[gnu::target("avx2,fma")]]
+    inline void avx2Kernel(std::size_t depth, const double* a, const double* b, double* tile) {
+        __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+        __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(), c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+        __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd(), c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+        for (std::size_t p = 0; p < depth; ++p, a += MR, b += NR) {
+            const __m256d b0 = _mm256_loadu_pd(b);
+            const __m256d b1 = _mm256_loadu_pd(b + 4);
+            __m256d ai = _mm256_broadcast_sd(a);
+            c00 = _mm256_fmadd_pd(ai, b0, c00);
+            c01 = _mm256_fmadd_pd(ai, b1, c01);
+            ai = _mm256_broadcast_sd(a + 1);
+            c10 = _mm256_fmadd_pd(ai, b0, c10);
+            c11 = _mm256_fmadd_pd(ai, b1, c11);
+            ai = _mm256_broadcast_sd(a + 2);
+            c20 = _mm256_fmadd_pd(ai, b0, c20);
+            c21 = _mm256_fmadd_pd(ai, b1, c21);
+            ai = _mm256_broadcast_sd(a + 3);
+            c30 = _mm256_fmadd_pd(ai, b0, c30);
+            c31 = _mm256_fmadd_pd(ai, b1, c31);
+            ai = _mm256_broadcast_sd(a + 4);
+            c40 = _mm256_fmadd_pd(ai, b0, c40);
+            c41 = _mm256_fmadd_pd(ai, b1, c41);
+            ai = _mm256_broadcast_sd(a + 5);
+            c50 = _mm256_fmadd_pd(ai, b0, c50);
+            c51 = _mm256_fmadd_pd(ai, b1, c51);
+        }
+        _mm256_storeu_pd(tile + 0, c00);
+        _mm256_storeu_pd(tile + 4, c01);
+        _mm256_storeu_pd(tile + 8, c10);
+        _mm256_storeu_pd(tile + 12, c11);
+        _mm256_storeu_pd(tile + 16, c20);
+        _mm256_storeu_pd(tile + 20, c21);
+        _mm256_storeu_pd(tile + 24, c30);
+        _mm256_storeu_pd(tile + 28, c31);
+        _mm256_storeu_pd(tile + 32, c40);
+        _mm256_storeu_pd(tile + 36, c41);
+        _mm256_storeu_pd(tile + 40, c50);
+        _mm256_storeu_pd(tile + 44, c51);
+    }
+#endif
+
+    inline Kernel selectKernel() {
+#if defined(__x86_64__)
+        if (cpuHasAvx2Fma()) return avx2Kernel;
+#endif
+        return genericKernel;
+    }
+
+    // Copies a into MR-row slivers, each stored column by column and zero-padded to MR rows
+    inline void packA(ConstMatrixView a, double* packed) {
+        for (std::size_t top = 0; top < a.rows; top += MR) {
+            const std::size_t height = std::min(MR, a.rows - top);
+            for (std::size_t p = 0; p < a.cols; ++p, packed += MR) {
+                for (std::size_t i = 0; i < height; ++i) packed[i] = a(top + i, p);
+                std::fill(packed + height, packed + MR, 0.0);
+            }
+        }
+    }
+
+    // Copies b into NR-column slivers, each stored row by row and zero-padded to NR columns
+    inline void packB(ConstMatrixView b, double* packed) {
+        for (std::size_t left = 0; left < b.cols; left += NR) {
+            const std::size_t width = std::min(NR, b.cols - left);
+            for (std::size_t p = 0; p < b.rows; ++p, packed += NR) {
+                for (std::size_t j = 0; j < width; ++j) packed[j] = b(p, left + j);
+                std::fill(packed + width, packed + NR, 0.0);
+            }
+        }
+    }
+
+    // c += alpha * A * B for a packed rows x depth block of A and depth x cols block of B. Each B
+    // sliver stays in L1 while the kernel runs down all the A slivers.
+    inline void multiplyPacked(std::size_t depth, const double* packedA, const double* packedB, MatrixView c, double alpha, Kernel kernel) {
+        alignas(32) double tile[MR * NR];
+        for (std::size_t left = 0; left < c.cols; left += NR) {
+            const std::size_t width = std::min(NR, c.cols - left);
+            for (std::size_t top = 0; top < c.rows; top += MR) {
+                const std::size_t height = std::min(MR, c.rows - top);
+                kernel(depth, packedA + top * depth, packedB + left * depth, tile);
+                for (std::size_t i = 0; i < height; ++i) {
+                    for (std::size_t j = 0; j < width; ++j) c(top + i, left + j) += alpha * tile[i * NR + j];
+                }
+            }
+        }
+    }
+
+    // Threads worth starting for about flops floating-point operations
+    inline unsigned workersFor(double flops, unsigned threads) { return flops < PARALLEL_FLOPS ? 1u : std::max(threads, 1u); }
+
+    // b.row(target) -= factor * b.row(source)
+    inline void subtractRow(MatrixView b, std::size_t target, std::size_t source, double factor) {
+        for (std::size_t j = 0; j < b.cols; ++j) b(target, j) -= factor * b(source, j);
+    }
+
+    inline void divideRow(MatrixView b, std::size_t target, double divisor) {
+        for (std::size_t j = 0; j < b.cols; ++j) b(target, j) /= divisor;
+    }
+}
+
+// "avx2+fma" or "generic": the kernel multiplyAdd() runs on this CPU
+inline const char* matrixKernelName() { return cpuHasAvx2Fma() ? "avx2+fma" : "generic"; }
+
+// c += alpha * a * b for a (m x k), b (k x n) and c (m x n), on up to threads threads. The views may
+// have any strides (transposed operands cost nothing extra), but c must not overlap a or b.
+inline void multiplyAdd(ConstMatrixView a, ConstMatrixView b, MatrixView c, double alpha, unsigned threads) {
+    using namespace linear_algebra_detail;
+    const std::size_t m = c.rows, n = c.cols, k = a.cols;
+    if (m == 0 || n == 0 || k == 0 || alpha == 0.0) return;
+    const unsigned workers = workersFor(2.0 * static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k), threads);
+    // Row blocks of at most MC rows, and at least one per thread where the rows allow it
+    const std::size_t blockRows = std::min(MC, roundUp((m + workers - 1) / workers, MR));
+    const std::size_t blockCount = (m + blockRows - 1) / blockRows;
+    const Kernel kernel = selectKernel();
+    std::vector<double> packedB;
+    for (std::size_t left = 0; left < n; left += NC) {
+        const std::size_t width = std::min(NC, n - left);
+        for (std::size_t depthStart = 0; depthStart < k; depthStart += KC) {
+            const std::size_t depth = std::min(KC, k - depthStart);
+            packedB.resize(roundUp(width, NR) * depth);
+            packB(b.block(depthStart, left, depth, width), packedB.data());
+            parallelFor(blockCount, workers, [&](std::size_t blockIndex) {
+                thread_local std::vector<double> packedA;
+                const std::size_t top = blockIndex * blockRows, height = std::min(blockRows, m - top);
+                packedA.resize(roundUp(height, MR) * depth);
+                packA(a.block(top, depthStart, height, depth), packedA.data());
+                multiplyPacked(depth, packedA.data(), packedB.data(), c.block(top, left, height, width), alpha, kernel);
+            });
+        }
+    }
+}
+
+inline Matrix multiply(const Matrix& a, const Matrix& b, unsigned threads) {
+    Matrix product(a.rows(), b.cols());
+    multiplyAdd(a.view(), b.view(), product.view(), 1.0, threads);
+    return product;
+}
+
+// Solves l * x = b in place of b, for l lower triangular (only its lower triangle is read; with
+// unitDiagonal its diagonal is taken to be 1 and not read either)
+inline void solveLowerInPlace(ConstMatrixView l, MatrixView b, bool unitDiagonal, unsigned threads) {
+    using namespace linear_algebra_detail;
+    const std::size_t n = b.rows;
+    const unsigned workers = workersFor(static_cast<double>(n) * static_cast<double>(NB) * static_cast<double>(b.cols), threads);
+    for (std::size_t start = 0; start < n; start += NB) {
+        const std::size_t size = std::min(NB, n - start);
+        // Substitution within the diagonal block; the columns of b are independent
+        parallelFor((b.cols + KC - 1) / KC, workers, [&](std::size_t chunk) {
+            const MatrixView columns = b.block(0, chunk * KC, n, std::min(KC, b.cols - chunk * KC));
+            for (std::size_t i = start; i < start + size; ++i) {
+                for (std::size_t p = start; p < i; ++p) subtractRow(columns, i, p, l(i, p));
+                if (!unitDiagonal) divideRow(columns, i, l(i, i));
+            }
+        });
+        // The rows below: b2 -= l21 * x1
+        const std::size_t below = n - start - size;
+        multiplyAdd(l.block(start + size, start, below, size), b.block(start, 0, size, b.cols), b.block(start + size, 0, below, b.cols), -1.0, threads);
+    }
+}
+
+// Solves u * x = b in place of b, for u upper triangular (only its upper triangle is read)
+inline void solveUpperInPlace(ConstMatrixView u, MatrixView b, unsigned threads) {
+    using namespace linear_algebra_detail;
+    const std::size_t n = b.rows;
+    const unsigned workers = workersFor(static_cast<double>(n) * static_cast<double>(NB) * static_cast<double>(b.cols), threads);
+    for (std::size_t end = n; end > 0;) {
+        const std::size_t size = std::min(NB, end), start = end - size;
+        parallelFor((b.cols + KC - 1) / KC, workers, [&](std::size_t chunk) {
+            const MatrixView columns = b.block(0, chunk * KC, n, std::min(KC, b.cols - chunk * KC));
+            for (std::size_t i = end; i-- > start;) {
+                for (std::size_t p = i + 1; p < end; ++p) subtractRow(columns, i, p, u(i, p));
+                divideRow(columns, i, u(i, i));
+            }
+        });
+        // The rows above: b1 -= u12 * x2
+        multiplyAdd(u.block(0, start, start, size), b.block(start, 0, size, b.cols), b.block(0, 0, start, b.cols), -1.0, threads);
+        end = start;
+    }
+}
+
+// P * A = L * U for a square A, with L unit lower triangular and U upper triangular
+struct LuDecomposition {
+    Matrix factors;                  // L below the diagonal (its unit diagonal implied), U on and above it
+    std::vector<std::size_t> pivots; // Step k swapped rows k and pivots[k]
+    int sign = 1;                    // Of the row permutation: +1 or -1
+    bool singular = false;           // Some pivot was exactly zero
+
+    // det(A) = sign * product of the diagonal of U, kept clear of overflow and underflow
+    ScaledProduct determinant() const {
+        ScaledProduct result;
+        for (std::size_t k = 0; k < factors.rows(); ++k) result.add(factors(k, k));
+        if (sign < 0) result.mantissa = -result.mantissa;
+        return result;
+    }
+
+    // min |u_kk| / max |u_kk|: a rough reciprocal condition estimate. Near n * 2^-52 and below, A
+    // is singular to working precision and solutions carry no correct digits.
+    double pivotRatio() const {
+        double smallest = INFINITY, largest = 0.0;
+        for (std::size_t k = 0; k < factors.rows(); ++k) {
+            smallest = std::min(smallest, std::abs(factors(k, k)));
+            largest = std::max(largest, std::abs(factors(k, k)));
+        }
+        return largest > 0.0 ? smallest / largest : 0.0;
+    }
+
+    // Solves A * x = b in place of b (b has as many rows as A). Only for a non-singular A.
+    void solveInPlace(MatrixView b, unsigned threads) const {
+        for (std::size_t k = 0; k < pivots.size(); ++k) {
+            if (pivots[k] == k) continue;
+            for (std::size_t j = 0; j < b.cols; ++j) std::swap(b(k, j), b(pivots[k], j));
+        }
+        solveLowerInPlace(factors.view(), b, true, threads);
+        solveUpperInPlace(factors.view(), b, threads);
+    }
+
+    Matrix inverse(unsigned threads) const {
+        Matrix result = Matrix::identity(factors.rows());
+        solveInPlace(result.view(), threads);
+        return result;
+    }
+};
+
+namespace linear_algebra_detail {
+    constexpr std::size_t LU_LEAF_COLUMNS = 8; // Narrower column ranges are factored one column at a time
+
+    // Factors columns [first, first + width) of a from row first down, given the columns to their
+    // left are done: left half first, then the right half is brought up to date by a triangular
+    // solve and a matrix product (where nearly all the time goes), then factored in turn. Row swaps
+    // run across the whole row, so L and the rest of the matrix are permuted along with the column.
+    inline void factorColumns(Matrix& a, std::size_t first, std::size_t width, LuDecomposition& lu, unsigned threads) {
+        const std::size_t n = a.rows();
+        if (width > LU_LEAF_COLUMNS) {
+            const std::size_t left = width / 2, right = width - left, middle = first + left;
+            factorColumns(a, first, left, lu, threads);
+            const MatrixView all = a.view();
+            solveLowerInPlace(all.block(first, first, left, left), all.block(first, middle, left, right), true, threads);
+            multiplyAdd(all.block(middle, first, n - middle, left), all.block(first, middle, left, right), all.block(middle, middle, n - middle, right), -1.0, threads);
+            factorColumns(a, middle, right, lu, threads);
+            return;
+        }
+        for (std::size_t j = first; j < first + width; ++j) {
+            std::size_t pivot = j;
+            for (std::size_t i = j + 1; i < n; ++i) {
+                if (std::abs(a(i, j)) > std::abs(a(pivot, j))) pivot = i;
+            }
+            lu.pivots[j] = pivot;
+            if (pivot != j) {
+                std::swap_ranges(a.row(j), a.row(j) + n, a.row(pivot));
+                lu.sign = -lu.sign;
+            }
+            const double diagonal = a(j, j);
+            if (diagonal == 0.0) { // The column is already zero below the diagonal
+                lu.singular = true;
+                continue;
+            }
+            const double* pivotRow = a.row(j);
+            for (std::size_t i = j + 1; i < n; ++i) {
+                double* row = a.row(i);
+                const double multiplier = row[j] /= diagonal;
+                for (std::size_t c = j + 1; c < first + width; ++c) row[c] -= multiplier * pivotRow[c];
+            }
+        }
+    }
+}
+
+// LU with partial pivoting, recursive on halves of the columns (Toledo's scheme): besides the pivot
+// searches on each column, the work is triangular solves and matrix products of every size down to
+// LU_LEAF_COLUMNS, so even the panels run on the blocked multiply
+inline LuDecomposition luDecompose(Matrix a, unsigned threads) {
+    LuDecomposition lu;
+    lu.pivots.resize(a.rows());
+    linear_algebra_detail::factorColumns(a, 0, a.rows(), lu, threads);
+    lu.factors = std::move(a);
+    return lu;
+}
+
+// True if a is square and a(i, j) and a(j, i) agree to relativeTolerance of the larger
+inline bool isSymmetric(ConstMatrixView a, double relativeTolerance = 1e-12) {
+    if (a.rows != a.cols) return false;
+    for (std::size_t i = 0; i < a.rows; ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            const double scale = std::max(std::abs(a(i, j)), std::abs(a(j, i)));
+            if (std::abs(a(i, j) - a(j, i)) > relativeTolerance * scale) return false;
+        }
+    }
+    return true;
+}
+
+// A = L * L^T for a symmetric positive definite A: on success a holds L (zero above the diagonal).
+// Only the lower triangle of a is read. Returns false, leaving a partly overwritten, if a pivot is
+// not positive: A is then not positive definite (or is too close to it for doubles).
+inline bool choleskyInPlace(Matrix& a, unsigned threads) {
+    using namespace linear_algebra_detail;
+    const std::size_t n = a.rows();
+    const MatrixView all = a.view();
+    for (std::size_t start = 0; start < n; start += NB) {
+        const std::size_t size = std::min(NB, n - start), end = start + size;
+        for (std::size_t j = start; j < end; ++j) {
+            double pivot = a(j, j);
+            for (std::size_t p = start; p < j; ++p) pivot -= a(j, p) * a(j, p);
+            if (!(pivot > 0.0)) return false;
+            a(j, j) = std::sqrt(pivot);
+            for (std::size_t i = j + 1; i < end; ++i) {
+                double value = a(i, j);
+                for (std::size_t p = start; p < j; ++p) value -= a(i, p) * a(j, p);
+                a(i, j) = value / a(j, j);
+            }
+        }
+        // L21 = A21 * L11^-T: a forward substitution along each row below the panel
+        const unsigned workers = workersFor(static_cast<double>(n - end) * static_cast<double>(size * size), threads);
+        parallelFor((n - end + MC - 1) / MC, workers, [&](std::size_t chunk) {
+            for (std::size_t i = end + chunk * MC; i < std::min(n, end + (chunk + 1) * MC); ++i) {
+                double* row = a.row(i);
+                for (std::size_t j = start; j < end; ++j) {
+                    const double* pivotRow = a.row(j);
+                    double value = row[j];
+                    for (std::size_t p = start; p < j; ++p) value -= row[p] * pivotRow[p];
+                    row[j] = value / pivotRow[j];
+                }
+            }
+        });
+        // A22 -= L21 * L21^T, by row blocks that stop at the diagonal
+        for (std::size_t top = end; top < n; top += UPDATE_ROWS) {
+            const std::size_t height = std::min(UPDATE_ROWS, n - top), width = top + height - end;
+            multiplyAdd(all.block(top, start, height, size), all.block(end, start, width, size).transposed(), all.block(top, end, height, width), -1.0, threads);
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) std::fill(a.row(i) + i + 1, a.row(i) + n, 0.0);
+    return true;
+}
@@ -0,0 +1,950 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary floating point with a significand of Limbs 64-bit limbs (~19.3 decimal digits per limb) and
+// a 25-bit exponent, in plain C++ with no library behind it. Every operation rounds to nearest.
+// +, -, * and / are exact before rounding: the significands are multiplied through 64x64->128-bit
+// products (schoolbook, Karatsuba from KARATSUBA_THRESHOLD limbs) and divided by Knuth's algorithm D.
+// sqrt and cbrt are Newton iterations. exp, log and the trigonometric functions reduce their
+// argument and sum a Taylor or atanh series, where each term costs one multiplication and one
+// division by a small integer. pow and the reduction of sin and cos carry an extra limb, and erfc a
+// doubled significand where it is 1 - erf. Transcendental results are good to a few ulps, which
+// DIGITS leaves out. The arithmetic kernels are kept out of line: exprtk instantiates thousands of
+// node types over its scalar, and inlining loops over the limbs into each would cost far more build
+// time than the calls cost at run time. Like Float128, the math functions are hidden friends found by
+// argument-dependent lookup, and there is a std::numeric_limits specialization, so the type can be
+// the scalar of exprtk's templates.
+template <std::size_t Limbs>
+class MultiFloat {
+    static_assert(Limbs >= 2, "MultiFloat needs at least two limbs");
+
+public:
+    using Limb = std::uint64_t;
+    static constexpr int BITS = static_cast<int>(64 * Limbs);     // Significand bits
+    static constexpr std::int64_t MAX_EXPONENT = std::int64_t(1) << 24; // |value| < 2^MAX_EXPONENT
+    static constexpr std::int64_t MIN_EXPONENT = -MAX_EXPONENT;        // |value| >= 2^(MIN_EXPONENT - 1) unless zero
+    static constexpr int GUARD_BITS = 8; // Rounding error allowed for the transcendental functions
+    static constexpr int DIGITS = static_cast<int>((BITS - GUARD_BITS) * 0.30102999566398120); // Decimal digits always preserved
+    static constexpr int MAX_DIGITS = static_cast<int>(BITS * 0.30102999566398120) + 2;        // Enough to tell all values apart
+    static constexpr std::size_t KARATSUBA_THRESHOLD = 32; // Limbs; below this schoolbook is faster
+
+    MultiFloat() = default; // Zero
+
+    // Implicit from every built-in arithmetic type, like a built-in floating-point type; exact
+    template <typename A> requires std::is_arithmetic_v<A>
+    MultiFloat(A value) {
+        if constexpr (std::is_integral_v<A>) {
+            const bool negative = value < 0;
+            const std::uint64_t magnitude = negative ? std::uint64_t(0) - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+            assignInteger(negative, magnitude);
+        } else {
+            assignFloating(static_cast<long double>(value));
+        }
+    }
+
+    // From another limb count, rounded to nearest
+    template <std::size_t Other> requires (Other != Limbs)
+    explicit MultiFloat(const MultiFloat<Other>& other) : m_negative(other.m_negative), m_kind(static_cast<Kind>(other.m_kind)) {
+        if (other.m_kind != MultiFloat<Other>::Kind::Finite) return;
+        if constexpr (Other > Limbs) {
+            *this = rounded(other.m_negative, other.m_exponent, other.m_limbs);
+        } else {
+            std::copy(other.m_limbs.begin(), other.m_limbs.end(), m_limbs.begin() + (Limbs - Other));
+            m_exponent = other.m_exponent;
+        }
+    }
+
+    template <typename A> requires std::is_arithmetic_v<A>
+    explicit operator A() const {
+        if constexpr (std::is_same_v<A, bool>) return m_kind != Kind::Zero;
+        else return static_cast<A>(toLongDouble());
+    }
+
+    // The value with the given number of significant digits (at most MAX_DIGITS), as printf's %g
+    // would show it
+    std::string toString(int digits = DIGITS) const;
+
+    MultiFloat operator-() const {
+        MultiFloat result = *this;
+        if (m_kind != Kind::NaN) result.m_negative = !m_negative;
+        return result;
+    }
+    MultiFloat operator+() const { return *this; }
+    MultiFloat& operator+=(const MultiFloat& other) { return *this = add(*this, other, other.m_negative); }
+    MultiFloat& operator-=(const MultiFloat& other) { return *this = add(*this, other, !other.m_negative); }
+    MultiFloat& operator*=(const MultiFloat& other) { return *this = multiply(*this, other); }
+    MultiFloat& operator/=(const MultiFloat& other) { return *this = divide(*this, other); }
+
+    friend MultiFloat operator+(const MultiFloat& a, const MultiFloat& b) { return add(a, b, b.m_negative); }
+    friend MultiFloat operator-(const MultiFloat& a, const MultiFloat& b) { return add(a, b, !b.m_negative); }
+    friend MultiFloat operator*(const MultiFloat& a, const MultiFloat& b) { return multiply(a, b); }
+    friend MultiFloat operator/(const MultiFloat& a, const MultiFloat& b) { return divide(a, b); }
+    friend bool operator==(const MultiFloat& a, const MultiFloat& b) { return compare(a, b) == 0; }
+    friend bool operator!=(const MultiFloat& a, const MultiFloat& b) { return compare(a, b) != 0; }
+    friend bool operator<(const MultiFloat& a, const MultiFloat& b) { return compare(a, b) == -1; }
+    friend bool operator<=(const MultiFloat& a, const MultiFloat& b) { const int c = compare(a, b); return c == -1 || c == 0; }
+    friend bool operator>(const MultiFloat& a, const MultiFloat& b) { return compare(a, b) == 1; }
+    friend bool operator>=(const MultiFloat& a, const MultiFloat& b) { const int c = compare(a, b); return c == 1 || c == 0; }
+
+    friend std::ostream& operator<<(std::ostream& out, const MultiFloat& value) {
+        return out << value.toString(static_cast<int>(out.precision()));
+    }
+
+    // v * 2^power, exact unless it leaves the exponent range
+    friend MultiFloat ldexp(const MultiFloat& v, std::int64_t power) {
+        if (v.m_kind != Kind::Finite) return v;
+        MultiFloat result = v;
+        return result.withExponent(v.m_exponent + std::clamp(power, -4 * MAX_EXPONENT, 4 * MAX_EXPONENT));
+    }
+
+    friend MultiFloat abs(const MultiFloat& v) { return v.m_kind == Kind::NaN ? v : withSign(v, false); }
+    friend MultiFloat fabs(const MultiFloat& v) { return abs(v); }
+    friend bool isnan(const MultiFloat& v) { return v.m_kind == Kind::NaN; }
+    friend bool isinf(const MultiFloat& v) { return v.m_kind == Kind::Infinite; }
+    friend bool isfinite(const MultiFloat& v) { return v.m_kind == Kind::Zero || v.m_kind == Kind::Finite; }
+
+    friend MultiFloat trunc(const MultiFloat& v) {
+        if (v.m_kind != Kind::Finite || v.m_exponent >= BITS) return v;
+        if (v.m_exponent <= 0) return withSign(MultiFloat(), v.m_negative);
+        MultiFloat result = v;
+        const int fractionBits = BITS - static_cast<int>(v.m_exponent);
+        for (int i = 0; i * 64 < fractionBits; ++i) {
+            const int bits = fractionBits - i * 64;
+            result.m_limbs[i] = bits >= 64 ? 0 : result.m_limbs[i] & ~((Limb(1) << bits) - 1);
+        }
+        return result;
+    }
+    friend MultiFloat floor(const MultiFloat& v) {
+        const MultiFloat t = trunc(v);
+        return (v.m_negative && t != v) ? t - MultiFloat(1) : t;
+    }
+    friend MultiFloat ceil(const MultiFloat& v) {
+        const MultiFloat t = trunc(v);
+        return (!v.m_negative && t != v) ? t + MultiFloat(1) : t;
+    }
+    // Halfway cases away from zero, like std::round
+    friend MultiFloat round(const MultiFloat& v) {
+        const MultiFloat t = trunc(v);
+        if (abs(v - t) < MultiFloat(0.5)) return t;
+        return v.m_negative ? t - MultiFloat(1) : t + MultiFloat(1);
+    }
+    // a - n*b with n = trunc(a/b); exact while a/b has fewer than BITS integer bits
+    friend MultiFloat fmod(const MultiFloat& a, const MultiFloat& b) {
+        if (isnan(a) || isnan(b) || isinf(a) || b.m_kind == Kind::Zero) return nan();
+        if (isinf(b) || a.m_kind == Kind::Zero || abs(a) < abs(b)) return a;
+        MultiFloat result = a - trunc(a / b) * b;
+        if (result.m_kind == Kind::Finite && result.m_negative != a.m_negative) result = result + (result.m_negative ? abs(b) : -abs(b));
+        return result;
+    }
+
+    friend MultiFloat sqrt(const MultiFloat& v) {
+        if (v.m_kind == Kind::Zero || v.m_kind == Kind::NaN) return v;
+        if (v.m_negative) return nan();
+        if (v.m_kind == Kind::Infinite) return v;
+        // v = s * 2^(2k) with s in [1/4, 1); y -> 1/sqrt(s) by Newton, then sqrt(s) = s*y, corrected once
+        const std::int64_t k = floorDiv(v.m_exponent + 1, 2);
+        const MultiFloat s = ldexp(v, -2 * k);
+        MultiFloat y = 1.0 / std::sqrt(s.toLongDouble());
+        for (int bits = 60; bits <= BITS; bits *= 2) y = y + ldexp(y * (MultiFloat(1) - s * y * y), -1);
+        MultiFloat root = s * y;
+        root = root + ldexp((s - root * root) * y, -1);
+        return ldexp(root, k);
+    }
+    friend MultiFloat cbrt(const MultiFloat& v) {
+        if (v.m_kind != Kind::Finite) return v;
+        // |v| = s * 2^(3k) with s in [1/8, 1); Newton on y^3 = s
+        const std::int64_t k = floorDiv(v.m_exponent + 2, 3);
+        const MultiFloat s = ldexp(abs(v), -3 * k);
+        MultiFloat y = std::cbrt(s.toLongDouble());
+        for (int bits = 60; bits <= BITS; bits *= 2) y = y - (y * y * y - s) / (MultiFloat(3) * y * y);
+        return withSign(ldexp(y, k), v.m_negative);
+    }
+    friend MultiFloat hypot(const MultiFloat& a, const MultiFloat& b) {
+        if (isinf(a) || isinf(b)) return infinity(false);
+        return sqrt(a * a + b * b);
+    }
+
+    friend MultiFloat exp(const MultiFloat& v) {
+        if (v.m_kind == Kind::NaN) return v;
+        if (v.m_kind == Kind::Zero) return MultiFloat(1);
+        if (v.m_kind == Kind::Infinite) return v.m_negative ? MultiFloat() : v;
+        if (v.m_exponent > 25) return v.m_negative ? MultiFloat() : infinity(false); // |v| >= 2^24
+        // v = k*ln2 + r with |r| <= ln2/2
+        const MultiFloat k = round(v / ln2());
+        return ldexp(expm1Reduced(v - k * ln2()) + MultiFloat(1), static_cast<std::int64_t>(k));
+    }
+    friend MultiFloat expm1(const MultiFloat& v) {
+        if (v.m_kind == Kind::Finite && v.m_exponent <= -1) return expm1Reduced(v); // |v| < 1/2
+        return exp(v) - MultiFloat(1);
+    }
+    friend MultiFloat log(const MultiFloat& v) {
+        if (v.m_kind == Kind::NaN) return v;
+        if (v.m_kind == Kind::Zero) return infinity(true);
+        if (v.m_negative) return nan();
+        if (v.m_kind == Kind::Infinite) return v;
+        // v = m * 2^e with m in [1/sqrt(2), sqrt(2)): log v = e*ln2 + 2*atanh((m - 1)/(m + 1))
+        std::int64_t e = v.m_exponent;
+        MultiFloat m = ldexp(v, -e);
+        if (m < MultiFloat(0.70710678118654752)) {
+            m = ldexp(m, 1);
+            --e;
+        }
+        return MultiFloat(e) * ln2() + ldexp(atanhSeries((m - MultiFloat(1)) / (m + MultiFloat(1))), 1);
+    }
+    friend MultiFloat log1p(const MultiFloat& v) {
+        if (v.m_kind == Kind::Finite && v.m_exponent <= -1) { // |v| < 1/2: 2*atanh(v/(2 + v)) keeps its digits
+            return ldexp(atanhSeries(v / (MultiFloat(2) + v)), 1);
+        }
+        return log(MultiFloat(1) + v);
+    }
+    friend MultiFloat log2(const MultiFloat& v) {
+        if (v.isPowerOfTwo()) return MultiFloat(v.m_exponent - 1); // Exact
+        return log(v) / ln2();
+    }
+    friend MultiFloat log10(const MultiFloat& v) { return log(v) / ln10(); }
+
+    // Integer powers below 2^32 by squaring, the rest as exp(b*log(a)), both with an extra limb
+    friend MultiFloat pow(const MultiFloat& a, const MultiFloat& b) {
+        if (b.m_kind == Kind::Zero || a == MultiFloat(1)) return MultiFloat(1);
+        if (isnan(a) || isnan(b)) return nan();
+        const bool integral = b.isInteger();
+        if (a.m_negative && !integral) return nan();
+        const bool odd = integral && b.m_exponent <= BITS && fmod(b, MultiFloat(2)) != MultiFloat();
+        const bool negative = a.m_negative && odd;
+        if (a.m_kind == Kind::Zero || isinf(a)) {
+            const bool large = (a.m_kind == Kind::Infinite) != b.m_negative;
+            return withSign(large ? infinity(false) : MultiFloat(), negative);
+        }
+        if (isinf(b)) {
+            const bool large = (abs(a) > MultiFloat(1)) != b.m_negative;
+            return large ? infinity(false) : MultiFloat();
+        }
+        using Wider = MultiFloat<Limbs + 1>;
+        const Wider base = Wider(abs(a));
+        Wider result;
+        if (integral && b.m_exponent <= 32) {
+            result = Wider(1);
+            Wider square = base;
+            for (std::uint64_t n = static_cast<std::uint64_t>(abs(b)); n > 0; n >>= 1) {
+                if (n & 1) result *= square;
+                if (n > 1) square *= square;
+            }
+            if (b.m_negative) result = Wider(1) / result;
+        } else {
+            result = exp(Wider(b) * log(base));
+        }
+        return withSign(MultiFloat(result), negative);
+    }
+
+    friend MultiFloat sin(const MultiFloat& v) { MultiFloat s, c; sinCos(v, s, c); return s; }
+    friend MultiFloat cos(const MultiFloat& v) { MultiFloat s, c; sinCos(v, s, c); return c; }
+    friend MultiFloat tan(const MultiFloat& v) { MultiFloat s, c; sinCos(v, s, c); return s / c; }
+
+    friend MultiFloat atan(const MultiFloat& v) {
+        if (v.m_kind == Kind::NaN || v.m_kind == Kind::Zero) return v;
+        if (v.m_kind == Kind::Infinite) return withSign(ldexp(pi(), -1), v.m_negative);
+        MultiFloat a = abs(v);
+        const bool inverted = a > MultiFloat(1);
+        if (inverted) a = MultiFloat(1) / a;
+        // atan(a) = 2*atan(a/(1 + sqrt(1 + a^2))) until the series converges quickly
+        int doublings = 0;
+        for (; a > MultiFloat(0.125); ++doublings) a = a / (MultiFloat(1) + sqrt(MultiFloat(1) + a * a));
+        MultiFloat result = ldexp(atanSeries(a), doublings);
+        if (inverted) result = ldexp(pi(), -1) - result;
+        return withSign(result, v.m_negative);
+    }
+    friend MultiFloat atan2(const MultiFloat& y, const MultiFloat& x) {
+        if (isnan(y) || isnan(x)) return nan();
+        if (x.m_kind == Kind::Zero) {
+            if (y.m_kind == Kind::Zero) return x.m_negative ? withSign(pi(), y.m_negative) : y;
+            return withSign(ldexp(pi(), -1), y.m_negative);
+        }
+        if (isinf(x) && isinf(y)) return withSign(ldexp(pi(), -2) * MultiFloat(x.m_negative ? 3 : 1), y.m_negative);
+        const MultiFloat base = atan(y / x);
+        if (!x.m_negative) return base;
+        return y.m_negative ? base - pi() : base + pi();
+    }
+    friend MultiFloat asin(const MultiFloat& v) {
+        if (abs(v) > MultiFloat(1)) return nan();
+        return atan2(v, sqrt((MultiFloat(1) - v) * (MultiFloat(1) + v)));
+    }
+    friend MultiFloat acos(const MultiFloat& v) {
+        if (abs(v) > MultiFloat(1)) return nan();
+        return atan2(sqrt((MultiFloat(1) - v) * (MultiFloat(1) + v)), v);
+    }
+
+    friend MultiFloat sinh(const MultiFloat& v) {
+        if (v.m_kind != Kind::Finite) return v;
+        if (v.m_exponent <= 0) { // |v| < 1: from expm1, without cancellation
+            const MultiFloat u = expm1(v);
+            return ldexp(u + u / (u + MultiFloat(1)), -1);
+        }
+        const MultiFloat e = exp(v);
+        return ldexp(e - MultiFloat(1) / e, -1);
+    }
+    friend MultiFloat cosh(const MultiFloat& v) {
+        if (isnan(v)) return v;
+        const MultiFloat e = exp(abs(v));
+        return ldexp(e + MultiFloat(1) / e, -1);
+    }
+    friend MultiFloat tanh(const MultiFloat& v) {
+        if (v.m_kind == Kind::NaN || v.m_kind == Kind::Zero) return v;
+        if (v.m_kind == Kind::Infinite || abs(v) > MultiFloat(BITS)) return withSign(MultiFloat(1), v.m_negative);
+        const MultiFloat u = expm1(ldexp(v, 1));
+        return u / (u + MultiFloat(2));
+    }
+    friend MultiFloat asinh(const MultiFloat& v) {
+        if (v.m_kind != Kind::Finite) return v;
+        const MultiFloat a = abs(v);
+        if (a.m_exponent > BITS) return withSign(log(a) + ln2(), v.m_negative);
+        const MultiFloat a2 = a * a;
+        return withSign(log1p(a + a2 / (MultiFloat(1) + sqrt(MultiFloat(1) + a2))), v.m_negative);
+    }
+    friend MultiFloat acosh(const MultiFloat& v) {
+        if (isnan(v) || v < MultiFloat(1)) return nan();
+        if (isinf(v)) return v;
+        if (v.m_exponent > BITS) return log(v) + ln2();
+        const MultiFloat t = v - MultiFloat(1);
+        return log1p(t + sqrt(t * (t + MultiFloat(2))));
+    }
+    friend MultiFloat atanh(const MultiFloat& v) {
+        if (isnan(v) || abs(v) > MultiFloat(1)) return nan();
+        if (abs(v) == MultiFloat(1)) return infinity(v.m_negative);
+        return ldexp(log1p(ldexp(v, 1) / (MultiFloat(1) - v)), -1);
+    }
+
+    friend MultiFloat erf(const MultiFloat& v) {
+        if (v.m_kind == Kind::NaN || v.m_kind == Kind::Zero) return v;
+        if (abs(v) >= erfcAsymptoticFrom()) return withSign(MultiFloat(1), v.m_negative); // 1 - erf(v) < ulp
+        return withSign(erfSeries(abs(v)), v.m_negative);
+    }
+    friend MultiFloat erfc(const MultiFloat& v) {
+        if (isnan(v)) return v;
+        if (v < MultiFloat(0.5)) return MultiFloat(1) - erf(v); // No cancellation below 1/2
+        if (v >= erfcAsymptoticFrom()) return erfcAsymptotic(v);
+        // 1 - erf(v) cancels up to BITS bits here, so erf is taken with twice the limbs
+        using Doubled = MultiFloat<2 * Limbs + 1>;
+        return MultiFloat(Doubled(1) - Doubled::erfSeries(Doubled(v)));
+    }
+
+    static MultiFloat infinity(bool negative) {
+        MultiFloat result;
+        result.m_kind = Kind::Infinite;
+        result.m_negative = negative;
+        return result;
+    }
+    static MultiFloat nan() {
+        MultiFloat result;
+        result.m_kind = Kind::NaN;
+        return result;
+    }
+    // The largest finite value below 2^MAX_EXPONENT
+    static MultiFloat largest() {
+        MultiFloat result;
+        result.m_limbs.fill(~Limb(0));
+        return result.withExponent(MAX_EXPONENT);
+    }
+
+    // Constants to full precision, computed once
+    static const MultiFloat& pi() {
+        // Machin: pi = 16*atan(1/5) - 4*atan(1/239)
+        static const MultiFloat value = ldexp(atanSeries(MultiFloat(1) / MultiFloat(5)), 4) - ldexp(atanSeries(MultiFloat(1) / MultiFloat(239)), 2);
+        return value;
+    }
+    static const MultiFloat& ln2() {
+        static const MultiFloat value = ldexp(atanhSeries(MultiFloat(1) / MultiFloat(3)), 1); // 2*atanh(1/3)
+        return value;
+    }
+    static const MultiFloat& ln10() {
+        static const MultiFloat value = log(MultiFloat(10));
+        return value;
+    }
+
+private:
+    template <std::size_t> friend class MultiFloat;
+
+    __extension__ typedef unsigned __int128 Wide;
+    enum class Kind : std::uint8_t { Zero, Finite, Infinite, NaN };
+
+    std::array<Limb, Limbs> m_limbs{}; // Significand, least significant limb first; top bit set when Finite
+    std::int64_t m_exponent = 0;       // |value| = significand / 2^BITS * 2^m_exponent, in [2^(e-1), 2^e)
+    bool m_negative = false;
+    Kind m_kind = Kind::Zero;
+
+    static std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+        return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+    }
+
+    static MultiFloat withSign(MultiFloat v, bool negative) {
+        v.m_negative = negative;
+        return v;
+    }
+
+    // Sets the exponent, turning the value into infinity or zero outside the range
+    MultiFloat& withExponent(std::int64_t exponent) {
+        if (exponent > MAX_EXPONENT) return *this = infinity(m_negative);
+        if (exponent < MIN_EXPONENT) return *this = withSign(MultiFloat(), m_negative);
+        m_exponent = exponent;
+        m_kind = Kind::Finite;
+        return *this;
+    }
+
+    bool isInteger() const { return m_kind == Kind::Zero || (m_kind == Kind::Finite && trunc(*this) == *this); }
+
+    bool isPowerOfTwo() const {
+        if (m_kind != Kind::Finite || m_negative || m_limbs[Limbs - 1] != (Limb(1) << 63)) return false;
+        return std::all_of(m_limbs.begin(), m_limbs.end() - 1, [](Limb limb) { return limb == 0; });
+    }
+
+    void assignInteger(bool negative, std::uint64_t magnitude) {
+        m_negative = negative;
+        if (magnitude == 0) return;
+        const int leadingZeros = __builtin_clzll(magnitude);
+        m_limbs[Limbs - 1] = magnitude << leadingZeros;
+        m_exponent = 64 - leadingZeros;
+        m_kind = Kind::Finite;
+    }
+
+    void assignFloating(long double value) {
+        m_negative = std::signbit(value);
+        if (std::isnan(value)) m_kind = Kind::NaN;
+        else if (std::isinf(value)) m_kind = Kind::Infinite;
+        else if (value != 0) {
+            int exponent = 0;
+            const long double fraction = std::frexp(std::fabs(value), &exponent); // In [1/2, 1)
+            // The 64-bit significand of an x87 long double fits one limb exactly
+            m_limbs[Limbs - 1] = static_cast<Limb>(std::ldexp(fraction, 64));
+            m_exponent = exponent;
+            m_kind = Kind::Finite;
+        }
+    }
+
+    long double toLongDouble() const {
+        switch (m_kind) {
+            case Kind::Zero: return m_negative ? -0.0L : 0.0L;
+            case Kind::Infinite: return m_negative ? -std::numeric_limits<long double>::infinity() : std::numeric_limits<long double>::infinity();
+            case Kind::NaN: return std::numeric_limits<long double>::quiet_NaN();
+            case Kind::Finite: break;
+        }
+        const int exponent = static_cast<int>(std::clamp<std::int64_t>(m_exponent, -20000, 20000));
+        const long double magnitude = std::ldexp(static_cast<long double>(m_limbs[Limbs - 1]), exponent - 64)
+                                    + std::ldexp(static_cast<long double>(m_limbs[Limbs - 2]), exponent - 128);
+        return m_negative ? -magnitude : magnitude;
+    }
+
+    // Rounds the N-limb significand m (value m / 2^(64N) * 2^exponent, any leading zeros) to nearest,
+    // ties to even
+    template <std::size_t N>
+    [[gnu::noinline]] static MultiFloat rounded(bool negative, std::int64_t exponent, std::array<Limb, N> m) {
+        static_assert(N > Limbs);
+        std::size_t top = N;
+        while (top > 0 && m[top - 1] == 0) --top;
+        if (top == 0) return withSign(MultiFloat(), negative);
+        const std::size_t shift = (N - top) * 64 + static_cast<std::size_t>(__builtin_clzll(m[top - 1]));
+        shiftLeft(std::span<Limb>(m), shift);
+        exponent -= static_cast<std::int64_t>(shift);
+
+        constexpr std::size_t low = N - Limbs; // Limbs below the result; m[low - 1] is the guard limb
+        const Limb guard = m[low - 1];
+        const bool sticky = std::any_of(m.begin(), m.begin() + (low - 1), [](Limb limb) { return limb != 0; });
+        const Limb half = Limb(1) << 63;
+        bool carry = guard > half || (guard == half && (sticky || (m[low] & 1)));
+
+        MultiFloat result;
+        result.m_negative = negative;
+        for (std::size_t i = 0; i < Limbs; ++i) {
+            result.m_limbs[i] = m[low + i] + (carry ? 1 : 0);
+            carry = carry && result.m_limbs[i] == 0;
+        }
+        if (carry) { // Rounded up to the next power of two
+            result.m_limbs[Limbs - 1] = half;
+            ++exponent;
+        }
+        return result.withExponent(exponent);
+    }
+
+    static void shiftLeft(std::span<Limb> m, std::size_t shift) {
+        const std::size_t limbs = shift / 64, bits = shift % 64;
+        for (std::size_t i = m.size(); i-- > 0;) {
+            const Limb high = i >= limbs ? m[i - limbs] : 0;
+            const Limb low = i >= limbs + 1 ? m[i - limbs - 1] : 0;
+            m[i] = bits == 0 ? high : (high << bits) | (low >> (64 - bits));
+        }
+    }
+
+    // Shifts right, folding every bit shifted out into the lowest bit (sticky) so rounding still sees it
+    static void shiftRightSticky(std::span<Limb> m, std::size_t shift) {
+        bool lost = false;
+        for (std::size_t i = 0; i < m.size() && i * 64 < shift; ++i) {
+            const std::size_t bits = shift - i * 64;
+            lost = lost || (bits >= 64 ? m[i] != 0 : (m[i] & ((Limb(1) << bits) - 1)) != 0);
+        }
+        const std::size_t limbs = shift / 64, bits = shift % 64;
+        for (std::size_t i = 0; i < m.size(); ++i) {
+            const Limb low = i + limbs < m.size() ? m[i + limbs] : 0;
+            const Limb high = i + limbs + 1 < m.size() ? m[i + limbs + 1] : 0;
+            m[i] = bits == 0 ? low : (low >> bits) | (high << (64 - bits));
+        }
+        if (lost) m[0] |= 1;
+    }
+
+    // -1, 0 or 1 as |a| is below, equal to or above |b|, for finite non-zero values
+    static int compareMagnitude(const MultiFloat& a, const MultiFloat& b) {
+        if (a.m_exponent != b.m_exponent) return a.m_exponent < b.m_exponent ? -1 : 1;
+        for (std::size_t i = Limbs; i-- > 0;) {
+            if (a.m_limbs[i] != b.m_limbs[i]) return a.m_limbs[i] < b.m_limbs[i] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    // -1, 0 or 1 as a is below, equal to or above b; 2 if either is NaN
+    [[gnu::noinline]] static int compare(const MultiFloat& a, const MultiFloat& b) {
+        if (a.m_kind == Kind::NaN || b.m_kind == Kind::NaN) return 2;
+        if (a.m_kind == Kind::Zero && b.m_kind == Kind::Zero) return 0;
+        if (a.m_kind == Kind::Zero) return b.m_negative ? 1 : -1;
+        if (b.m_kind == Kind::Zero) return a.m_negative ? -1 : 1;
+        if (a.m_negative != b.m_negative) return a.m_negative ? -1 : 1;
+        int magnitude = 0;
+        if (a.m_kind == Kind::Infinite || b.m_kind == Kind::Infinite) {
+            magnitude = (a.m_kind == b.m_kind) ? 0 : (a.m_kind == Kind::Infinite ? 1 : -1);
+        } else {
+            magnitude = compareMagnitude(a, b);
+        }
+        return a.m_negative ? -magnitude : magnitude;
+    }
+
+    // a + b, with b's sign taken as bNegative
+    [[gnu::noinline]] static MultiFloat add(const MultiFloat& a, const MultiFloat& b, bool bNegative) {
+        if (a.m_kind == Kind::NaN || b.m_kind == Kind::NaN) return nan();
+        if (a.m_kind == Kind::Infinite) return (b.m_kind == Kind::Infinite && a.m_negative != bNegative) ? nan() : a;
+        if (b.m_kind == Kind::Infinite) return infinity(bNegative);
+        if (b.m_kind == Kind::Zero) return a;
+        if (a.m_kind == Kind::Zero) return withSign(b, bNegative);
+
+        const bool swapped = compareMagnitude(a, b) < 0;
+        const MultiFloat& large = swapped ? b : a;
+        const MultiFloat& small = swapped ? a : b;
+        const bool largeNegative = swapped ? bNegative : a.m_negative;
+        const bool smallNegative = swapped ? a.m_negative : bNegative;
+        const std::int64_t shift = large.m_exponent - small.m_exponent;
+        if (shift > BITS + 64) return withSign(large, largeNegative);
+
+        // One guard limb below both significands; small is aligned to large's exponent
+        std::array<Limb, Limbs + 2> x{}, y{};
+        std::copy(large.m_limbs.begin(), large.m_limbs.end(), x.begin() + 1);
+        std::copy(small.m_limbs.begin(), small.m_limbs.end(), y.begin() + 1);
+        shiftRightSticky(std::span<Limb>(y), static_cast<std::size_t>(shift));
+        if (largeNegative == smallNegative) {
+            Limb carry = 0;
+            for (std::size_t i = 0; i < x.size(); ++i) {
+                const Wide sum = Wide(x[i]) + y[i] + carry;
+                x[i] = static_cast<Limb>(sum);
+                carry = static_cast<Limb>(sum >> 64);
+            }
+        } else { // |large| >= |small|, so no borrow out of the top
+            Limb borrow = 0;
+            for (std::size_t i = 0; i < x.size(); ++i) {
+                const Limb difference = x[i] - y[i] - borrow;
+                borrow = (x[i] < y[i] || x[i] - y[i] < borrow) ? 1 : 0;
+                x[i] = difference;
+            }
+        }
+        // x holds the result over 2^(64 * (Limbs + 1)), with room for a carry in its top limb
+        return rounded(largeNegative, large.m_exponent + 64, x);
+    }
+
+    [[gnu::noinline]] static MultiFloat multiply(const MultiFloat& a, const MultiFloat& b) {
+        const bool negative = a.m_negative != b.m_negative;
+        if (a.m_kind == Kind::NaN || b.m_kind == Kind::NaN) return nan();
+        if (a.m_kind == Kind::Infinite || b.m_kind == Kind::Infinite) {
+            return (a.m_kind == Kind::Zero || b.m_kind == Kind::Zero) ? nan() : infinity(negative);
+        }
+        if (a.m_kind == Kind::Zero || b.m_kind == Kind::Zero) return withSign(MultiFloat(), negative);
+        std::array<Limb, 2 * Limbs> product{};
+        if constexpr (Limbs >= KARATSUBA_THRESHOLD) karatsuba(a.m_limbs.data(), b.m_limbs.data(), Limbs, product.data());
+        else schoolbook(a.m_limbs.data(), b.m_limbs.data(), Limbs, product.data());
+        return rounded(negative, a.m_exponent + b.m_exponent, product);
+    }
+
+    // out[0, 2n) = a[0, n) * b[0, n)
+    static void schoolbook(const Limb* a, const Limb* b, std::size_t n, Limb* out) {
+        std::fill(out, out + 2 * n, Limb(0));
+        for (std::size_t i = 0; i < n; ++i) {
+            Limb carry = 0;
+            for (std::size_t j = 0; j < n; ++j) {
+                const Wide current = Wide(a[i]) * b[j] + out[i + j] + carry;
+                out[i + j] = static_cast<Limb>(current);
+                carry = static_cast<Limb>(current >> 64);
+            }
+            out[i + n] = carry;
+        }
+    }
+
+    // out[0, 2n) = a[0, n) * b[0, n) with three half-size products:
+    // a = a1*B^m + a0, b = b1*B^m + b0, z1 = (a0 + a1)(b0 + b1) - a0*b0 - a1*b1
+    static void karatsuba(const Limb* a, const Limb* b, std::size_t n, Limb* out) {
+        if (n < KARATSUBA_THRESHOLD) {
+            schoolbook(a, b, n, out);
+            return;
+        }
+        const std::size_t m = n / 2, high = n - m;
+        std::vector<Limb> a0(high, 0), b0(high, 0);
+        std::copy(a, a + m, a0.begin());
+        std::copy(b, b + m, b0.begin());
+        std::vector<Limb> z0(2 * high), z2(2 * high);
+        karatsuba(a0.data(), b0.data(), high, z0.data()); // a0, b0 zero-padded to high limbs
+        karatsuba(a + m, b + m, high, z2.data());
+
+        std::vector<Limb> sa(high + 1, 0), sb(high + 1, 0);
+        sa[high] = addInto(std::span<Limb>(sa.data(), high), std::span<const Limb>(a + m, high), std::span<const Limb>(a0));
+        sb[high] = addInto(std::span<Limb>(sb.data(), high), std::span<const Limb>(b + m, high), std::span<const Limb>(b0));
+        std::vector<Limb> z1(2 * high + 2);
+        karatsuba(sa.data(), sb.data(), high + 1, z1.data());
+        subtractFrom(std::span<Limb>(z1), std::span<const Limb>(z0));
+        subtractFrom(std::span<Limb>(z1), std::span<const Limb>(z2));
+
+        std::fill(out, out + 2 * n, Limb(0));
+        std::copy(z0.begin(), z0.begin() + 2 * m, out);
+        std::copy(z2.begin(), z2.begin() + 2 * (n - m), out + 2 * m);
+        addAt(std::span<Limb>(out, 2 * n), std::span<const Limb>(z1), m);
+    }
+
+    // out = a + b (all the same length); returns the carry
+    static Limb addInto(std::span<Limb> out, std::span<const Limb> a, std::span<const Limb> b) {
+        Limb carry = 0;
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            const Wide sum = Wide(a[i]) + b[i] + carry;
+            out[i] = static_cast<Limb>(sum);
+            carry = static_cast<Limb>(sum >> 64);
+        }
+        return carry;
+    }
+
+    // target -= subtrahend, which must not exceed it
+    static void subtractFrom(std::span<Limb> target, std::span<const Limb> subtrahend) {
+        Limb borrow = 0;
+        for (std::size_t i = 0; i < target.size() && (i < subtrahend.size() || borrow); ++i) {
+            const Limb take = i < subtrahend.size() ? subtrahend[i] : 0;
+            const Limb difference = target[i] - take - borrow;
+            borrow = (target[i] < take || target[i] - take < borrow) ? 1 : 0;
+            target[i] = difference;
+        }
+    }
+
+    // target += addend * 2^(64*offset), dropping any carry out of target (the product fits)
+    static void addAt(std::span<Limb> target, std::span<const Limb> addend, std::size_t offset) {
+        Limb carry = 0;
+        for (std::size_t i = 0; offset + i < target.size() && (i < addend.size() || carry); ++i) {
+            const Wide sum = Wide(target[offset + i]) + (i < addend.size() ? addend[i] : 0) + carry;
+            target[offset + i] = static_cast<Limb>(sum);
+            carry = static_cast<Limb>(sum >> 64);
+        }
+    }
+
+    // Quotient of the significands by Knuth's algorithm D (TAOCP 4.3.1), with a sticky bit for the
+    // remainder. The divisor is already normalized (top bit set).
+    [[gnu::noinline]] static MultiFloat divide(const MultiFloat& a, const MultiFloat& b) {
+        const bool negative = a.m_negative != b.m_negative;
+        if (a.m_kind == Kind::NaN || b.m_kind == Kind::NaN) return nan();
+        if (a.m_kind == Kind::Infinite) return b.m_kind == Kind::Infinite ? nan() : infinity(negative);
+        if (b.m_kind == Kind::Infinite) return withSign(MultiFloat(), negative);
+        if (b.m_kind == Kind::Zero) return a.m_kind == Kind::Zero ? nan() : infinity(negative);
+        if (a.m_kind == Kind::Zero) return withSign(MultiFloat(), negative);
+
+        // u = A * 2^(64 * (Limbs + 1)): Limbs + 2 quotient limbs, the top one 0 or 1
+        constexpr std::size_t n = Limbs, m = Limbs + 1;
+        std::array<Limb, m + n + 1> u{};
+        std::copy(a.m_limbs.begin(), a.m_limbs.end(), u.begin() + m);
+        const Limb* v = b.m_limbs.data();
+        std::array<Limb, m + 1> q{};
+        for (std::size_t j = m + 1; j-- > 0;) {
+            const Wide numerator = (Wide(u[j + n]) << 64) | u[j + n - 1];
+            Wide qhat = numerator / v[n - 1];
+            Wide rhat = numerator % v[n - 1];
+            while ((qhat >> 64) != 0 || qhat * v[n - 2] > ((rhat << 64) | u[j + n - 2])) {
+                --qhat;
+                rhat += v[n - 1];
+                if ((rhat >> 64) != 0) break;
+            }
+            // u[j, j + n] -= qhat * v
+            Limb productCarry = 0, borrow = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const Wide product = qhat * v[i] + productCarry;
+                productCarry = static_cast<Limb>(product >> 64);
+                const Limb take = static_cast<Limb>(product);
+                const Limb difference = u[i + j] - take - borrow;
+                borrow = (u[i + j] < take || u[i + j] - take < borrow) ? 1 : 0;
+                u[i + j] = difference;
+            }
+            const Limb top = u[j + n];
+            u[j + n] = top - productCarry - borrow;
+            q[j] = static_cast<Limb>(qhat);
+            if (top < productCarry || top - productCarry < borrow) { // qhat was one too large: add v back
+                --q[j];
+                Limb carry = 0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    const Wide sum = Wide(u[i + j]) + v[i] + carry;
+                    u[i + j] = static_cast<Limb>(sum);
+                    carry = static_cast<Limb>(sum >> 64);
+                }
+                u[j + n] += carry;
+            }
+        }
+        if (std::any_of(u.begin(), u.begin() + n, [](Limb limb) { return limb != 0; })) q[0] |= 1;
+        // q / 2^(64 * (Limbs + 2)) = A / B / 2^64
+        return rounded(negative, a.m_exponent - b.m_exponent + 64, q);
+    }
+
+    // v / d for a small positive integer d, exact before rounding and much cheaper than divide()
+    [[gnu::noinline]] MultiFloat dividedBy(Limb d) const {
+        if (m_kind != Kind::Finite) return *this;
+        std::array<Limb, Limbs + 2> x{};
+        std::copy(m_limbs.begin(), m_limbs.end(), x.begin() + 2);
+        Limb remainder = 0;
+        for (std::size_t i = x.size(); i-- > 0;) {
+            const Wide current = (Wide(remainder) << 64) | x[i];
+            x[i] = static_cast<Limb>(current / d);
+            remainder = static_cast<Limb>(current % d);
+        }
+        if (remainder != 0) x[0] |= 1;
+        return rounded(m_negative, m_exponent, x);
+    }
+
+    // Whether term no longer changes sum
+    static bool negligible(const MultiFloat& term, const MultiFloat& sum) {
+        return term.m_kind == Kind::Zero || (sum.m_kind == Kind::Finite && term.m_exponent < sum.m_exponent - BITS - 1);
+    }
+
+    // atanh(z) = z + z^3/3 + z^5/5 + ..., for |z| well below 1
+    static MultiFloat atanhSeries(const MultiFloat& z) {
+        const MultiFloat z2 = z * z;
+        MultiFloat power = z, sum = z;
+        for (Limb k = 3;; k += 2) {
+            power *= z2;
+            const MultiFloat term = power.dividedBy(k);
+            if (negligible(term, sum)) break;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // atan(z) = z - z^3/3 + z^5/5 - ..., for |z| well below 1
+    static MultiFloat atanSeries(const MultiFloat& z) {
+        const MultiFloat z2 = -(z * z);
+        MultiFloat power = z, sum = z;
+        for (Limb k = 3;; k += 2) {
+            power *= z2;
+            const MultiFloat term = power.dividedBy(k);
+            if (negligible(term, sum)) break;
+            sum += term;
+        }
+        return sum;
+    }
+
+    // exp(r) - 1 for |r| <= 1/2: the Taylor series of r / 2^s, then s steps of
+    // expm1(2t) = expm1(t) * (expm1(t) + 2), which keep the relative error small
+    static MultiFloat expm1Reduced(const MultiFloat& r) {
+        if (r.m_kind != Kind::Finite) return r;
+        constexpr int halvings = 4 + static_cast<int>(Limbs) * 3 / 2;
+        const std::int64_t s = std::clamp<std::int64_t>(halvings + r.m_exponent, 0, halvings); // Small r needs fewer
+        const MultiFloat t = ldexp(r, -s);
+        MultiFloat term = t, sum = t;
+        for (Limb n = 2;; ++n) {
+            term = (term * t).dividedBy(n);
+            if (negligible(term, sum)) break;
+            sum += term;
+        }
+        for (std::int64_t i = 0; i < s; ++i) sum = sum * (sum + MultiFloat(2));
+        return sum;
+    }
+
+    // sin and cos of v; the quadrant is found with an extra limb, so arguments up to ~2^64 keep
+    // their digits
+    static void sinCos(const MultiFloat& v, MultiFloat& sine, MultiFloat& cosine) {
+        if (v.m_kind == Kind::NaN || v.m_kind == Kind::Infinite) {
+            sine = cosine = nan();
+            return;
+        }
+        if (v.m_kind == Kind::Zero) {
+            sine = v;
+            cosine = MultiFloat(1);
+            return;
+        }
+        using Wider = MultiFloat<Limbs + 1>;
+        const Wider halfPi = ldexp(Wider::pi(), -1);
+        const Wider wide = Wider(v);
+        const Wider quadrants = round(wide / halfPi);
+        const MultiFloat r = MultiFloat(wide - quadrants * halfPi); // |r| <= pi/4
+        const int quadrant = static_cast<int>(static_cast<long long>(fmod(quadrants, Wider(4))) & 3);
+
+        const MultiFloat r2 = r * r;
+        MultiFloat sinTerm = r, sinSum = r, cosTerm = MultiFloat(1), cosSum = MultiFloat(1);
+        for (Limb n = 1;; ++n) {
+            sinTerm = -(sinTerm * r2).dividedBy((2 * n) * (2 * n + 1));
+            cosTerm = -(cosTerm * r2).dividedBy((2 * n - 1) * (2 * n));
+            const bool sinDone = negligible(sinTerm, sinSum), cosDone = negligible(cosTerm, cosSum);
+            if (!sinDone) sinSum += sinTerm;
+            if (!cosDone) cosSum += cosTerm;
+            if (sinDone && cosDone) break;
+        }
+        switch (quadrant) {
+            case 0: sine = sinSum; cosine = cosSum; break;
+            case 1: sine = cosSum; cosine = -sinSum; break;
+            case 2: sine = -sinSum; cosine = -cosSum; break;
+            default: sine = -cosSum; cosine = sinSum; break;
+        }
+    }
+
+    // erf(x) for x >= 0 as 2/sqrt(pi) * exp(-x^2) * sum 2^n x^(2n+1) / (1*3*...*(2n+1)), whose terms
+    // are all positive
+    static MultiFloat erfSeries(const MultiFloat& x) {
+        const MultiFloat twoX2 = ldexp(x * x, 1);
+        MultiFloat term = x, sum = x;
+        for (Limb k = 3;; k += 2) {
+            term = (term * twoX2).dividedBy(k);
+            if (MultiFloat(k) > twoX2 && negligible(term, sum)) break; // Past the largest term
+            sum += term;
+        }
+        static const MultiFloat twoOverSqrtPi = MultiFloat(2) / sqrt(pi());
+        return sum * exp(-(x * x)) * twoOverSqrtPi;
+    }
+
+    // Where the asymptotic series of erfc reaches full precision: x^2 >= (BITS + 16) * ln 2
+    static const MultiFloat& erfcAsymptoticFrom() {
+        static const MultiFloat value = sqrt(MultiFloat(BITS + 16) * ln2());
+        return value;
+    }
+
+    // erfc(x) = exp(-x^2) / (x sqrt(pi)) * (1 - 1/(2x^2) + 1*3/(2x^2)^2 - ...), for large x
+    static MultiFloat erfcAsymptotic(const MultiFloat& x) {
+        const MultiFloat inverse = MultiFloat(1) / ldexp(x * x, 1);
+        MultiFloat term = MultiFloat(1), sum = MultiFloat(1);
+        for (Limb n = 1;; ++n) {
+            const MultiFloat next = -(term * inverse * MultiFloat(2 * n - 1));
+            if (abs(next) >= abs(term) || negligible(next, sum)) break; // Smallest term reached
+            term = next;
+            sum += term;
+        }
+        return sum * exp(-(x * x)) / (x * sqrt(pi()));
+    }
+
+    // The decimal digits of the integer value 0 < v < 2^BITS
+    static std::string integerDigits(const MultiFloat& v) {
+        if (v.m_kind != Kind::Finite) return "0";
+        std::array<Limb, Limbs> n = v.m_limbs;
+        shiftRightSticky(std::span<Limb>(n), static_cast<std::size_t>(BITS - v.m_exponent)); // Integers have no bits to lose
+        // Peel off 19 digits at a time, least significant first
+        constexpr Limb CHUNK = 10000000000000000000ULL;
+        std::string digits;
+        while (std::any_of(n.begin(), n.end(), [](Limb limb) { return limb != 0; })) {
+            Limb remainder = 0;
+            for (std::size_t i = Limbs; i-- > 0;) {
+                const Wide current = (Wide(remainder) << 64) | n[i];
+                n[i] = static_cast<Limb>(current / CHUNK);
+                remainder = static_cast<Limb>(current % CHUNK);
+            }
+            for (int d = 0; d < 19; ++d, remainder /= 10) digits.push_back(static_cast<char>('0' + remainder % 10));
+        }
+        while (digits.size() > 1 && digits.back() == '0') digits.pop_back(); // Padding of the last chunk
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+    // 10^n, exact while it fits the significand
+    static MultiFloat powerOfTen(std::int64_t n) {
+        MultiFloat result(1), square(10);
+        for (std::uint64_t e = static_cast<std::uint64_t>(n < 0 ? -n : n); e > 0; e >>= 1) {
+            if (e & 1) result *= square;
+            if (e > 1) square *= square;
+        }
+        return n < 0 ? MultiFloat(1) / result : result;
+    }
+};
+
+template <std::size_t Limbs>
+std::string MultiFloat<Limbs>::toString(int digits) const {
+    if (m_kind == Kind::NaN) return "nan";
+    if (m_kind == Kind::Infinite) return m_negative ? "-inf" : "inf";
+    if (m_kind == Kind::Zero) return m_negative ? "-0" : "0";
+    digits = std::clamp(digits, 1, MAX_DIGITS);
+
+    // |v| ~ n * 10^(k - digits + 1) with n an integer of exactly `digits` digits; k starts as an
+    // estimate of floor(log10 |v|) that may be one off
+    const MultiFloat magnitude = abs(*this);
+    std::int64_t k = static_cast<std::int64_t>(std::floor(static_cast<double>(m_exponent - 1) * 0.30102999566398120));
+    MultiFloat n;
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        const std::int64_t scale = digits - 1 - k;
+        n = round(scale >= 0 ? magnitude * powerOfTen(scale) : magnitude / powerOfTen(-scale));
+        if (n >= powerOfTen(digits)) ++k; // Also when rounding carried into a new digit
+        else if (n < powerOfTen(digits - 1)) --k;
+        else break;
+    }
+    std::string decimal = integerDigits(n);
+    decimal.resize(static_cast<std::size_t>(digits), '0');
+    while (decimal.size() > 1 && decimal.back() == '0') decimal.pop_back(); // %g drops trailing zeros
+
+    std::string result = m_negative ? "-" : "";
+    if (k < -4 || k >= digits) { // Scientific
+        result += decimal[0];
+        if (decimal.size() > 1) result += "." + decimal.substr(1);
+        const std::string power = std::to_string(k < 0 ? -k : k);
+        result += std::string(k < 0 ? "e-" : "e+") + (power.size() < 2 ? "0" : "") + power;
+    } else if (k < 0) {
+        result += "0." + std::string(static_cast<std::size_t>(-k - 1), '0') + decimal;
+    } else {
+        const std::size_t integerLength = static_cast<std::size_t>(k) + 1;
+        if (decimal.size() <= integerLength) result += decimal + std::string(integerLength - decimal.size(), '0');
+        else result += decimal.substr(0, integerLength) + "." + decimal.substr(integerLength);
+    }
+    return result;
+}
+
+namespace std {
+template <std::size_t Limbs>
+class numeric_limits<MultiFloat<Limbs>> {
+    using T = MultiFloat<Limbs>;
+
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = false;
+    static constexpr bool is_iec559 = false;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int radix = 2;
+    static constexpr int digits = T::BITS;
+    static constexpr int digits10 = T::DIGITS;
+    static constexpr int max_digits10 = T::MAX_DIGITS;
+    static constexpr int min_exponent = static_cast<int>(T::MIN_EXPONENT);
+    static constexpr int max_exponent = static_cast<int>(T::MAX_EXPONENT);
+    static constexpr int min_exponent10 = static_cast<int>(T::MIN_EXPONENT * 0.30102999566398120);
+    static constexpr int max_exponent10 = static_cast<int>(T::MAX_EXPONENT * 0.30102999566398120);
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+
+    static T min() { return ldexp(T(1), T::MIN_EXPONENT - 1); }
+    static T max() { return T::largest(); }
+    static T lowest() { return -T::largest(); }
+    static T epsilon() { return ldexp(T(1), 1 - T::BITS); }
+    static T round_error() { return T(0.5); }
+    static T infinity() { return T::infinity(false); }
+    static T quiet_NaN() { return T::nan(); }
+    static T signaling_NaN() { return T::nan(); }
+    static T denorm_min() { return min(); }
+};
+}
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "factorial.hpp"     // primesUpTo() for the sieving primes
+#include "integer_gcd.hpp"   // UInt128, binaryGcd()
+#include "parallel_for.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+// Number theory on 64-bit integers: primality by deterministic Miller-Rabin, factorization by
+// Pollard-Brent rho, prime counting by Lucy_Hedgehog's O(n^(3/4)) recursion on the values floor(n/k),
+// and a segmented sieve of Eratosthenes for ranges of primes. The sieve stores the 8 numbers of each
+// block of 30 that are coprime to 30 as the bits of one byte (a 2-3-5 wheel, 3.75x less memory and
+// work than a plain bit sieve), works through segments sized for the L2 cache, and hands chunks of
+// consecutive segments to separate threads. Prime counts up to 10^12 take seconds and two arrays of
+// sqrt(n) integers rather than a sieve of n bits.
+
+namespace number_theory_detail {
+    constexpr std::array<std::uint64_t, 8> WHEEL = {1, 7, 11, 13, 17, 19, 23, 29}; // Residues mod 30 coprime to 30
+
+    // Bit of residue r mod 30 in a sieve byte; only defined for the residues of WHEEL
+    constexpr std::array<std::uint8_t, 30> WHEEL_BIT = [] {
+        std::array<std::uint8_t, 30> bits{};
+        for (std::uint8_t j = 0; j < WHEEL.size(); ++j) bits[WHEEL[j]] = j;
+        return bits;
+    }();
+
+    // floor(sqrt(n)), exactly
+    inline std::uint64_t integerSqrt(std::uint64_t n) {
+        auto root = static_cast<std::uint64_t>(std::sqrt(static_cast<long double>(n)));
+        while (root > 0 && (root > UINT32_MAX || root * root > n)) --root;
+        while (root < UINT32_MAX && (root + 1) * (root + 1) <= n) ++root;
+        return root;
+    }
+
+    // Arithmetic modulo an odd n in Montgomery form (x * 2^64 mod n), where a product costs two
+    // multiplications and no division
+    class Montgomery {
+    public:
+        explicit Montgomery(std::uint64_t n) : m_n(n) {
+            m_inverse = n; // n^-1 mod 2^64: right to 3 bits, and each Newton step doubles that
+            for (int step = 0; step < 5; ++step) m_inverse *= 2 - n * m_inverse;
+            const std::uint64_t r = (0 - n) % n; // 2^64 mod n
+            m_rSquared = static_cast<std::uint64_t>(static_cast<UInt128>(r) * r % n);
+        }
+
+        std::uint64_t toForm(std::uint64_t x) const { return multiply(x % m_n, m_rSquared); }
+        std::uint64_t one() const { return toForm(1); }
+
+        // (t / 2^64) mod n for t < n * 2^64: t - m n with m = t n^-1 mod 2^64 has zero low half
+        std::uint64_t reduce(UInt128 t) const {
+            const std::uint64_t m = static_cast<std::uint64_t>(t) * m_inverse;
+            const std::uint64_t high = static_cast<std::uint64_t>(t >> 64);
+            const std::uint64_t mn = static_cast<std::uint64_t>((static_cast<UInt128>(m) * m_n) >> 64);
+            return high >= mn ? high - mn : high - mn + m_n;
+        }
+
+        std::uint64_t multiply(std::uint64_t a, std::uint64_t b) const { return reduce(static_cast<UInt128>(a) * b); }
+        std::uint64_t add(std::uint64_t a, std::uint64_t b) const { return a >= m_n - b ? a - (m_n - b) : a + b; }
+
+        std::uint64_t power(std::uint64_t base, std::uint64_t exponent) const {
+            std::uint64_t result = one();
+            for (; exponent > 0; exponent >>= 1) {
+                if (exponent & 1) result = multiply(result, base);
+                base = multiply(base, base);
+            }
+            return result;
+        }
+
+    private:
+        std::uint64_t m_n, m_inverse = 0, m_rSquared = 0;
+    };
+
+    // A factor of the odd composite n, possibly n itself, by Brent's variant of Pollard's rho with
+    // the polynomial x^2 + c: differences are multiplied together and only every BATCH steps is a
+    // GCD taken, backtracking one step at a time if the batch overshot to n
+    inline std::uint64_t pollardBrent(std::uint64_t n, std::uint64_t c) {
+        static constexpr std::uint64_t BATCH = 128;
+        const Montgomery mont(n);
+        const std::uint64_t increment = mont.toForm(c);
+        const auto step = [&](std::uint64_t v) { return mont.add(mont.multiply(v, v), increment); };
+        const auto distance = [](std::uint64_t a, std::uint64_t b) { return a > b ? a - b : b - a; };
+
+        std::uint64_t y = mont.toForm(2), x = y, saved = y, product = mont.one(), divisor = 1;
+        for (std::uint64_t length = 1; divisor == 1; length *= 2) {
+            x = y;
+            for (std::uint64_t i = 0; i < length; ++i) y = step(y);
+            for (std::uint64_t done = 0; done < length && divisor == 1; done += BATCH) {
+                saved = y;
+                for (std::uint64_t i = 0; i < std::min(BATCH, length - done); ++i) {
+                    y = step(y);
+                    product = mont.multiply(product, distance(x, y));
+                }
+                divisor = binaryGcd(product, n); // product is a multiple of the differences times 2^64, coprime to n
+            }
+        }
+        if (divisor == n) {
+            do {
+                saved = step(saved);
+                divisor = binaryGcd(distance(x, saved), n);
+            } while (divisor == 1);
+        }
+        return divisor;
+    }
+
+    inline void collectFactors(std::uint64_t n, std::vector<std::uint64_t>& factors);
+}
+
+// Deterministic for every 64-bit n: trial division by the primes up to 37, then Miller-Rabin with
+// the seven bases Jim Sinclair found to have no common strong pseudoprime below 2^64
+inline bool isPrime(std::uint64_t n) {
+    static constexpr std::array<std::uint64_t, 12> SMALL_PRIMES = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    static constexpr std::array<std::uint64_t, 7> BASES = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+    if (n < 2) return false;
+    for (const std::uint64_t p : SMALL_PRIMES) {
+        if (n % p == 0) return n == p;
+    }
+    if (n < 37 * 37) return true;
+
+    const number_theory_detail::Montgomery mont(n);
+    const int twos = __builtin_ctzll(n - 1);
+    const std::uint64_t odd = (n - 1) >> twos;
+    const std::uint64_t one = mont.one(), minusOne = mont.toForm(n - 1);
+    for (const std::uint64_t base : BASES) {
+        if (base % n == 0) continue;
+        std::uint64_t x = mont.power(mont.toForm(base), odd);
+        if (x == one || x == minusOne) continue;
+        bool witness = true;
+        for (int i = 1; i < twos && witness; ++i) {
+            x = mont.multiply(x, x);
+            witness = x != minusOne;
+        }
+        if (witness) return false;
+    }
+    return true;
+}
+
+struct PrimePower {
+    std::uint64_t prime;
+    int exponent;
+};
+
+// Prime factorization of n >= 1 in increasing order of the primes (empty for 1): trial division by
+// the primes below 1000, then Pollard-Brent on what is left until every part is prime
+inline std::vector<PrimePower> factorize(std::uint64_t n) {
+    static constexpr std::uint32_t TRIAL_LIMIT = 1000;
+    static const std::vector<std::uint32_t> trialPrimes = factorial_detail::primesUpTo(TRIAL_LIMIT);
+    std::vector<std::uint64_t> factors;
+    for (const std::uint32_t p : trialPrimes) {
+        if (static_cast<std::uint64_t>(p) * p > n) break;
+        for (; n % p == 0; n /= p) factors.push_back(p);
+    }
+    if (n > 1) number_theory_detail::collectFactors(n, factors);
+    std::sort(factors.begin(), factors.end());
+
+    std::vector<PrimePower> result;
+    for (const std::uint64_t factor : factors) {
+        if (!result.empty() && result.back().prime == factor) ++result.back().exponent;
+        else result.push_back({factor, 1});
+    }
+    return result;
+}
+
+// Appends the prime factors of n > 1, which has no factor below 1000
+inline void number_theory_detail::collectFactors(std::uint64_t n, std::vector<std::uint64_t>& factors) {
+    if (isPrime(n)) {
+        factors.push_back(n);
+        return;
+    }
+    std::uint64_t divisor = n;
+    for (std::uint64_t c = 1; divisor == n; ++c) divisor = pollardBrent(n, c);
+    collectFactors(divisor, factors);
+    collectFactors(n / divisor, factors);
+}
+
+// pi(n), the number of primes <= n, by Lucy_Hedgehog's method: S(v) starts as the count of 2..v and
+// each prime p <= sqrt(n) removes the numbers whose least prime factor is p, S(v) -= S(v / p) - S(p - 1),
+// for the O(sqrt(n)) distinct values v = floor(n / k). O(n^(3/4)) time and O(sqrt(n)) memory.
+inline std::uint64_t countPrimes(std::uint64_t n) {
+    if (n < 2) return 0;
+    const std::uint64_t root = number_theory_detail::integerSqrt(n);
+    std::vector<std::uint64_t> small(root + 1), large(root + 1); // S(v) for v <= root; S(n / k) for k <= root
+    for (std::uint64_t v = 1; v <= root; ++v) {
+        small[v] = v - 1;
+        large[v] = n / v - 1;
+    }
+    for (std::uint64_t p = 2; p <= root; ++p) {
+        if (small[p] == small[p - 1]) continue; // Not prime
+        const std::uint64_t below = small[p - 1], square = p * p;
+        // Large values first, in increasing k, so that S(n / (k p)) is still the previous round's
+        const std::uint64_t kLimit = std::min(root, n / square);
+        const std::uint64_t kDirect = std::min(kLimit, root / p); // k p <= root: S(n / (k p)) is in large
+        for (std::uint64_t k = 1; k <= kDirect; ++k) large[k] -= large[k * p] - below;
+        for (std::uint64_t k = kDirect + 1; k <= kLimit; ++k) large[k] -= small[n / (k * p)] - below;
+        for (std::uint64_t v = root; v >= square; --v) small[v] -= small[v / p] - below;
+    }
+    return large[1];
+}
+
+// Segmented sieve of Eratosthenes on the 2-3-5 wheel (see the comment at the top). Bit j of byte k
+// stands for 30 k + WHEEL[j]; each sieving prime p >= 7 clears its multiples p q for q >= p coprime
+// to 30, one residue class of q at a time, which in the byte array is a stride-p loop with a fixed
+// mask. Sieving primes remember where they stop in a segment, so a chunk computes its start
+// positions once.
+class SegmentedSieve {
+public:
+    static constexpr std::uint64_t LIMIT = 100000000000000ull; // 10^14: sieving primes up to 10^7
+    static constexpr std::size_t SEGMENT_BYTES = 1 << 18;      // 7.8 million numbers, sized for L2
+    static constexpr std::size_t CHUNK_SEGMENTS = 8;            // Segments per task
+
+    // Sieves [low, high] (high <= LIMIT) and calls visit(result, segmentLow, bytes) for every segment in
+    // order within its chunk, with the bits of numbers outside the range cleared. result is the
+    // chunk's element of the returned vector; chunks run on threadCount threads. The primes 2, 3 and
+    // 5 are not on the wheel and are left to the caller.
+    template <typename Result, typename VisitFn>
+    static std::vector<Result> sieve(std::uint64_t low, std::uint64_t high, unsigned threadCount, VisitFn&& visit) {
+        using number_theory_detail::WHEEL;
+        using number_theory_detail::WHEEL_BIT;
+        if (high < low) return {};
+        const std::uint64_t firstByte = low / 30, lastByte = high / 30;
+        const std::uint64_t chunkBytes = SEGMENT_BYTES * CHUNK_SEGMENTS;
+        const std::size_t chunks = static_cast<std::size_t>((lastByte - firstByte) / chunkBytes + 1);
+        std::vector<std::uint32_t> primes = factorial_detail::primesUpTo(static_cast<std::uint32_t>(number_theory_detail::integerSqrt(high)));
+        primes.erase(primes.begin(), std::find_if(primes.begin(), primes.end(), [](std::uint32_t p) { return p > 5; }));
+
+        std::vector<Result> results(chunks);
+        parallelFor(chunks, threadCount, [&](std::size_t chunk) {
+            const std::uint64_t chunkFirst = firstByte + chunk * chunkBytes;
+            const std::uint64_t chunkLast = std::min(lastByte, chunkFirst + chunkBytes - 1);
+            const std::uint64_t chunkHigh = chunkLast * 30 + 29;
+            // Primes whose square lies beyond the chunk clear nothing in it
+            const std::size_t active = static_cast<std::size_t>(std::upper_bound(primes.begin(), primes.end(), chunkHigh,
+                [](std::uint64_t value, std::uint32_t p) { return value < static_cast<std::uint64_t>(p) * p; }) - primes.begin());
+
+            // next[i][w]: byte offset from the current segment of the next multiple p q with q = WHEEL[w] mod 30
+            std::vector<std::array<std::uint32_t, 8>> next(active);
+            for (std::size_t i = 0; i < active; ++i) {
+                const std::uint64_t p = primes[i];
+                const std::uint64_t qMin = std::max(p, (chunkFirst * 30 + p - 1) / p);
+                for (std::size_t w = 0; w < WHEEL.size(); ++w) {
+                    const std::uint64_t qa = qMin > WHEEL[w] ? (qMin - WHEEL[w] + 29) / 30 : 0;
+                    const std::uint64_t byte = p * (30 * qa + WHEEL[w]) / 30;
+                    next[i][w] = static_cast<std::uint32_t>(std::min<std::uint64_t>(byte - chunkFirst, UINT32_MAX));
+                }
+            }
+
+            std::vector<std::uint8_t> segment(SEGMENT_BYTES);
+            for (std::uint64_t segmentFirst = chunkFirst; segmentFirst <= chunkLast; segmentFirst += SEGMENT_BYTES) {
+                const std::size_t bytes = static_cast<std::size_t>(std::min<std::uint64_t>(SEGMENT_BYTES, chunkLast - segmentFirst + 1));
+                std::fill_n(segment.begin(), bytes, std::uint8_t(0xFF));
+                for (std::size_t i = 0; i < active; ++i) {
+                    const std::uint32_t p = primes[i];
+                    for (std::size_t w = 0; w < WHEEL.size(); ++w) {
+                        const auto mask = static_cast<std::uint8_t>(~(1u << WHEEL_BIT[(p % 30) * WHEEL[w] % 30]));
+                        std::uint64_t offset = next[i][w];
+                        for (; offset < bytes; offset += p) segment[offset] &= mask;
+                        next[i][w] = static_cast<std::uint32_t>(std::min<std::uint64_t>(offset - bytes, UINT32_MAX));
+                    }
+                }
+                if (segmentFirst == 0) segment[0] &= 0xFE; // 1 is not prime
+                for (const std::uint64_t edge : {firstByte, lastByte}) {
+                    if (edge < segmentFirst || edge >= segmentFirst + bytes) continue;
+                    for (std::size_t j = 0; j < WHEEL.size(); ++j) {
+                        const std::uint64_t value = edge * 30 + WHEEL[j];
+                        if (value < low || value > high) segment[edge - segmentFirst] &= static_cast<std::uint8_t>(~(1u << j));
+                    }
+                }
+                visit(results[chunk], segmentFirst * 30, std::span<const std::uint8_t>(segment.data(), bytes));
+            }
+        });
+        return results;
+    }
+};
+
+namespace number_theory_detail {
+    inline std::uint64_t smallPrimesIn(std::uint64_t low, std::uint64_t high) {
+        std::uint64_t count = 0;
+        for (const std::uint64_t p : {2, 3, 5}) count += p >= low && p <= high;
+        return count;
+    }
+}
+
+// Number of primes in [low, high], high <= SegmentedSieve::LIMIT
+inline std::uint64_t countPrimesInRange(std::uint64_t low, std::uint64_t high, unsigned threadCount) {
+    if (high < low) return 0;
+    const auto counts = SegmentedSieve::sieve<std::uint64_t>(low, high, threadCount,
+        [](std::uint64_t& count, std::uint64_t, std::span<const std::uint8_t> bytes) {
+            std::size_t k = 0;
+            for (; k + 8 <= bytes.size(); k += 8) {
+                std::uint64_t word;
+                std::memcpy(&word, bytes.data() + k, sizeof(word));
+                count += static_cast<std::uint64_t>(__builtin_popcountll(word));
+            }
+            for (; k < bytes.size(); ++k) count += static_cast<std::uint64_t>(__builtin_popcount(bytes[k]));
+        });
+    std::uint64_t total = number_theory_detail::smallPrimesIn(low, high);
+    for (const std::uint64_t count : counts) total += count;
+    return total;
+}
+
+// The primes in [low, high] in increasing order, high <= SegmentedSieve::LIMIT
+inline std::vector<std::uint64_t> primesInRange(std::uint64_t low, std::uint64_t high, unsigned threadCount) {
+    std::vector<std::uint64_t> primes;
+    if (high < low) return primes;
+    for (const std::uint64_t p : {2, 3, 5}) {
+        if (p >= low && p <= high) primes.push_back(p);
+    }
+    auto chunks = SegmentedSieve::sieve<std::vector<std::uint64_t>>(low, high, threadCount,
+        [](std::vector<std::uint64_t>& found, std::uint64_t segmentLow, std::span<const std::uint8_t> bytes) {
+            for (std::size_t k = 0; k < bytes.size(); ++k) {
+                for (unsigned bits = bytes[k]; bits != 0; bits &= bits - 1) {
+                    found.push_back(segmentLow + 30 * k + number_theory_detail::WHEEL[__builtin_ctz(bits)]);
+                }
+            }
+        });
+    for (const auto& chunk : chunks) primes.insert(primes.end(), chunk.begin(), chunk.end());
+    return primes;
+}
+
+// The n-th prime (n >= 1), or 0 if it lies beyond SegmentedSieve::LIMIT: pi() of an estimate from
+// the asymptotic expansion of p_n, then sieved windows of NTH_PRIME_WINDOW numbers towards it
+inline std::uint64_t nthPrime(std::uint64_t n, unsigned threadCount) {
+    static constexpr std::uint64_t NTH_PRIME_WINDOW = 1 << 24;
+    if (n == 0) return 0;
+    if (n < 6) return std::array<std::uint64_t, 6>{0, 2, 3, 5, 7, 11}[n];
+    const double logN = std::log(static_cast<double>(n)), logLogN = std::log(logN);
+    const double estimate = static_cast<double>(n) * (logN + logLogN - 1 + (logLogN - 2) / logN);
+    if (!(estimate < static_cast<double>(SegmentedSieve::LIMIT - NTH_PRIME_WINDOW))) return 0;
+
+    std::uint64_t x = static_cast<std::uint64_t>(estimate);
+    std::uint64_t below = countPrimes(x); // Primes <= x
+    if (below < n) {
+        for (std::uint64_t low = x + 1; low < SegmentedSieve::LIMIT; low += NTH_PRIME_WINDOW) {
+            const auto primes = primesInRange(low, std::min(SegmentedSieve::LIMIT, low + NTH_PRIME_WINDOW - 1), threadCount);
+            if (below + primes.size() >= n) return primes[n - below - 1];
+            below += primes.size();
+        }
+        return 0;
+    }
+    for (std::uint64_t high = x;; high -= NTH_PRIME_WINDOW) { // Primes <= high number 'below'
+        const std::uint64_t low = high >= NTH_PRIME_WINDOW ? high - NTH_PRIME_WINDOW + 1 : 0;
+        const auto primes = primesInRange(low, high, threadCount);
+        if (below - primes.size() < n) return primes[n - (below - primes.size()) - 1];
+        below -= primes.size();
+    }
+}
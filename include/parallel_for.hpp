@@ -0,0 +1,23 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls task(i) for every i in [0, count) on up to threadCount threads, the caller being one of them.
+// Indices are handed out one at a time, so tasks may differ in cost; a task must only write state
+// owned by its index. For work that needs no expression evaluator (ParallelSampler::forEach is the
+// equivalent for work that does).
+template <typename TaskFn>
+void parallelFor(std::size_t count, unsigned threadCount, TaskFn&& task) {
+    std::atomic<std::size_t> next{0};
+    auto loop = [&] {
+        for (std::size_t i = next++; i < count; i = next++) task(i);
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 1; t < std::min<std::size_t>(threadCount, count); ++t) pool.emplace_back(loop);
+    loop();
+    for (std::thread& thread : pool) thread.join();
+}
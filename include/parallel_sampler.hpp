@@ -0,0 +1,193 @@
+#pragma once
+
+#include "exprtk.hpp"
+#include "bytecode.hpp"
+#include "jit.hpp"
+#include "autodiff.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Evaluates one expression over a uniform x grid on several threads. The calculator's evaluators
+// all read 'x' from a single shared variable (or own mutable registers), so every worker gets its
+// own copy: a private 'x' in a private exprtk symbol table and expression, a private bytecode VM,
+// or a private JIT function. Work is handed out in fixed-size chunks; results are reported per
+// chunk index so callers can merge them in chunk order and get the same answer on any thread count.
+// forEach() runs arbitrary per-index tasks (e.g. root refinement) on the same per-thread evaluators.
+class ParallelSampler {
+public:
+    // Adds 'x' (bound to the given variable) and the calculator's constants/functions to a table
+    using SymbolBinder = void (*)(exprtk::symbol_table<double>& table, double& x);
+
+    enum class Tier { Exprtk, Bytecode, Jit };
+
+    static constexpr std::size_t CHUNK_SAMPLES = 2048; // Samples per work item handed to a thread
+
+    // threadCount == 0 uses every hardware thread
+    explicit ParallelSampler(SymbolBinder binder, unsigned threadCount = 0)
+        : m_binder(binder), m_threadCount(threadCount ? threadCount : hardwareThreads()), m_preparedTier(Tier::Exprtk) {}
+
+    static unsigned hardwareThreads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    unsigned threadCount() const { return m_threadCount; }
+
+    // True if a run of sampleCount samples should be spread over threads rather than run inline
+    bool worthParallel(std::size_t sampleCount) const {
+        return m_threadCount > 1 && sampleCount >= 2 * CHUNK_SAMPLES;
+    }
+
+    // Builds one evaluator per thread for the expression on the given tier. program must be set for
+    // the Bytecode and Jit tiers. Evaluators are kept until a different expression or tier comes in.
+    // Returns false if a worker's evaluator cannot be built (the caller then samples serially).
+    // When program is set, every worker can also evaluate f' on dual numbers (see Evaluator).
+    bool prepare(const std::string& expressionStr, const BytecodeProgram* program, Tier tier) {
+        if (!m_workers.empty() && expressionStr == m_preparedExpression && tier == m_preparedTier &&
+            (program != nullptr) == m_preparedWithProgram) return true;
+        const Tier requestedTier = tier;
+        m_workers.clear();
+        m_preparedExpression.clear();
+        if (tier != Tier::Exprtk && !program) return false;
+
+        exprtk::parser<double> parser;
+        for (unsigned t = 0; t < m_threadCount; ++t) {
+            auto worker = std::make_unique<Worker>();
+            if (program) worker->dual.load(*program);
+            if (tier == Tier::Jit) {
+                worker->jit = JitFunction::compile(*program);
+                if (!worker->jit) tier = Tier::Bytecode; // Mapping failed: the VM is still fine
+            }
+            if (tier == Tier::Bytecode) {
+                worker->vm.load(*program);
+                worker->useVm = true;
+            }
+            if (tier == Tier::Exprtk) {
+                m_binder(worker->symbolTable, worker->x);
+                worker->expression.register_symbol_table(worker->symbolTable);
+                if (!parser.compile(expressionStr, worker->expression)) {
+                    m_workers.clear();
+                    return false;
+                }
+            }
+            m_workers.push_back(std::move(worker));
+        }
+        m_preparedExpression = expressionStr;
+        m_preparedTier = requestedTier;
+        m_preparedWithProgram = program != nullptr;
+        return true;
+    }
+
+    // Number of chunks run() will split sampleCount samples into
+    static std::size_t chunkCount(std::size_t sampleCount) {
+        return (sampleCount + CHUNK_SAMPLES - 1) / CHUNK_SAMPLES;
+    }
+
+    // Evaluates f(xMin + i * step) for i in [0, sampleCount) on the prepared workers and calls
+    // onChunk(chunkIndex, xs, ys) from the worker thread for each finished chunk. onChunk must only
+    // write state owned by that chunk index.
+    template <typename ChunkFn>
+    void run(double xMin, double step, std::size_t sampleCount, ChunkFn&& onChunk) {
+        const std::size_t chunks = chunkCount(sampleCount);
+        std::atomic<std::size_t> nextChunk{0};
+        auto workerLoop = [&](Worker& worker) {
+            std::vector<double> xs(CHUNK_SAMPLES), ys(CHUNK_SAMPLES);
+            for (std::size_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+                const std::size_t begin = chunk * CHUNK_SAMPLES;
+                const std::size_t lanes = std::min(CHUNK_SAMPLES, sampleCount - begin);
+                for (std::size_t k = 0; k < lanes; ++k) xs[k] = xMin + static_cast<double>(begin + k) * step;
+                worker.evaluate(xs.data(), ys.data(), lanes);
+                onChunk(chunk, std::span<const double>(xs.data(), lanes), std::span<const double>(ys.data(), lanes));
+            }
+        };
+
+        runOnWorkers(chunks, workerLoop);
+    }
+
+private:
+    struct Worker;
+
+public:
+    // One worker's evaluator as seen by a forEach() task: f on the prepared tier (one x or a batch),
+    // and f and f' together on dual numbers if prepare() was given a program
+    class Evaluator {
+    public:
+        explicit Evaluator(Worker& worker) : m_worker(worker) {}
+        double value(double x) { return m_worker.evaluate(x); }
+        void evaluate(const double* xs, double* ys, std::size_t count) { m_worker.evaluate(xs, ys, count); }
+        bool hasDerivative() const { return m_worker.dual.loaded(); }
+        Dual valueAndDerivative(double x) { return m_worker.dual.evaluate(Dual::variable(x)); }
+
+    private:
+        Worker& m_worker;
+    };
+
+    // Calls task(taskIndex, evaluator) for every index in [0, taskCount) on the prepared workers.
+    // Tasks are handed out one at a time, so they may differ in cost; a task must only write state
+    // owned by its index.
+    template <typename TaskFn>
+    void forEach(std::size_t taskCount, TaskFn&& task) {
+        std::atomic<std::size_t> nextTask{0};
+        auto workerLoop = [&](Worker& worker) {
+            Evaluator evaluator(worker);
+            for (std::size_t index = nextTask++; index < taskCount; index = nextTask++) task(index, evaluator);
+        };
+        runOnWorkers(taskCount, workerLoop);
+    }
+
+private:
+    struct Worker {
+        double x = 0.0;
+        exprtk::symbol_table<double> symbolTable;
+        exprtk::expression<double> expression;
+        BytecodeVM vm;
+        bool useVm = false;
+        std::unique_ptr<JitFunction> jit;
+        ProgramEvaluator<Dual> dual; // Loaded only when a bytecode program was given
+
+        double evaluate(double xValue) {
+            if (jit) return jit->evaluate(xValue);
+            if (useVm) return vm.evaluate(xValue);
+            x = xValue;
+            return expression.value();
+        }
+
+        void evaluate(const double* xs, double* ys, std::size_t count) {
+            if (jit) {
+                jit->evaluate(xs, ys, count);
+            } else if (useVm) {
+                for (std::size_t base = 0; base < count; base += BytecodeVM::BLOCK_LANES) {
+                    vm.evaluateBlock(xs + base, ys + base, std::min(BytecodeVM::BLOCK_LANES, count - base));
+                }
+            } else {
+                for (std::size_t i = 0; i < count; ++i) {
+                    x = xs[i];
+                    ys[i] = expression.value();
+                }
+            }
+        }
+    };
+
+    // Runs loop(worker) on min(workers, itemCount) workers, the calling thread being worker 0
+    template <typename LoopFn>
+    void runOnWorkers(std::size_t itemCount, LoopFn& loop) {
+        const std::size_t threads = std::min<std::size_t>(m_workers.size(), itemCount);
+        std::vector<std::thread> pool;
+        pool.reserve(threads > 0 ? threads - 1 : 0);
+        for (std::size_t t = 1; t < threads; ++t) pool.emplace_back(loop, std::ref(*m_workers[t]));
+        if (threads > 0) loop(*m_workers[0]);
+        for (std::thread& thread : pool) thread.join();
+    }
+
+    SymbolBinder m_binder;
+    unsigned m_threadCount;
+    std::vector<std::unique_ptr<Worker>> m_workers; // Heap-allocated so each symbol table's &x stays put
+    std::string m_preparedExpression;
+    Tier m_preparedTier;
+    bool m_preparedWithProgram = false;
+};
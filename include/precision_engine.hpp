@@ -0,0 +1,202 @@
+#pragma once
+
+#include "exprtk_real_adaptor.hpp" // Before anything else that includes exprtk.hpp
+#include "float128.hpp"
+#include "multi_float.hpp"
+#include "series_accumulators.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#ifndef MATHD_MULTI_LIMBS
+#define MATHD_MULTI_LIMBS 8 // 64-bit limbs of the multi precision: 8 give 512 bits, ~151 digits
+#endif
+
+using MultiPrecisionFloat = MultiFloat<MATHD_MULTI_LIMBS>;
+
+// Scalar types the calculator can evaluate in. Double is the native precision: the bytecode VM, the
+// JIT, automatic differentiation, the root finder and the integrator all work in double. The other
+// precisions compile the expression text with exprtk over their own scalar type, so every literal,
+// constant and operation is carried out in that type.
+enum class Precision {
+    Float,      // 24-bit significand, ~7 digits
+    Double,     // 53-bit significand, ~16 digits
+    LongDouble, // 64-bit significand on x86 (80-bit extended), ~19 digits
+    Quad,       // 113-bit significand, ~34 digits: Float128, only with MATHD_QUADMATH
+    Multi       // 64 * MATHD_MULTI_LIMBS-bit significand in software: MultiPrecisionFloat
+};
+
+inline const char* precisionName(Precision precision) {
+    switch (precision) {
+        case Precision::Float: return "float";
+        case Precision::Double: return "double";
+        case Precision::LongDouble: return "long double";
+        case Precision::Quad: return "quad";
+        case Precision::Multi: return "multi";
+    }
+    return "?";
+}
+
+// Accepts the names the command line and the "precision" command use: float, double, long, quad, multi
+inline std::optional<Precision> precisionFromName(std::string_view name) {
+    if (name == "float") return Precision::Float;
+    if (name == "double") return Precision::Double;
+    if (name == "long" || name == "long double") return Precision::LongDouble;
+    if (name == "quad") return Precision::Quad;
+    if (name == "multi") return Precision::Multi;
+    return std::nullopt;
+}
+
+// Significant decimal digits that always survive a round trip through the precision (digits10),
+// and the most worth printing (max_digits10)
+inline int precisionDigits(Precision precision) {
+    switch (precision) {
+        case Precision::Float: return std::numeric_limits<float>::digits10;
+        case Precision::Double: return std::numeric_limits<double>::digits10;
+        case Precision::LongDouble: return std::numeric_limits<long double>::digits10;
+        case Precision::Quad: return 33;
+        case Precision::Multi: return MultiPrecisionFloat::DIGITS;
+    }
+    return std::numeric_limits<double>::digits10;
+}
+
+inline int precisionMaxDigits(Precision precision) {
+    switch (precision) {
+        case Precision::Float: return std::numeric_limits<float>::max_digits10;
+        case Precision::Double: return std::numeric_limits<double>::max_digits10;
+        case Precision::LongDouble: return std::numeric_limits<long double>::max_digits10;
+        case Precision::Quad: return 36;
+        case Precision::Multi: return MultiPrecisionFloat::MAX_DIGITS;
+    }
+    return std::numeric_limits<double>::max_digits10;
+}
+
+inline bool precisionAvailable(Precision precision) {
+#ifdef MATHD_QUADMATH
+    (void)precision;
+    return true;
+#else
+    return precision != Precision::Quad;
+#endif
+}
+
+// One expression compiled by exprtk over Scalar, with the calculator's standard symbols (x, pi, e,
+// cbrt) in Scalar precision. The expression text is compiled as typed: the simplifier folds constants
+// in double, which would throw away the extra digits of a wider type. Single-threaded, and not
+// copyable, since the symbol table refers to the engine's own x.
+// The members are defined out of line so that the engines the calculator uses are instantiated once,
+// in src/precision_engines.cpp (see the extern declarations at the end of this file): exprtk's parser
+// over each scalar type is by far the largest part of the build.
+template <typename Scalar>
+class PrecisionEngine {
+public:
+    static constexpr int DIGITS = std::numeric_limits<Scalar>::digits10;         // Decimal digits always preserved
+    static constexpr int MAX_DIGITS = std::numeric_limits<Scalar>::max_digits10; // Enough to tell all values apart
+
+    PrecisionEngine();
+    ~PrecisionEngine();
+
+    PrecisionEngine(const PrecisionEngine&) = delete;
+    PrecisionEngine& operator=(const PrecisionEngine&) = delete;
+
+    // Compiles text unless it is already the current expression. On failure error() says why.
+    bool compile(const std::string& text);
+
+    std::string error() const;
+
+    Scalar evaluate(Scalar x);
+
+    // f at every x of xs, rounded to double for plotting
+    void sample(std::span<const double> xs, std::span<double> ys);
+
+    // Sum of f(x) for the integers x in [first, last], Neumaier-compensated in Scalar
+    Scalar sum(long long first, long long last);
+
+    // Product of f(x) for the integers x in [first, last]; overflows at Scalar's range
+    Scalar product(long long first, long long last);
+
+    // value with the given number of significant digits (DIGITS by default, at most MAX_DIGITS)
+    static std::string format(const Scalar& value, int digits = DIGITS);
+
+private:
+    static Scalar constantPi() { using std::acos; return acos(Scalar(-1)); }
+    static Scalar constantE() { using std::exp; return exp(Scalar(1)); }
+    static Scalar cubeRoot(Scalar v) { using std::cbrt; return cbrt(v); }
+
+    Scalar m_x = Scalar(0);
+    exprtk::symbol_table<Scalar> m_symbolTable;
+    exprtk::expression<Scalar> m_expression;
+    exprtk::parser<Scalar> m_parser;
+    std::string m_text; // The compiled expression, empty if none
+    bool m_valid = false;
+};
+
+template <typename Scalar>
+PrecisionEngine<Scalar>::PrecisionEngine() {
+    m_symbolTable.add_variable("x", m_x);
+    m_symbolTable.add_constant("pi", constantPi());
+    m_symbolTable.add_constant("e", constantE());
+    m_symbolTable.add_function("cbrt", cubeRoot);
+    m_expression.register_symbol_table(m_symbolTable);
+}
+
+template <typename Scalar>
+PrecisionEngine<Scalar>::~PrecisionEngine() = default;
+
+template <typename Scalar>
+bool PrecisionEngine<Scalar>::compile(const std::string& text) {
+    if (m_valid && text == m_text) return true;
+    m_valid = m_parser.compile(text, m_expression);
+    m_text = m_valid ? text : std::string();
+    return m_valid;
+}
+
+template <typename Scalar>
+std::string PrecisionEngine<Scalar>::error() const { return m_parser.error(); }
+
+template <typename Scalar>
+Scalar PrecisionEngine<Scalar>::evaluate(Scalar x) {
+    m_x = x;
+    return m_expression.value();
+}
+
+template <typename Scalar>
+void PrecisionEngine<Scalar>::sample(std::span<const double> xs, std::span<double> ys) {
+    const std::size_t count = std::min(xs.size(), ys.size());
+    for (std::size_t i = 0; i < count; ++i) ys[i] = static_cast<double>(evaluate(Scalar(xs[i])));
+}
+
+template <typename Scalar>
+Scalar PrecisionEngine<Scalar>::sum(long long first, long long last) {
+    BasicNeumaierSum<Scalar> total;
+    for (long long x = first; x <= last; ++x) total.add(evaluate(Scalar(x)));
+    return total.value();
+}
+
+template <typename Scalar>
+Scalar PrecisionEngine<Scalar>::product(long long first, long long last) {
+    Scalar total(1);
+    for (long long x = first; x <= last; ++x) total *= evaluate(Scalar(x));
+    return total;
+}
+
+template <typename Scalar>
+std::string PrecisionEngine<Scalar>::format(const Scalar& value, int digits) {
+    std::ostringstream out;
+    out << std::setprecision(std::clamp(digits, 1, MAX_DIGITS)) << value;
+    return out.str();
+}
+
+extern template class PrecisionEngine<float>;
+extern template class PrecisionEngine<long double>;
+#ifdef MATHD_QUADMATH
+extern template class PrecisionEngine<Float128>;
+#endif
+extern template class PrecisionEngine<MultiPrecisionFloat>;
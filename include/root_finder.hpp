@@ -0,0 +1,144 @@
+#pragma once
+
+#include "sample_buffer.hpp"
+#include "autodiff.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Zeros of f(x) on a range: sign changes between neighbouring samples give brackets, and each
+// bracket is narrowed to machine precision by Brent's method (or by Newton steps on a dual-number
+// evaluation of f, safeguarded by bisection). Roots where f touches zero without crossing are only
+// found if a sample lands on them exactly.
+
+struct RootBracket {
+    double a, b;   // a < b
+    double fa, fb; // Of opposite signs
+};
+
+struct RootEstimate {
+    double x;
+    double fx;
+};
+
+struct RootFindingResult {
+    std::vector<double> roots;       // Ascending
+    std::size_t brackets = 0;        // Sign changes found in the samples
+    std::size_t discontinuities = 0; // Sign changes that turned out to be poles or jumps
+    std::size_t evaluations = 0;     // Refinement evaluations (the samples are not counted)
+    bool newton = false;             // Refined by Newton steps rather than Brent's method
+};
+
+// Sign changes between consecutive finite samples. Samples that are exactly zero are roots already
+// and go to exactRoots; they never start or end a bracket.
+inline std::vector<RootBracket> findSignChanges(const SampleBuffer& samples, std::vector<double>& exactRoots) {
+    std::vector<RootBracket> brackets;
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        const double y = samples.ys[i];
+        if (y == 0.0) exactRoots.push_back(samples.xs[i]);
+        if (i + 1 == samples.size()) break;
+        const double next = samples.ys[i + 1];
+        if (std::isfinite(y) && std::isfinite(next) && ((y < 0.0 && next > 0.0) || (y > 0.0 && next < 0.0))) {
+            brackets.push_back({samples.xs[i], samples.xs[i + 1], y, next});
+        }
+    }
+    return brackets;
+}
+
+namespace root_finding {
+    static constexpr int MAX_ITERATIONS = 100;
+    static constexpr double EPS = std::numeric_limits<double>::epsilon();
+    static constexpr double ABSOLUTE_TOLERANCE = 1e-300; // Lets roots at 0 converge without denormal crawling
+
+    inline double tolerance(double x) { return 2.0 * EPS * std::abs(x) + ABSOLUTE_TOLERANCE; }
+
+    // Brent's method: inverse quadratic interpolation and secant steps, falling back to bisection
+    // whenever they would not shrink the bracket fast enough. f(x) returns a double.
+    template <typename F>
+    RootEstimate brent(F&& f, const RootBracket& bracket, std::size_t& evaluations) {
+        double a = bracket.a, b = bracket.b, fa = bracket.fa, fb = bracket.fb;
+        double c = b, fc = fb, d = b - a, e = d;
+        for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+            if ((fb > 0.0) == (fc > 0.0)) { c = a; fc = fa; d = b - a; e = d; }
+            if (std::abs(fc) < std::abs(fb)) { a = b; b = c; c = a; fa = fb; fb = fc; fc = fa; }
+            const double tol = tolerance(b);
+            const double m = 0.5 * (c - b);
+            if (std::abs(m) <= tol || fb == 0.0) break;
+            if (std::abs(e) >= tol && std::abs(fa) > std::abs(fb)) {
+                const double s = fb / fa;
+                double p, q;
+                if (a == c) { // Secant
+                    p = 2.0 * m * s;
+                    q = 1.0 - s;
+                } else {      // Inverse quadratic interpolation
+                    const double qa = fa / fc, r = fb / fc;
+                    p = s * (2.0 * m * qa * (qa - r) - (b - a) * (r - 1.0));
+                    q = (qa - 1.0) * (r - 1.0) * (s - 1.0);
+                }
+                if (p > 0.0) q = -q; else p = -p;
+                if (2.0 * p < std::min(3.0 * m * q - std::abs(tol * q), std::abs(e * q))) { e = d; d = p / q; }
+                else { d = m; e = m; }
+            } else {
+                d = m;
+                e = m;
+            }
+            a = b;
+            fa = fb;
+            b += (std::abs(d) > tol) ? d : (m > 0.0 ? tol : -tol);
+            fb = f(b);
+            ++evaluations;
+        }
+        return {b, fb};
+    }
+
+    // Newton's method on fd(x) -> Dual (f and f' in one pass), kept inside the bracket: a step that
+    // would leave it, or would not halve the previous step, is replaced by bisection.
+    template <typename FD>
+    RootEstimate newton(FD&& fd, const RootBracket& bracket, std::size_t& evaluations) {
+        double lo = bracket.fa < 0.0 ? bracket.a : bracket.b; // f(lo) < 0 < f(hi)
+        double hi = bracket.fa < 0.0 ? bracket.b : bracket.a;
+        double x = 0.5 * (bracket.a + bracket.b);
+        double step = std::abs(bracket.b - bracket.a), previousStep = step;
+        Dual y = fd(x);
+        ++evaluations;
+        for (int iteration = 0; iteration < MAX_ITERATIONS && y.value != 0.0; ++iteration) {
+            const bool bisect = !std::isfinite(y.value) || !std::isfinite(y.d) ||
+                                ((x - hi) * y.d - y.value) * ((x - lo) * y.d - y.value) > 0.0 ||
+                                std::abs(2.0 * y.value) > std::abs(previousStep * y.d);
+            previousStep = step;
+            if (bisect) {
+                step = 0.5 * (hi - lo);
+                x = lo + step;
+            } else {
+                step = y.value / y.d;
+                x -= step;
+            }
+            if (std::abs(step) <= tolerance(x)) break;
+            y = fd(x);
+            ++evaluations;
+            if (y.value < 0.0) lo = x; else hi = x;
+        }
+        return {x, y.value};
+    }
+
+    // A genuine root leaves |f| well below its size at the bracket ends; at a pole or a jump
+    // (tan(x), floor(x) - 0.5) the bracket closes on a point where |f| stays large.
+    inline bool isRoot(const RootBracket& bracket, const RootEstimate& estimate) {
+        return std::abs(estimate.fx) <= 0.5 * std::min(std::abs(bracket.fa), std::abs(bracket.fb));
+    }
+
+    // Refines each bracket into the estimate at the same index, by newton() on fd if useNewton and
+    // by brent() on f otherwise. Returns the number of evaluations.
+    template <typename F, typename FD>
+    std::size_t refineBrackets(std::span<const RootBracket> brackets, std::span<RootEstimate> estimates,
+                               F&& f, FD&& fd, bool useNewton) {
+        std::size_t evaluations = 0;
+        for (std::size_t i = 0; i < brackets.size(); ++i) {
+            estimates[i] = useNewton ? newton(fd, brackets[i], evaluations) : brent(f, brackets[i], evaluations);
+        }
+        return evaluations;
+    }
+}
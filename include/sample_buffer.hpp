@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// (x, y) samples of a function over [xMin, xMax], sorted by x. The graphing tool fills one buffer
+// per plot, derives the Y range from it and rasterizes from it, so both see the same evaluations.
+struct SampleBuffer {
+    std::vector<double> xs;
+    std::vector<double> ys; // NaN where the function is undefined
+    bool uniform = true;    // xs is a uniform grid (false for adaptive sampling)
+    std::vector<std::pair<double, double>> poles; // x intervals never interpolated across (ascending)
+
+    std::size_t size() const { return xs.size(); }
+    bool empty() const { return xs.empty(); }
+
+    // x of sample i on a uniform grid of count points over [xMin, xMax]. Every sampler uses this so
+    // that the same grid point always gets the same x, bit for bit.
+    static double uniformX(double xMin, double xMax, std::size_t count, std::size_t i) {
+        const double step = (xMax - xMin) / static_cast<double>(std::max<std::size_t>(1, count - 1));
+        return xMin + static_cast<double>(i) * step;
+    }
+
+    // A buffer with xs set to the uniform grid of count points over [xMin, xMax] and ys to be filled
+    static SampleBuffer uniformGrid(double xMin, double xMax, std::size_t count) {
+        SampleBuffer buffer;
+        buffer.xs.resize(count);
+        buffer.ys.resize(count);
+        for (std::size_t i = 0; i < count; ++i) buffer.xs[i] = uniformX(xMin, xMax, count, i);
+        return buffer;
+    }
+
+    // Smallest sample count >= minSamples whose uniform grid contains every point of a uniform grid of
+    // gridPoints over the same range, so resample(gridPoints) picks samples instead of interpolating.
+    static std::size_t nestedSize(std::size_t minSamples, std::size_t gridPoints) {
+        if (gridPoints < 2) return std::max<std::size_t>(minSamples, 1);
+        const std::size_t intervals = gridPoints - 1;
+        const std::size_t factor = std::max<std::size_t>(1, (std::max<std::size_t>(minSamples, 2) - 1 + intervals - 1) / intervals);
+        return factor * intervals + 1;
+    }
+
+    // Smallest and largest finite-or-infinite y, ignoring NaN. {inf, -inf} if every sample is NaN.
+    std::pair<double, double> yRange() const {
+        double minY = std::numeric_limits<double>::infinity();
+        double maxY = -std::numeric_limits<double>::infinity();
+        for (const double y : ys) {
+            if (std::isnan(y)) continue;
+            if (y < minY) minY = y;
+            if (y > maxY) maxY = y;
+        }
+        return {minY, maxY};
+    }
+
+    // y at an arbitrary x: the sample itself when x is (within rounding of) a sample position,
+    // otherwise linear interpolation between the neighbours. NaN outside the buffer, next to a NaN,
+    // or when a pole lies between the neighbours.
+    double valueAt(double x) const {
+        if (xs.empty() || x < xs.front() || x > xs.back()) return std::numeric_limits<double>::quiet_NaN();
+        const std::size_t hi = static_cast<std::size_t>(std::lower_bound(xs.begin(), xs.end(), x) - xs.begin());
+        if (hi == 0) return ys[0];
+        const std::size_t lo = hi - 1;
+        const double span = xs[hi] - xs[lo];
+        const double tolerance = span * 1e-9; // Grid points recomputed on a nested grid differ by an ulp or so
+        if (xs[hi] - x <= tolerance) return ys[hi];
+        if (x - xs[lo] <= tolerance) return ys[lo];
+        for (const auto& [poleLo, poleHi] : poles) {
+            if (poleLo <= xs[hi] && poleHi >= xs[lo]) return std::numeric_limits<double>::quiet_NaN();
+        }
+        const double t = (x - xs[lo]) / span;
+        return ys[lo] + (ys[hi] - ys[lo]) * t;
+    }
+
+    // The buffer seen on a uniform grid of count points over the same range
+    SampleBuffer resample(std::size_t count) const {
+        SampleBuffer out;
+        out.poles = poles;
+        if (xs.empty() || count == 0) return out;
+        out.xs.resize(count);
+        out.ys.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            out.xs[i] = uniformX(xs.front(), xs.back(), count, i);
+            out.ys[i] = valueAt(out.xs[i]);
+        }
+        return out;
+    }
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "series_accumulators.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Limits of infinite series from a few of their partial sums. The terms are summed in doubling
+// stages (16, 32, 64, ... terms); after each stage every accelerator extrapolates the partial
+// sums, and its error is estimated as the change from its estimate one stage earlier. The method
+// with the smallest such change wins, and summation stops once that is within the tolerance.
+//   - Wynn's epsilon algorithm: geometric and alternating series (sum (-1)^n/n in ~30 terms)
+//   - Iterated Aitken delta-squared: linearly convergent series
+//   - Richardson extrapolation on S(n), S(2n), S(4n), ...: tails in integer powers of 1/n (sum 1/n^2)
+//   - Euler transform of the tail: alternating series with smooth term magnitudes
+
+namespace series_acceleration {
+    enum Method { PartialSum, WynnEpsilon, Aitken, Richardson, Euler, METHOD_COUNT };
+
+    inline const char* methodName(Method method) {
+        static constexpr std::array<const char*, METHOD_COUNT> NAMES = {
+            "plain partial sums", "Wynn epsilon", "iterated Aitken delta-squared", "Richardson extrapolation", "Euler transform"};
+        return NAMES[method];
+    }
+
+    // Wynn's epsilon table over the sums; the last entry of the highest even column reached
+    inline double wynnEpsilon(std::span<const double> sums) {
+        std::vector<double> previous(sums.size() + 1, 0.0);            // Column -1
+        std::vector<double> current(sums.begin(), sums.end());          // Column 0
+        double estimate = sums.back();
+        for (std::size_t column = 1; current.size() > 1; ++column) {
+            std::vector<double> next(current.size() - 1);
+            for (std::size_t k = 0; k < next.size(); ++k) {
+                const double difference = current[k + 1] - current[k];
+                if (difference == 0.0 || !std::isfinite(difference)) return (column % 2 == 1) ? current.back() : estimate;
+                next[k] = previous[k + 1] + 1.0 / difference;
+            }
+            if (column % 2 == 0) estimate = next.back();
+            previous = std::move(current);
+            current = std::move(next);
+        }
+        return estimate;
+    }
+
+    // Aitken's delta-squared process applied to its own output until fewer than three values remain
+    inline double iteratedAitken(std::span<const double> sums) {
+        std::vector<double> current(sums.begin(), sums.end());
+        while (current.size() >= 3) {
+            std::vector<double> next(current.size() - 2);
+            for (std::size_t k = 0; k < next.size(); ++k) {
+                const double d1 = current[k + 1] - current[k], d2 = current[k + 2] - current[k + 1];
+                const double denominator = d2 - d1;
+                if (denominator == 0.0 || !std::isfinite(denominator)) return current.back();
+                next[k] = current[k + 2] - d2 * d2 / denominator;
+            }
+            current = std::move(next);
+        }
+        return current.back();
+    }
+
+    // Richardson's table over sums of n, 2n, 4n, ... terms, removing the 1/n, 1/n^2, ... error terms
+    inline double richardson(std::span<const double> doublingSums) {
+        std::vector<double> row(doublingSums.begin(), doublingSums.end());
+        for (std::size_t order = 1; row.size() > 1; ++order) {
+            const double factor = std::ldexp(1.0, static_cast<int>(order)) - 1.0; // 2^order - 1
+            for (std::size_t i = 0; i + 1 < row.size(); ++i) row[i] = row[i + 1] + (row[i + 1] - row[i]) / factor;
+            row.pop_back();
+        }
+        return row[0];
+    }
+
+    // Euler's transform of the tail sum_{k>=0} a_k, for terms that alternate in sign:
+    // sum (-1)^k b_k = sum_j (-1)^j (forward difference^j b)_0 / 2^(j+1). The differences are
+    // added while they keep shrinking. Returns NaN if the terms do not alternate.
+    inline double eulerTail(std::span<const double> tail) {
+        if (tail.empty() || tail[0] == 0.0) return std::numeric_limits<double>::quiet_NaN();
+        std::vector<double> differences(tail.size());
+        for (std::size_t k = 0; k < tail.size(); ++k) {
+            if (k > 0 && !((tail[k] > 0.0) != (tail[k - 1] > 0.0) && tail[k] != 0.0)) return std::numeric_limits<double>::quiet_NaN();
+            differences[k] = std::abs(tail[k]);
+        }
+        double sum = 0.0, scale = 0.5, lastMagnitude = std::numeric_limits<double>::infinity();
+        for (std::size_t order = 0; order < differences.size(); ++order) {
+            const double term = ((order % 2 == 0) ? 1.0 : -1.0) * differences[0] * scale;
+            if (std::abs(term) > lastMagnitude) break; // The asymptotic expansion has started to diverge
+            sum += term;
+            lastMagnitude = std::abs(term);
+            for (std::size_t k = 0; k + 1 < differences.size() - order; ++k) differences[k] = differences[k + 1] - differences[k];
+            scale *= 0.5;
+        }
+        return std::copysign(1.0, tail[0]) * sum;
+    }
+}
+
+struct SeriesLimitOptions {
+    double tolerance = 1e-12;           // Absolute below 1, relative above
+    std::size_t initialTerms = 16;
+    std::size_t maxTerms = 1u << 22;    // Stages stop doubling here
+};
+
+struct SeriesLimitResult {
+    double value = std::numeric_limits<double>::quiet_NaN();
+    double errorEstimate = std::numeric_limits<double>::infinity();
+    std::size_t terms = 0;
+    series_acceleration::Method method = series_acceleration::PartialSum;
+    bool converged = false;
+};
+
+// Limit of sum_{i>=0} term(i). evaluate(firstIndex, ys) writes term(firstIndex + k) to ys[k];
+// it is called once per stage with the terms that stage adds.
+template <typename BatchFn>
+SeriesLimitResult sumInfiniteSeries(const SeriesLimitOptions& options, BatchFn&& evaluate) {
+    using namespace series_acceleration;
+    static constexpr std::size_t MAX_WINDOW = 31;   // Partial sums fed to Wynn and Aitken (odd)
+    static constexpr std::size_t EULER_TERMS = 40;  // Tail terms the Euler transform works on
+    SeriesLimitResult result;
+    std::vector<double> terms, partialSums; // partialSums[i] = term(0) + ... + term(i)
+    NeumaierSum running;
+    std::array<double, METHOD_COUNT> previous;
+    previous.fill(std::numeric_limits<double>::quiet_NaN());
+
+    for (std::size_t count = std::max<std::size_t>(options.initialTerms, 4); count <= options.maxTerms; count *= 2) {
+        const std::size_t have = terms.size();
+        terms.resize(count);
+        evaluate(have, std::span<double>(terms).subspan(have));
+        for (std::size_t i = have; i < count; ++i) {
+            running.add(terms[i]);
+            partialSums.push_back(running.value());
+        }
+        result.terms = count;
+
+        std::array<double, METHOD_COUNT> estimates;
+        const std::size_t window = std::min(MAX_WINDOW, count - 1 + count % 2);
+        const std::span<const double> recent = std::span<const double>(partialSums).last(window);
+        estimates[PartialSum] = partialSums.back();
+        estimates[WynnEpsilon] = wynnEpsilon(recent);
+        estimates[Aitken] = iteratedAitken(recent);
+        std::vector<double> doublingSums;
+        for (std::size_t n = count; n >= options.initialTerms && n > 0; n /= 2) doublingSums.insert(doublingSums.begin(), partialSums[n - 1]);
+        estimates[Richardson] = richardson(doublingSums);
+        const std::size_t tailStart = count - std::min(EULER_TERMS, count / 2);
+        estimates[Euler] = partialSums[tailStart - 1] + eulerTail(std::span<const double>(terms).subspan(tailStart));
+
+        result.errorEstimate = std::numeric_limits<double>::infinity(); // Each stage is judged afresh
+        for (std::size_t m = 0; m < METHOD_COUNT; ++m) {
+            const double change = std::abs(estimates[m] - previous[m]);
+            if (std::isfinite(estimates[m]) && change < result.errorEstimate) {
+                result.errorEstimate = change;
+                result.value = estimates[m];
+                result.method = static_cast<Method>(m);
+            }
+        }
+        previous = estimates;
+        if (result.errorEstimate <= options.tolerance * std::max(1.0, std::abs(result.value))) {
+            result.converged = true;
+            break;
+        }
+        if (!std::isfinite(partialSums.back())) break;
+    }
+    return result;
+}
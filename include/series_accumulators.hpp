@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Accumulators for the series engine: each folds a shard of terms, and merge() combines the results
+// of neighbouring shards. reducePairwise() merges shards as a balanced tree in index order, so a
+// series gives the same answer however its shards were spread over threads.
+
+// Neumaier's compensated sum: the rounding error of every addition is kept in a second number, so
+// the error of the total does not grow with the number of terms (to first order). Scalar may be any
+// floating-point type, including class types whose abs() and isfinite() are found by ADL.
+template <typename Scalar>
+struct BasicNeumaierSum {
+    Scalar sum = Scalar(0);
+    Scalar compensation = Scalar(0);
+
+    void add(Scalar term) {
+        using std::abs;
+        const Scalar total = sum + term;
+        if (abs(sum) >= abs(term)) compensation += (sum - total) + term;
+        else compensation += (term - total) + sum;
+        sum = total;
+    }
+
+    void merge(const BasicNeumaierSum& other) {
+        add(other.sum);
+        compensation += other.compensation;
+    }
+
+    // An infinite or NaN sum has no meaningful compensation (it would be inf - inf)
+    Scalar value() const {
+        using std::isfinite;
+        return isfinite(sum) ? sum + compensation : sum;
+    }
+};
+
+using NeumaierSum = BasicNeumaierSum<double>;
+
+// A product kept as mantissa * 2^exponent, renormalized after every term so that the mantissa stays
+// in [0.5, 1) in magnitude. It neither overflows nor underflows however many terms it has, and
+// rounds like the plain product would (one rounding per multiplication). Zero, infinite and NaN
+// terms act as they would on a double: the mantissa takes the special value and keeps it.
+struct ScaledProduct {
+    double mantissa = 1.0; // Carries the sign
+    long long exponent = 0;
+
+    void add(double term) {
+        if (term == 0.0 || !std::isfinite(term)) { // frexp() leaves the exponent unspecified here
+            mantissa *= term;
+            return;
+        }
+        int termExponent = 0;
+        mantissa *= std::frexp(term, &termExponent);
+        exponent += termExponent;
+        normalize();
+    }
+
+    void merge(const ScaledProduct& other) {
+        mantissa *= other.mantissa;
+        exponent += other.exponent;
+        normalize();
+    }
+
+    bool special() const { return mantissa == 0.0 || !std::isfinite(mantissa); }
+
+    // True if the product is a finite, normal double (value() is then exact to rounding)
+    bool fitsDouble() const {
+        return special() || (exponent >= std::numeric_limits<double>::min_exponent && exponent <= std::numeric_limits<double>::max_exponent);
+    }
+
+    // The product as a double: overflows to +/-inf and underflows to 0 outside the double range
+    double value() const {
+        if (special()) return mantissa;
+        const long long limit = 4 * std::numeric_limits<double>::max_exponent; // Far outside either end
+        return std::ldexp(mantissa, static_cast<int>(std::max(-limit, std::min(limit, exponent))));
+    }
+
+    // Decimal scientific notation: significand * 10^power with 1 <= |significand| < 10. Valid for
+    // non-special products only; long double keeps the significand accurate for huge exponents.
+    std::pair<double, long long> decimal() const {
+        const long double log10Magnitude = std::log10(static_cast<long double>(std::abs(mantissa))) +
+                                           static_cast<long double>(exponent) * std::log10(2.0L);
+        long long power = static_cast<long long>(std::floor(log10Magnitude));
+        double significand = static_cast<double>(std::pow(10.0L, log10Magnitude - static_cast<long double>(power)));
+        if (significand >= 10.0) { significand /= 10.0; ++power; } // Rounded up to the next decade
+        return {std::copysign(significand, mantissa), power};
+    }
+
+private:
+    void normalize() {
+        if (special()) return;
+        int shift = 0;
+        mantissa = std::frexp(mantissa, &shift);
+        exponent += shift;
+    }
+};
+
+// Merges values[0..n) as a balanced binary tree: ((0 1) (2 3)) ((4 5) (6 7)) ...
+template <typename Accumulator>
+Accumulator reducePairwise(std::vector<Accumulator> values) {
+    if (values.empty()) return Accumulator{};
+    for (std::size_t stride = 1; stride < values.size(); stride *= 2) {
+        for (std::size_t i = 0; i + stride < values.size(); i += 2 * stride) values[i].merge(values[i + stride]);
+    }
+    return values[0];
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include "expression_tree.hpp"
+#include "bytecode.hpp" // bytecode_ops: folded constants get exactly the value the evaluators would compute
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Algebraic simplifier run on every expression before it is compiled. Sums and products are
+// flattened across their commutative operators so constants fold together ("2*x*3" -> "6*x") and
+// like terms and factors combine ("x+x" -> "2*x", "x*x*x" -> "x^3"). Identities are eliminated
+// (x+0, x*1, x/1, x^1, x^0, --x), integer powers are pushed into products ("(2*x)^2" -> "4*x^2"),
+// trig parity and Pythagorean identities are applied, and operands are put in a canonical order
+// (higher degree first, then a fixed structural order), so equivalent spellings of a function
+// come out as the same tree.
+//
+// Rewrites never widen the domain of an expression: a term or factor that can be NaN for some
+// finite x (log, sqrt, division, ...) is not dropped just because it is multiplied by zero or
+// cancels out. Reassociation may change results in the last bits, as any reordering of floating
+// point arithmetic does.
+class ExpressionSimplifier {
+public:
+    static ExprPtr simplify(const ExprPtr& node) {
+        if (!node || node->children.empty()) return node;
+        ExprNode rebuilt{node->kind, 0.0, {}};
+        rebuilt.children.reserve(node->children.size());
+        bool allConstant = true;
+        for (const auto& child : node->children) {
+            rebuilt.children.push_back(simplify(child));
+            allConstant = allConstant && rebuilt.children.back()->isConstant();
+        }
+        if (allConstant) return foldConstant(rebuilt);
+
+        switch (rebuilt.kind) {
+            case ExprKind::Neg: case ExprKind::Add: case ExprKind::Sub: return simplifySum(rebuilt);
+            case ExprKind::Mul: return simplifyProduct(rebuilt);
+            case ExprKind::Div: return simplifyQuotient(rebuilt.children[0], rebuilt.children[1]);
+            case ExprKind::Pow: return simplifyPower(rebuilt.children[0], rebuilt.children[1]);
+            default: return simplifyFunction(rebuilt);
+        }
+    }
+
+    // Total order on trees: by kind, then constant value, then children left to right. 0 means
+    // structurally equal.
+    static int compare(const ExprNode& a, const ExprNode& b) {
+        if (a.kind != b.kind) return a.kind < b.kind ? -1 : 1;
+        if (a.kind == ExprKind::Constant) {
+            const bool aNan = std::isnan(a.value), bNan = std::isnan(b.value);
+            if (aNan || bNan) return (aNan == bNan) ? 0 : (aNan ? 1 : -1);
+            return (a.value < b.value) ? -1 : (a.value > b.value ? 1 : 0);
+        }
+        if (a.children.size() != b.children.size()) return a.children.size() < b.children.size() ? -1 : 1;
+        for (std::size_t i = 0; i < a.children.size(); ++i) {
+            if (const int c = compare(*a.children[i], *b.children[i])) return c;
+        }
+        return 0;
+    }
+
+    // True if the expression is defined (not NaN) for every finite x, ignoring overflow
+    static bool isTotal(const ExprNode& node) {
+        switch (node.kind) {
+            case ExprKind::Constant: return std::isfinite(node.value);
+            case ExprKind::VariableX: return true;
+            case ExprKind::Div: case ExprKind::Mod: case ExprKind::Tan: case ExprKind::Asin: case ExprKind::Acos:
+            case ExprKind::Acosh: case ExprKind::Atanh: case ExprKind::Log: case ExprKind::Log10: case ExprKind::Log2:
+            case ExprKind::Sqrt:
+                return false;
+            case ExprKind::Pow: {
+                const ExprNode& exponent = *node.children[1];
+                return exponent.isConstant() && isInteger(exponent.value) && exponent.value >= 0.0 && isTotal(*node.children[0]);
+            }
+            default:
+                return std::all_of(node.children.begin(), node.children.end(), [](const ExprPtr& c) { return isTotal(*c); });
+        }
+    }
+
+private:
+    struct Term {       // coefficient * factor inside a sum
+        double coefficient;
+        ExprPtr factor; // Never a constant
+    };
+
+    struct Factor {     // base ^ exponent inside a product
+        ExprPtr base;   // Never a constant, product or negation
+        double exponent; // An integer
+    };
+
+    static ExprPtr makeNode(ExprNode node) {
+        return std::make_shared<const ExprNode>(std::move(node));
+    }
+
+    static bool isInteger(double v) {
+        return std::isfinite(v) && std::trunc(v) == v;
+    }
+
+    static bool isConstant(const ExprPtr& node, double value) {
+        return node->isConstant() && node->value == value;
+    }
+
+    // Same rules as BytecodeCompiler's folding: exprtk's multiplication chains for integer powers
+    static ExprPtr foldConstant(const ExprNode& node) {
+        const double a = node.children[0]->value;
+        const double b = node.children.size() > 1 ? node.children[1]->value : 0.0;
+        if (node.kind == ExprKind::Pow && isInteger(b) && std::abs(b) <= 60.0) {
+            const unsigned int n = static_cast<unsigned int>(std::abs(b));
+            return makeConstant(b >= 0.0 ? bytecode_ops::integerPower(a, n) : 1.0 / bytecode_ops::integerPower(a, n));
+        }
+        const std::optional<OpCode> op = BytecodeCompiler::opcodeFor(node.kind);
+        return op ? makeConstant(bytecode_ops::apply(*op, a, b)) : makeNode(node);
+    }
+
+    // Polynomial degree in x, used to order the terms of a sum ("x^2+x+1"); 0 for anything else
+    static double degree(const ExprNode& node) {
+        switch (node.kind) {
+            case ExprKind::VariableX: return 1.0;
+            case ExprKind::Neg: return degree(*node.children[0]);
+            case ExprKind::Mul: return degree(*node.children[0]) + degree(*node.children[1]);
+            case ExprKind::Pow: return node.children[1]->isConstant() ? degree(*node.children[0]) * node.children[1]->value : 0.0;
+            default: return 0.0;
+        }
+    }
+
+    // --- Products ---
+
+    static void addFactor(std::vector<Factor>& factors, const ExprPtr& base, double exponent) {
+        for (Factor& factor : factors) {
+            // x^a * x^b -> x^(a+b) only for exponents of the same sign: x * x^-1 is NaN at 0, not 1
+            if ((factor.exponent > 0.0) == (exponent > 0.0) && compare(*factor.base, *base) == 0) {
+                factor.exponent += exponent;
+                return;
+            }
+        }
+        factors.push_back({base, exponent});
+    }
+
+    static void collectFactors(const ExprPtr& node, double& coefficient, std::vector<Factor>& factors) {
+        switch (node->kind) {
+            case ExprKind::Constant: coefficient *= node->value; return;
+            case ExprKind::Neg: coefficient = -coefficient; collectFactors(node->children[0], coefficient, factors); return;
+            case ExprKind::Mul:
+                collectFactors(node->children[0], coefficient, factors);
+                collectFactors(node->children[1], coefficient, factors);
+                return;
+            case ExprKind::Pow:
+                if (node->children[1]->isConstant() && isInteger(node->children[1]->value)) {
+                    addFactor(factors, node->children[0], node->children[1]->value);
+                    return;
+                }
+                break;
+            default: break;
+        }
+        addFactor(factors, node, 1.0);
+    }
+
+    // coefficient * f1^e1 * f2^e2 * ... as a left-nested chain, factors in canonical order
+    static ExprPtr buildProduct(double coefficient, std::vector<Factor> factors) {
+        factors.erase(std::remove_if(factors.begin(), factors.end(), [](const Factor& f) { return f.exponent == 0.0; }),
+                      factors.end()); // exprtk evaluates x^0 as 1 for every x
+        if (coefficient == 0.0 && std::all_of(factors.begin(), factors.end(), [](const Factor& f) { return isTotal(*f.base); })) {
+            return makeConstant(0.0);
+        }
+        std::sort(factors.begin(), factors.end(), [](const Factor& a, const Factor& b) {
+            const int c = compare(*a.base, *b.base);
+            return c != 0 ? c < 0 : a.exponent < b.exponent;
+        });
+
+        ExprPtr chain = (coefficient == 1.0 || coefficient == -1.0 || factors.empty()) ? nullptr : makeConstant(coefficient);
+        for (const Factor& factor : factors) {
+            ExprPtr term = (factor.exponent == 1.0) ? factor.base
+                                                    : makeBinary(ExprKind::Pow, factor.base, makeConstant(factor.exponent));
+            chain = chain ? makeBinary(ExprKind::Mul, chain, term) : term;
+        }
+        if (!chain) return makeConstant(coefficient);
+        return (coefficient == -1.0) ? makeUnary(ExprKind::Neg, chain) : chain;
+    }
+
+    static ExprPtr simplifyProduct(const ExprNode& node) {
+        double coefficient = 1.0;
+        std::vector<Factor> factors;
+        collectFactors(makeNode(node), coefficient, factors);
+        return buildProduct(coefficient, std::move(factors));
+    }
+
+    // (a*b)^n -> a^n * b^n and (a^m)^n -> a^(m*n) for integer n; x^1 -> x, x^0 -> 1
+    static ExprPtr simplifyPower(const ExprPtr& base, const ExprPtr& exponent) {
+        if (exponent->isConstant()) {
+            const double n = exponent->value;
+            if (n == 1.0) return base;
+            if (n == 0.0) return makeConstant(1.0);
+            if (isInteger(n) && (base->kind == ExprKind::Mul || base->kind == ExprKind::Neg || base->kind == ExprKind::Pow)) {
+                double coefficient = 1.0;
+                std::vector<Factor> factors;
+                collectFactors(base, coefficient, factors);
+                for (Factor& factor : factors) factor.exponent *= n;
+                const ExprPtr scaled = foldConstant(ExprNode{ExprKind::Pow, 0.0, {makeConstant(coefficient), exponent}});
+                return buildProduct(scaled->value, std::move(factors));
+            }
+        }
+        return makeBinary(ExprKind::Pow, base, exponent);
+    }
+
+    static ExprPtr simplifyQuotient(const ExprPtr& numerator, const ExprPtr& denominator) {
+        if (denominator->isConstant()) {
+            const double d = denominator->value;
+            if (d == 1.0) return numerator;
+            if (d == -1.0) return simplifySum(ExprNode{ExprKind::Neg, 0.0, {numerator}});
+            int exponentBits;
+            // x/2^k == x * 2^-k exactly, so the division joins the product's coefficient
+            if (std::isfinite(d) && std::abs(std::frexp(d, &exponentBits)) == 0.5 && std::isnormal(1.0 / d)) {
+                return simplifyProduct(ExprNode{ExprKind::Mul, 0.0, {numerator, makeConstant(1.0 / d)}});
+            }
+        }
+        if (numerator->kind == ExprKind::Sin && denominator->kind == ExprKind::Cos &&
+            compare(*numerator->children[0], *denominator->children[0]) == 0) {
+            return makeUnary(ExprKind::Tan, numerator->children[0]);
+        }
+        return makeBinary(ExprKind::Div, numerator, denominator);
+    }
+
+    // --- Sums ---
+
+    static void addTerm(std::vector<Term>& terms, double coefficient, const ExprPtr& factor) {
+        for (Term& term : terms) {
+            if (compare(*term.factor, *factor) == 0) {
+                term.coefficient += coefficient;
+                return;
+            }
+        }
+        terms.push_back({coefficient, factor});
+    }
+
+    // Splits a product into its numeric coefficient and the rest: "-3*x^2" -> (-3, x^2)
+    static std::pair<double, ExprPtr> splitCoefficient(const ExprPtr& node) {
+        if (node->kind != ExprKind::Mul && node->kind != ExprKind::Neg) return {1.0, node};
+        double coefficient = 1.0;
+        std::vector<Factor> factors;
+        collectFactors(node, coefficient, factors);
+        return {coefficient, buildProduct(1.0, std::move(factors))};
+    }
+
+    static void collectTerms(const ExprPtr& node, double sign, std::vector<Term>& terms, double& constant) {
+        switch (node->kind) {
+            case ExprKind::Constant: constant += sign * node->value; return;
+            case ExprKind::Neg: collectTerms(node->children[0], -sign, terms, constant); return;
+            case ExprKind::Add:
+                collectTerms(node->children[0], sign, terms, constant);
+                collectTerms(node->children[1], sign, terms, constant);
+                return;
+            case ExprKind::Sub:
+                collectTerms(node->children[0], sign, terms, constant);
+                collectTerms(node->children[1], -sign, terms, constant);
+                return;
+            default: {
+                const auto [coefficient, factor] = splitCoefficient(node);
+                if (factor->isConstant()) constant += sign * coefficient * factor->value;
+                else addTerm(terms, sign * coefficient, factor);
+                return;
+            }
+        }
+    }
+
+    // The argument u if node is f(u)^2, else nullptr
+    static ExprPtr squaredArgument(const ExprNode& node, ExprKind f) {
+        if (node.kind != ExprKind::Pow || !isConstant(node.children[1], 2.0) || node.children[0]->kind != f) return nullptr;
+        return node.children[0]->children[0];
+    }
+
+    // a*sin(u)^2 + a*cos(u)^2 -> a and a*cosh(u)^2 - a*sinh(u)^2 -> a
+    static void applyPythagoreanIdentities(std::vector<Term>& terms, double& constant) {
+        struct Identity { ExprKind first, second; double sign; };
+        static constexpr Identity identities[] = {{ExprKind::Sin, ExprKind::Cos, 1.0}, {ExprKind::Cosh, ExprKind::Sinh, -1.0}};
+        for (const Identity& identity : identities) {
+            for (std::size_t i = 0; i < terms.size(); ++i) {
+                const ExprPtr u = squaredArgument(*terms[i].factor, identity.first);
+                if (!u) continue;
+                for (std::size_t j = 0; j < terms.size(); ++j) {
+                    const ExprPtr v = squaredArgument(*terms[j].factor, identity.second);
+                    if (!v || compare(*u, *v) != 0 || terms[j].coefficient != identity.sign * terms[i].coefficient) continue;
+                    constant += terms[i].coefficient;
+                    terms.erase(terms.begin() + static_cast<std::ptrdiff_t>(std::max(i, j)));
+                    terms.erase(terms.begin() + static_cast<std::ptrdiff_t>(std::min(i, j)));
+                    i = static_cast<std::size_t>(-1); // Rescan: indices have shifted
+                    break;
+                }
+            }
+        }
+    }
+
+    static ExprPtr scaleTerm(double coefficient, const ExprPtr& factor) {
+        double inner = 1.0;
+        std::vector<Factor> factors;
+        collectFactors(factor, inner, factors);
+        return buildProduct(coefficient * inner, std::move(factors));
+    }
+
+    static ExprPtr simplifySum(const ExprNode& node) {
+        std::vector<Term> terms;
+        double constant = 0.0;
+        collectTerms(makeNode(node), 1.0, terms, constant);
+        applyPythagoreanIdentities(terms, constant);
+
+        terms.erase(std::remove_if(terms.begin(), terms.end(), [](const Term& t) { return t.coefficient == 0.0 && isTotal(*t.factor); }),
+                    terms.end());
+        std::stable_sort(terms.begin(), terms.end(), [](const Term& a, const Term& b) {
+            const double da = degree(*a.factor), db = degree(*b.factor);
+            return da != db ? da > db : compare(*a.factor, *b.factor) < 0;
+        });
+
+        // Lead with a positive term where there is one ("x-sin(x)", "1-x" rather than "-x+1")
+        ExprPtr sum;
+        if (!terms.empty() && terms.front().coefficient < 0.0) {
+            const auto positive = std::find_if(terms.begin(), terms.end(), [](const Term& t) { return t.coefficient > 0.0; });
+            if (positive != terms.end()) {
+                std::rotate(terms.begin(), positive, positive + 1);
+            } else if (constant > 0.0) {
+                sum = makeConstant(constant);
+                constant = 0.0;
+            }
+        }
+        for (const Term& term : terms) {
+            if (!sum) sum = scaleTerm(term.coefficient, term.factor);
+            else if (term.coefficient < 0.0) sum = makeBinary(ExprKind::Sub, sum, scaleTerm(-term.coefficient, term.factor));
+            else sum = makeBinary(ExprKind::Add, sum, scaleTerm(term.coefficient, term.factor));
+        }
+        if (!sum) return makeConstant(constant);
+        if (constant < 0.0) return makeBinary(ExprKind::Sub, sum, makeConstant(-constant));
+        if (constant != 0.0) return makeBinary(ExprKind::Add, sum, makeConstant(constant)); // Positive or NaN
+        return sum;
+    }
+
+    // --- Functions ---
+
+    // The positive form of a negated expression ("-u" -> u, "-2*x" -> 2*x), or nullptr
+    static ExprPtr negatedOperand(const ExprPtr& node) {
+        if (node->kind == ExprKind::Neg) return node->children[0];
+        if (node->kind != ExprKind::Mul) return nullptr;
+        const auto [coefficient, factor] = splitCoefficient(node);
+        return coefficient < 0.0 ? scaleTerm(-coefficient, factor) : nullptr;
+    }
+
+    static ExprPtr simplifyFunction(const ExprNode& node) {
+        const ExprPtr& arg = node.children[0];
+        switch (node.kind) {
+            case ExprKind::Sin: case ExprKind::Tan: case ExprKind::Asin: case ExprKind::Atan: case ExprKind::Sinh:
+            case ExprKind::Tanh: case ExprKind::Asinh: case ExprKind::Atanh: case ExprKind::Cbrt:
+                if (const ExprPtr positive = negatedOperand(arg)) { // Odd: f(-u) -> -f(u)
+                    return simplifySum(ExprNode{ExprKind::Neg, 0.0, {makeUnary(node.kind, positive)}});
+                }
+                break;
+            case ExprKind::Cos: case ExprKind::Cosh: case ExprKind::Abs:
+                if (const ExprPtr positive = negatedOperand(arg)) { // Even: f(-u) -> f(u)
+                    return simplifyFunction(ExprNode{node.kind, 0.0, {positive}});
+                }
+                if (arg->kind == ExprKind::Abs) return simplifyFunction(ExprNode{node.kind, 0.0, {arg->children[0]}});
+                break;
+            case ExprKind::Sqrt:
+                if (arg->kind == ExprKind::Pow && isConstant(arg->children[1], 2.0)) return makeUnary(ExprKind::Abs, arg->children[0]);
+                break;
+            case ExprKind::Min: case ExprKind::Max:
+                if (compare(*arg, *node.children[1]) == 0) return arg;
+                break;
+            default: break;
+        }
+        return makeNode(node);
+    }
+};
+
+// Simplified form of a tree; see ExpressionSimplifier.
+inline ExprPtr simplifyExpression(const ExprPtr& root) {
+    return ExpressionSimplifier::simplify(root);
+}
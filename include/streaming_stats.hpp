@@ -0,0 +1,425 @@
+#pragma once
+
+#include "parallel_for.hpp"
+#include "series_accumulators.hpp" // NeumaierSum
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <span>
+#include <utility>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Summary statistics of a stream of numbers in one pass and bounded memory: count, sum, mean and the
+// central moments up to the fourth (Welford's update, merged with Pebay's formulas), min and max,
+// and quantiles from a KLL sketch (Karnin, Lang and Liberty), whose rank error does not depend on
+// the length of the stream. The text is read in fixed blocks cut at separators; each thread scans
+// whole blocks with its own accumulators, and the per-block results are merged in stream order, so
+// the statistics do not depend on the thread count. The scanner classifies 64 bytes at a time into
+// a separator bit mask (SSE2) and walks the token boundaries with bit tricks; std::from_chars
+// converts the tokens. Memory is the blocks in flight plus a few thousand doubles of sketch.
+
+// Count, mean and sums of squared, cubed and fourth-power deviations from the mean, plus min and max
+class RunningMoments {
+public:
+    void add(double x) {
+        const double previous = static_cast<double>(m_count);
+        ++m_count;
+        const double n = static_cast<double>(m_count);
+        const double delta = x - m_mean, deltaN = delta / n, deltaN2 = deltaN * deltaN, term = delta * deltaN * previous;
+        m_mean += deltaN;
+        m_m4 += term * deltaN2 * (n * n - 3.0 * n + 3.0) + 6.0 * deltaN2 * m_m2 - 4.0 * deltaN * m_m3;
+        m_m3 += term * deltaN * (n - 2.0) - 3.0 * deltaN * m_m2;
+        m_m2 += term;
+        m_min = std::min(m_min, x);
+        m_max = std::max(m_max, x);
+    }
+
+    void merge(const RunningMoments& other) {
+        if (other.m_count == 0) return;
+        if (m_count == 0) {
+            *this = other;
+            return;
+        }
+        const double a = static_cast<double>(m_count), b = static_cast<double>(other.m_count), n = a + b;
+        const double delta = other.m_mean - m_mean, delta2 = delta * delta;
+        const double m2 = m_m2 + other.m_m2 + delta2 * a * b / n;
+        const double m3 = m_m3 + other.m_m3 + delta * delta2 * a * b * (a - b) / (n * n) + 3.0 * delta * (a * other.m_m2 - b * m_m2) / n;
+        const double m4 = m_m4 + other.m_m4 + delta2 * delta2 * a * b * (a * a - a * b + b * b) / (n * n * n) +
+                          6.0 * delta2 * (a * a * other.m_m2 + b * b * m_m2) / (n * n) + 4.0 * delta * (a * other.m_m3 - b * m_m3) / n;
+        m_mean += delta * b / n;
+        m_m2 = m2;
+        m_m3 = m3;
+        m_m4 = m4;
+        m_count += other.m_count;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    std::uint64_t count() const { return m_count; }
+    double mean() const { return m_count > 0 ? m_mean : NAN; }
+    double min() const { return m_count > 0 ? m_min : NAN; }
+    double max() const { return m_count > 0 ? m_max : NAN; }
+    // With Bessel's correction: the unbiased estimate of the variance of the population sampled
+    double sampleVariance() const { return m_count > 1 ? m_m2 / static_cast<double>(m_count - 1) : NAN; }
+    double skewness() const { return m_m2 > 0.0 ? std::sqrt(static_cast<double>(m_count)) * m_m3 / std::pow(m_m2, 1.5) : NAN; }
+    // 0 for a normal distribution
+    double excessKurtosis() const { return m_m2 > 0.0 ? static_cast<double>(m_count) * m_m4 / (m_m2 * m_m2) - 3.0 : NAN; }
+
+private:
+    std::uint64_t m_count = 0;
+    double m_mean = 0.0, m_m2 = 0.0, m_m3 = 0.0, m_m4 = 0.0;
+    double m_min = INFINITY, m_max = -INFINITY;
+};
+
+// KLL quantile sketch. Level h holds values that each stand for 2^(shift + h) of the stream; a full
+// level is sorted and every other value, starting at a random one of the first two, moves up a
+// level. Level capacities shrink geometrically (by 2/3) below the top one, which holds K values.
+// Once there are MAX_LEVELS levels, the lowest one is replaced by sampling instead of growing a new
+// top: one value is kept at random out of every 2^shift that arrive, so most of a long stream is
+// never sorted. Until the first compaction the sketch holds the whole stream and is exact.
+class QuantileSketch {
+public:
+    static constexpr std::size_t K = 512;         // Capacity of the top level
+    static constexpr std::size_t MIN_WIDTH = 8;   // Capacity floor of the lower levels
+    static constexpr std::size_t MAX_LEVELS = 6;  // Compacted levels; the lowest holds K (2/3)^5 = 67 values
+
+    explicit QuantileSketch(std::uint64_t seed = 0) : m_random(seed), m_levels(1) {}
+
+    void add(double value) {
+        ++m_count;
+        if (m_shift == 0) {
+            m_levels[0].push_back(value);
+            if (++m_stored >= m_capacity) compress();
+        } else {
+            sample(value, 1);
+        }
+    }
+
+    void merge(const QuantileSketch& other) {
+        while (m_shift < other.m_shift) raiseSampling();
+        const std::size_t offset = m_shift - other.m_shift; // Levels of other that this samples instead
+        if (m_levels.size() + offset < other.m_levels.size()) {
+            m_levels.resize(other.m_levels.size() - offset);
+            updateCapacity();
+        }
+        for (std::size_t h = offset; h < other.m_levels.size(); ++h) {
+            m_levels[h - offset].insert(m_levels[h - offset].end(), other.m_levels[h].begin(), other.m_levels[h].end());
+            m_stored += other.m_levels[h].size();
+        }
+        m_count += other.m_count;
+        // Sampling may compress and raise m_shift, which only makes these weights smaller than a group
+        for (std::size_t h = 0; h < std::min(offset, other.m_levels.size()); ++h) {
+            for (const double value : other.m_levels[h]) sample(value, std::uint64_t(1) << (other.m_shift + h));
+        }
+        if (other.m_sampleWeight > 0) sample(other.m_sample, other.m_sampleWeight);
+        compress();
+    }
+
+    std::uint64_t count() const { return m_count; }
+    bool exact() const { return m_shift == 0 && m_levels.size() == 1; }
+    // Rank error (as a fraction of the count) not exceeded with 99% confidence, fitted by Apache
+    // DataSketches for this compaction scheme; 0 while the sketch is exact
+    static constexpr double ERROR_SCALE = 2.296, ERROR_EXPONENT = 0.9723;
+    double rankError() const { return exact() ? 0.0 : ERROR_SCALE / std::pow(static_cast<double>(K), ERROR_EXPONENT); }
+
+    // The value of rank ceil(fraction * count) for each fraction in [0, 1]
+    std::vector<double> quantiles(std::span<const double> fractions) const {
+        std::vector<std::pair<double, std::uint64_t>> weighted;
+        weighted.reserve(m_stored + 1);
+        for (std::size_t h = 0; h < m_levels.size(); ++h) {
+            for (const double value : m_levels[h]) weighted.emplace_back(value, std::uint64_t(1) << (m_shift + h));
+        }
+        if (m_sampleWeight > 0) weighted.emplace_back(m_sample, m_sampleWeight);
+        std::sort(weighted.begin(), weighted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<double> result;
+        for (const double fraction : fractions) {
+            if (weighted.empty()) {
+                result.push_back(NAN);
+                continue;
+            }
+            const double target = std::max(1.0, std::ceil(fraction * static_cast<double>(m_count)));
+            std::uint64_t rank = 0;
+            auto it = weighted.begin();
+            for (; it + 1 != weighted.end(); ++it) {
+                rank += it->second;
+                if (static_cast<double>(rank) >= target) break;
+            }
+            result.push_back(it->first);
+        }
+        return result;
+    }
+
+private:
+    std::uint64_t m_random; // splitmix64 state
+    std::vector<std::vector<double>> m_levels;
+    std::uint64_t m_count = 0;
+    std::vector<std::size_t> m_levelCapacity{K};
+    std::size_t m_stored = 0, m_capacity = K;
+    std::size_t m_shift = 0;          // Levels below m_levels[0] that sampling stands in for
+    double m_sample = 0.0;            // The value kept so far out of the current group
+    std::uint64_t m_sampleWeight = 0; // Stream values the current group holds; a group is complete at 2^m_shift
+
+    void updateCapacity() {
+        m_levelCapacity.resize(m_levels.size());
+        m_capacity = 0;
+        double width = static_cast<double>(K);
+        for (std::size_t h = m_levels.size(); h-- > 0; width *= 2.0 / 3.0) {
+            m_levelCapacity[h] = std::max(MIN_WIDTH, static_cast<std::size_t>(width));
+            m_capacity += m_levelCapacity[h];
+        }
+    }
+
+    std::uint64_t nextRandom() {
+        std::uint64_t z = (m_random += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // True with probability numerator / denominator
+    bool chance(std::uint64_t numerator, std::uint64_t denominator) {
+        return static_cast<double>(nextRandom() >> 11) * 0x1p-53 * static_cast<double>(denominator) < static_cast<double>(numerator);
+    }
+
+    // Adds a value standing for weight < 2^m_shift stream values to the current group. The group's
+    // value stays each member's with probability proportional to its weight; a group that would
+    // overflow keeps one of the two candidates for the full group and the other for the remainder,
+    // with the odds that leave each one's expected weight unchanged.
+    void sample(double value, std::uint64_t weight) {
+        const std::uint64_t full = std::uint64_t(1) << m_shift;
+        const std::uint64_t total = m_sampleWeight + weight;
+        if (total <= full) {
+            m_sampleWeight = total;
+            if (chance(weight, total)) m_sample = value;
+            if (total < full) return;
+            m_sampleWeight = 0;
+            m_levels[0].push_back(m_sample);
+        } else {
+            const std::uint64_t rest = total - full;
+            const bool keepNew = chance(full - m_sampleWeight, 2 * full - total); // The new value becomes the full group
+            m_levels[0].push_back(keepNew ? value : m_sample);
+            if (!keepNew) m_sample = value; // Otherwise the old candidate carries the remainder
+            m_sampleWeight = rest;
+        }
+        if (++m_stored >= m_capacity) compress();
+    }
+
+    // Sorts level h and moves every other value of it up a level
+    void compact(std::size_t h) {
+        if (h + 1 == m_levels.size()) {
+            m_levels.emplace_back();
+            updateCapacity();
+        }
+        std::vector<double>& level = m_levels[h];
+        std::sort(level.begin(), level.end());
+        const std::size_t odd = level.size() % 2; // An odd value out stays behind
+        std::vector<double>& above = m_levels[h + 1];
+        for (std::size_t i = odd + (nextRandom() & 1); i < level.size(); i += 2) above.push_back(level[i]);
+        m_stored -= (level.size() - odd) / 2;
+        level.resize(odd);
+    }
+
+    // Compacts the lowest level into the next, hands its odd value out to the sampler, and from
+    // then on samples one value out of twice as many
+    void raiseSampling() {
+        compact(0);
+        ++m_shift;
+        std::vector<double> rest = std::move(m_levels[0]);
+        m_levels.erase(m_levels.begin());
+        m_stored -= rest.size();
+        updateCapacity();
+        for (const double value : rest) sample(value, std::uint64_t(1) << (m_shift - 1));
+    }
+
+    // Compacts the lowest full level until the sketch fits its capacity again
+    void compress() {
+        while (m_stored >= m_capacity) {
+            std::size_t h = 0;
+            while (m_levels[h].size() < m_levelCapacity[h]) ++h;
+            compact(h);
+            if (m_levels.size() > MAX_LEVELS) raiseSampling();
+        }
+    }
+};
+
+struct StreamStatistics {
+    RunningMoments moments;
+    NeumaierSum sum;
+    QuantileSketch sketch;
+    std::uint64_t skipped = 0; // Tokens that are not finite numbers
+    std::uint64_t bytes = 0;
+
+    explicit StreamStatistics(std::uint64_t seed = 0) : sketch(seed) {}
+
+    void add(double value) {
+        moments.add(value);
+        sum.add(value);
+        sketch.add(value);
+    }
+
+    void merge(const StreamStatistics& other) {
+        moments.merge(other.moments);
+        sum.merge(other.sum);
+        sketch.merge(other.sketch);
+        skipped += other.skipped;
+        bytes += other.bytes;
+    }
+};
+
+namespace streaming_stats_detail {
+    constexpr std::size_t BLOCK_BYTES = std::size_t(1) << 22; // Text scanned per task: 4 MB
+
+    // Numbers are separated by whitespace (any control character, in fact), commas and semicolons
+    constexpr bool isSeparator(unsigned char c) { return c <= ' ' || c == ',' || c == ';'; }
+
+    // Bit i set where block[i] is a separator, for the first count <= 64 bytes; bits from count on are set
+    inline std::uint64_t separatorMask(const char* block, std::size_t count) {
+        std::uint64_t mask = 0;
+#if defined(__SSE2__)
+        if (count == 64) {
+            const __m128i space = _mm_set1_epi8(' '), comma = _mm_set1_epi8(','), semicolon = _mm_set1_epi8(';');
+            for (int part = 0; part < 4; ++part) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * part));
+                const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, space), bytes); // Unsigned bytes <= ' '
+                const __m128i hits = _mm_or_si128(control, _mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, semicolon)));
+                mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(hits))) << (16 * part);
+            }
+            return mask;
+        }
+#endif
+        for (std::size_t i = 0; i < 64; ++i) {
+            if (i >= count || isSeparator(static_cast<unsigned char>(block[i]))) mask |= std::uint64_t(1) << i;
+        }
+        return mask;
+    }
+
+    constexpr std::array<double, 23> EXACT_POWERS_OF_TEN = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    constexpr std::uint64_t EXACT_MANTISSA_LIMIT = std::uint64_t(1) << 53;
+
+    // Appends the digits at p to mantissa, eight at a time where it can (SWAR: one 64-bit word holds
+    // eight characters, checked and combined with a few multiplies), and returns the end of the digits
+    inline const char* readDigits(const char* p, const char* last, std::uint64_t& mantissa) {
+        if constexpr (std::endian::native == std::endian::little) {
+            while (last - p >= 8) {
+                std::uint64_t word;
+                std::memcpy(&word, p, 8);
+                if (((word & 0xF0F0F0F0F0F0F0F0ull) | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) != 0x3333333333333333ull) break;
+                word -= 0x3030303030303030ull;
+                word = word * 10 + (word >> 8); // Pairs of digits
+                word = ((word & 0x000000FF000000FFull) * (100 + (1000000ull << 32)) + ((word >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32))) >> 32;
+                mantissa = mantissa * 100000000 + word; // Wraps past 19 digits, which the caller rejects
+                p += 8;
+            }
+        }
+        for (; p < last && static_cast<unsigned>(*p - '0') < 10; ++p) mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+        return p;
+    }
+
+    // Clinger's fast path: a decimal of at most 19 significant digits whose digits fit 2^53 and whose
+    // power of ten is exact in a double rounds correctly with one multiplication or division.
+    // False for anything else, which std::from_chars then converts.
+    inline bool parseShortDecimal(const char* p, const char* last, double& value) {
+        const bool negative = p < last && *p == '-';
+        if (p < last && (*p == '-' || *p == '+')) ++p;
+        std::uint64_t mantissa = 0;
+        const char* digitsStart = p;
+        p = readDigits(p, last, mantissa);
+        std::ptrdiff_t digits = p - digitsStart, exponent = 0;
+        if (p < last && *p == '.') {
+            const char* fractionStart = ++p;
+            p = readDigits(p, last, mantissa);
+            digits += p - fractionStart;
+            exponent = -(p - fractionStart);
+        }
+        if (digits == 0 || digits > 19) return false;
+        if (p < last && (*p == 'e' || *p == 'E')) {
+            const bool negativeExponent = p + 1 < last && p[1] == '-';
+            p += (p + 1 < last && (p[1] == '-' || p[1] == '+')) ? 2 : 1;
+            const char* exponentStart = p;
+            std::ptrdiff_t written = 0;
+            for (; p < last && static_cast<unsigned>(*p - '0') < 10 && p - exponentStart < 4; ++p) written = written * 10 + (*p - '0');
+            if (p == exponentStart) return false;
+            exponent += negativeExponent ? -written : written;
+        }
+        if (p != last || mantissa > EXACT_MANTISSA_LIMIT || exponent < -22 || exponent > 22) return false;
+        const double magnitude = exponent < 0 ? static_cast<double>(mantissa) / EXACT_POWERS_OF_TEN[static_cast<std::size_t>(-exponent)]
+                                              : static_cast<double>(mantissa) * EXACT_POWERS_OF_TEN[static_cast<std::size_t>(exponent)];
+        value = negative ? -magnitude : magnitude;
+        return true;
+    }
+
+    inline void addToken(const char* first, const char* last, StreamStatistics& statistics) {
+        double value = 0.0;
+        if (parseShortDecimal(first, last, value)) {
+            statistics.add(value);
+            return;
+        }
+        if (*first == '+' && last - first > 1) ++first; // from_chars takes no plus sign
+        const std::from_chars_result parsed = std::from_chars(first, last, value);
+        if (parsed.ec == std::errc() && parsed.ptr == last && std::isfinite(value)) statistics.add(value);
+        else ++statistics.skipped; // Words, "nan", "inf" and numbers beyond the double range
+    }
+
+    // Adds every number of text, which must not end inside a number
+    inline void scanNumbers(std::span<const char> text, StreamStatistics& statistics) {
+        const char* data = text.data();
+        std::size_t tokenStart = 0;
+        std::uint64_t previousSeparator = 1; // The text starts as if after a separator
+        for (std::size_t base = 0; base < text.size(); base += 64) {
+            const std::uint64_t separators = separatorMask(data + base, std::min<std::size_t>(64, text.size() - base));
+            const std::uint64_t shifted = (separators << 1) | previousSeparator;
+            std::uint64_t boundaries = (~separators & shifted) | (separators & ~shifted); // Token starts and token ends
+            previousSeparator = separators >> 63;
+            while (boundaries != 0) {
+                const std::size_t i = base + static_cast<std::size_t>(std::countr_zero(boundaries));
+                boundaries &= boundaries - 1;
+                if ((separators >> (i - base)) & 1) addToken(data + tokenStart, data + i, statistics);
+                else tokenStart = i;
+            }
+        }
+        if (previousSeparator == 0) addToken(data + tokenStart, data + text.size(), statistics);
+    }
+}
+
+// Reads input to its end, BLOCK_BYTES per task and up to threadCount tasks at a time
+inline StreamStatistics streamStatistics(std::istream& input, unsigned threadCount) {
+    using namespace streaming_stats_detail;
+    threadCount = std::max(threadCount, 1u);
+    StreamStatistics total;
+    std::vector<std::vector<char>> blocks(threadCount);
+    std::vector<char> carry; // The unfinished number at the end of the last block
+    std::uint64_t blockIndex = 0;
+    while (input) {
+        std::size_t batch = 0;
+        for (; batch < threadCount && input; ++batch) {
+            std::vector<char>& block = blocks[batch];
+            block.assign(carry.begin(), carry.end());
+            block.resize(carry.size() + BLOCK_BYTES);
+            input.read(block.data() + carry.size(), static_cast<std::streamsize>(BLOCK_BYTES));
+            block.resize(carry.size() + static_cast<std::size_t>(input.gcount()));
+            total.bytes += static_cast<std::uint64_t>(input.gcount());
+            std::size_t cut = block.size();
+            if (input) { // More follows: hold back what comes after the last separator
+                while (cut > 0 && !isSeparator(static_cast<unsigned char>(block[cut - 1]))) --cut;
+            }
+            carry.assign(block.begin() + static_cast<std::ptrdiff_t>(cut), block.end());
+            block.resize(cut);
+        }
+        std::vector<StreamStatistics> partial;
+        partial.reserve(batch);
+        for (std::size_t i = 0; i < batch; ++i) partial.emplace_back(blockIndex + i);
+        parallelFor(batch, threadCount, [&](std::size_t i) { scanNumbers(blocks[i], partial[i]); });
+        for (const StreamStatistics& part : partial) total.merge(part);
+        blockIndex += batch;
+    }
+    return total;
+}
@@ -1,6 +1,30 @@
+#include "../include/CLI11.hpp"
 #include "../include/core.hpp"
-int main(){
-  Calculator sci;
+#include <map>
+int main(int argc, char** argv){
+  CLI::App app{"mathd - terminal graphing calculator"};
+  EvalBackend backend = EvalBackend::Auto;
+  const std::map<std::string, EvalBackend> backends{
+    {"auto", EvalBackend::Auto}, {"exprtk", EvalBackend::Exprtk},
+    {"bytecode", EvalBackend::Bytecode}, {"jit", EvalBackend::Jit}};
+  app.add_option("-b,--backend", backend, "Expression evaluation backend (default: auto, JIT for long loops)")
+     ->transform(CLI::CheckedTransformer(backends, CLI::ignore_case).description(""))
+     ->option_text("{auto,exprtk,bytecode,jit}");
+  Precision precision = Precision::Double;
+  const std::map<std::string, Precision> precisions{
+    {"float", Precision::Float}, {"double", Precision::Double},
+    {"long", Precision::LongDouble}, {"quad", Precision::Quad}, {"multi", Precision::Multi}};
+  app.add_option("-p,--precision", precision, "Scalar type of expressions, finite series and graphs (default: double)")
+     ->transform(CLI::CheckedTransformer(precisions, CLI::ignore_case).description(""))
+     ->option_text("{float,double,long,quad,multi}");
+  int digits = 0;
+  app.add_option("-d,--digits", digits, "Significant digits of scientific-mode results (default: 0 = all the precision keeps)")
+     ->check(CLI::NonNegativeNumber);
+  unsigned threads = 0;
+  app.add_option("-j,--threads", threads, "Threads used to sample graphs (default: 0 = all hardware threads)");
+  CLI11_PARSE(app, argc, argv);
+
+  Calculator sci(backend, threads, precision, digits);
   sci.run();
   return 0;
 }
@@ -0,0 +1,9 @@
+#include "../include/precision_engine.hpp"
+
+// The one place the calculator's precision engines, and exprtk over their scalar types, are compiled
+template class PrecisionEngine<float>;
+template class PrecisionEngine<long double>;
+#ifdef MATHD_QUADMATH
+template class PrecisionEngine<Float128>;
+#endif
+template class PrecisionEngine<MultiPrecisionFloat>;